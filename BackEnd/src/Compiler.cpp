@@ -6,6 +6,7 @@
 #include <stdio.h>
 #include "Settings.h"
 #include "StringsUtils.h"
+#include "Fiofunctions.h"
 
 #include "Logging.h"
 
@@ -25,20 +26,78 @@ void start()
 
   db::initTranslator(&translator);
 
-  FILE *source = fopen(settings.source, "r");
+  translator.status.optimizationLevel = settings.optimizationLevel;
+  translator.status.threadCount       = settings.threadCount;
+
+  FILE *source = openStream(settings.source, "r");
   if (!source) { db::removeTranslator(&translator); return; }
 
   db::loadTranslator(&translator, source);
 
-  fclose(source);
+  closeStream(source);
 
   db:: dumpTree(&translator.grammar, 0, getLogFile());
 
-  FILE *target = fopen(settings.target, "w");
+  if (settings.isObject)
+    {
+      FILE *target = openStream(settings.target, "wb");
+      if (!target) { db::removeTranslator(&translator); return; }
+
+      FILE *listing = (settings.listing ? openStream(settings.listing, "w") : nullptr);
+
+      db::translateObject(&translator, target, listing, &error);
+
+      if (listing) closeStream(listing);
+      closeStream(target);
+
+      // Partial binary can`t be loaded by VM, so it isn`t left
+      if (error)
+        {
+          if (!isStandardStream(settings.target)) remove(settings.target);
+          if (settings.listing && !isStandardStream(settings.listing)) remove(settings.listing);
+        }
+
+      db::removeTranslator(&translator);
+      return;
+    }
+
+  FILE *target = openStream(settings.target, "w");
   if (!target) { db::removeTranslator(&translator); return; }
 
+  db::AsmCache cache{};
+  db::initAsmCache(&cache);
+
+  if (settings.cache)
+    {
+      FILE *cacheFile = openStream(settings.cache, "r");
+      if (cacheFile)
+        {
+          db::loadAsmCache(&cache, cacheFile);
+          closeStream(cacheFile);
+        }
+
+      translator.status.cache = &cache;
+    }
+
   db::translate(&translator, target, &error);
 
-  fclose(target);
+  closeStream(target);
+
+  if (settings.cache && !error)
+    {
+      FILE *log = getLogFile();
+      if (log)
+        fprintf(log, "<pre>AsmCache: %zu hits, %zu misses</pre>\n",
+                cache.hits, cache.misses);
+
+      FILE *cacheFile = openStream(settings.cache, "w");
+      if (cacheFile)
+        {
+          db::saveAsmCache(&cache, cacheFile);
+          closeStream(cacheFile);
+        }
+    }
+
+  db::destroyAsmCache(&cache);
   db::removeTranslator(&translator);
 }
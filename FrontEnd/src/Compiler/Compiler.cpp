@@ -6,6 +6,7 @@
 #include <stdio.h>
 #include "Settings.h"
 #include "StringsUtils.h"
+#include "Fiofunctions.h"
 
 #include "Logging.h"
 
@@ -34,10 +35,14 @@ void start()
 
   db:: dumpTree(&translator.grammar, 0, getLogFile());
 
-  FILE *target = fopen(settings.target, "w");
+  FILE *target = openStream(settings.target, "w");
   if (!target) { db::removeTranslator(&translator); return; }
+  if (settings.isBinary)
+    translator.status.format =
+      settings.isPacked ? db::TreeFormat::Packed : db::TreeFormat::Binary;
+
   db::saveTranslator(&translator, target);
 
-  fclose(target);
+  closeStream(target);
   db::removeTranslator(&translator);
 }
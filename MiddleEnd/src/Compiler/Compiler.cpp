@@ -1,11 +1,13 @@
 #include "Compiler.h"
 #include "Translator.h"
+#include "PassManager.h"
 
 #include "Tree.h"
 
 #include <stdio.h>
 #include "Settings.h"
 #include "StringsUtils.h"
+#include "Fiofunctions.h"
 
 #include "Logging.h"
 
@@ -21,33 +23,60 @@ void start()
 
   int error = 0;
 
+  db::PassManager passManager{};
+
+  const char *pipeline =
+    (settings.passes ? settings.passes : db::LEVEL_PIPELINES[settings.optimizationLevel]);
+
+  db::initPassManager(&passManager, pipeline, &error);
+  if (error) return;
+
   db::Translator translator{};
 
   db::initTranslator(&translator);
 
-  FILE *source = fopen(settings.source, "r");
-  if (!source) { db::removeTranslator(&translator); return; }
+  FILE *source = openStream(settings.source, "r");
+  if (!source)
+    {
+      db::removeTranslator(&translator);
+      db::destroyPassManager(&passManager);
+      return;
+    }
 
   db::loadTranslator(&translator, source);
 
-  fclose(source);
+  closeStream(source);
 
-  FILE *target = fopen(settings.target, "w");
-  if (!target) { db::removeTranslator(&translator); return; }
+  FILE *target = openStream(settings.target, "w");
+  if (!target)
+    {
+      db::removeTranslator(&translator);
+      db::destroyPassManager(&passManager);
+      return;
+    }
+
+  db::runPasses(&passManager, &translator, &error);
+
+  FILE *log = getLogFile();
+  if (log) db::dumpPassReport(&passManager, log);
+
+  db::destroyPassManager(&passManager);
 
-  db::simplyGrammar(&translator, &error);
   if (error)
     {
-      fclose(target);
+      closeStream(target);
       db::removeTranslator(&translator);
       return;
     }
 
-  db:: dumpTree(&translator.grammar, 0, getLogFile());
+  db:: dumpTree(&translator.grammar, 0, log);
+
+  if (settings.isBinary)
+    translator.status.format =
+      settings.isPacked ? db::TreeFormat::Packed : db::TreeFormat::Binary;
 
-  rewind(target);
   db::saveTranslator(&translator, target);
 
-  fclose(target);
+  closeStream(target);
   db::removeTranslator(&translator);
 }
@@ -7,6 +7,13 @@ const char * const DEFAULT_TARGET_FILE_NAME = "dis_main.kt";
 /// Name of source file if didn`t input anything
 const char * const DEFAULT_SOURCE_FILE_NAME = "syntax.std";
 
+/// Level of optimizations if didn`t input -O
+const int DEFAULT_OPTIMIZATION_LEVEL = 2;
+const int     MAX_OPTIMIZATION_LEVEL = 2;
+
+/// Count of threads of code generation if didn`t input -threads, 0 is count of processors
+const int DEFAULT_THREAD_COUNT = 0;
+
 enum class Save {
   TEXT,
   TEX,
@@ -15,6 +22,14 @@ enum class Save {
 struct Settings {
   char       *source;
   char       *target;
+  char       *cache;  ///< File of AsmCache or nullptr
+  char       *passes; ///< Pipeline of MiddleEnd or nullptr for default
+  char       *listing; ///< Listing of binary of VM or nullptr
+  int         optimizationLevel; ///< -O0, -O1 or -O2
+  int         threadCount; ///< Workers of BackEnd, 0 is count of processors
+  bool        isBinary; ///< Save tree in compact binary format
+  bool        isPacked; ///< Compress binary tree
+  bool        isObject; ///< Save binary of VM instead of assembler text
   const char *programName;
 };
 
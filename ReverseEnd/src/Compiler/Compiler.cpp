@@ -6,6 +6,7 @@
 #include <stdio.h>
 #include "Settings.h"
 #include "StringsUtils.h"
+#include "Fiofunctions.h"
 
 #include "Logging.h"
 
@@ -25,22 +26,22 @@ void start()
 
   db::initTranslator(&translator);
 
-  FILE *source = fopen(settings.source, "r");
+  FILE *source = openStream(settings.source, "r");
   if (!source) { db::removeTranslator(&translator); return; }
 
   db::loadTranslator(&translator, source, &error);
 
-  fclose(source);
+  closeStream(source);
 
   if (error) { db::removeTranslator(&translator); return; }
 
   db:: dumpTree(&translator.grammar, 0, getLogFile());
 
-  FILE *target = fopen(settings.target, "w");
+  FILE *target = openStream(settings.target, "w");
   if (!target) { db::removeTranslator(&translator); return; }
 
   db::disassemblerGrammar(&translator, target, &error);
 
-  fclose(target);
+  closeStream(target);
   db::removeTranslator(&translator);
 }
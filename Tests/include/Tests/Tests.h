@@ -0,0 +1,98 @@
+#pragma once
+
+#include <stddef.h>
+#include "Translator.h"
+
+namespace db {
+
+  /// Counters of checks of all tests
+  struct TestStatus {
+    size_t passed;
+    size_t failed;
+  };
+
+  /// Count check, failed one is written to stderr with its place
+  /// @return Value of condition
+  bool checkTest(TestStatus *status, bool condition, const char *text, const char *file, int line);
+
+  /// Parse program like FrontEnd, then load its tree like the next stage does
+  /// @param [out] translator Initialized translator
+  /// @return false if program has errors
+  bool parseProgram(Translator *translator, const char *source);
+
+  /// Run pipeline of MiddleEnd like -passes, see PassManager.h
+  /// @note Empty pipeline keeps tree as it is
+  bool runPipeline(Translator *translator, const char *pipeline);
+
+  /// Save tree and load it in target like the next stage does
+  /// @param [out] target Initialized translator
+  bool passTree(Translator *source, Translator *target);
+
+  /// Asm of BackEnd with optimization level
+  /// @return Text in heap or nullptr if translation failed
+  char *translateProgram(Translator *translator, int optimizationLevel);
+
+  /// Binary of VM like -object of BackEnd
+  /// @param [out] size Count of bytes
+  /// @return Binary in heap or nullptr if translation failed
+  char *translateProgramObject(Translator *translator, int optimizationLevel, size_t *size);
+
+  /// Program through all stages with pipeline of MiddleEnd and level of BackEnd
+  /// @return Asm in heap or nullptr if some stage failed
+  char *compileProgram(const char *source, const char *pipeline, int optimizationLevel);
+
+  /// Output of asm on model of VM, real number is fixed point with 4 digits after point
+  /// @param input Numbers which are read by IN, 0 is read after them
+  /// @return Text in heap, numbers are followed by spaces, or nullptr if asm can`t be run
+  char *runAsm(const char *text, const number_t *input, size_t inputSize);
+
+  /// Output of program through all stages, see compileProgram and runAsm
+  char *runProgram(
+                   const char *source,
+                   const char *pipeline,
+                   int optimizationLevel,
+                   const number_t *input,
+                   size_t inputSize
+                  );
+
+  /// Copy next line of asm which isn`t empty, comment is removed
+  /// @param [out] line Buffer of size bytes, longer line is cut
+  /// @return false at the end of text
+  bool readAsmLine(const char **text, char *line, size_t size);
+
+  /// First statement in preorder or nullptr
+  Token searchStatement(Token token, statement_t statement);
+
+  /// First declaration of variable or value with name or nullptr
+  Token searchDeclaration(Token token, const char *name);
+
+  void testConstantPropagation(TestStatus *status);
+
+  void testEvaluator(TestStatus *status);
+
+  void testPeephole(TestStatus *status);
+
+  void testTranslator(TestStatus *status);
+
+  void testRegisterAllocation(TestStatus *status);
+
+  void testObjectCode(TestStatus *status);
+
+  void testAsmCache(TestStatus *status);
+
+  void testTailCalls(TestStatus *status);
+
+  void testLoopInvariants(TestStatus *status);
+
+  void testCommonSubexpressions(TestStatus *status);
+
+  void testDeadCode(TestStatus *status);
+
+  void testInliner(TestStatus *status);
+
+  void testStrengthReduction(TestStatus *status);
+
+}
+
+#define CHECK(STATUS, CONDITION)                                        \
+  db::checkTest(STATUS, CONDITION, #CONDITION, __FILE__, __LINE__)
@@ -0,0 +1,43 @@
+#pragma once
+
+/// Name of default directory for files
+const char * const DEFAULT_DIRECTORY = "../resources/";
+/// Name of target file if didn`t input anything, tests don`t use it
+const char * const DEFAULT_TARGET_FILE_NAME = "-";
+/// Name of source file if didn`t input anything, tests don`t use it
+const char * const DEFAULT_SOURCE_FILE_NAME = "-";
+
+/// Level of optimizations if didn`t input -O
+const int DEFAULT_OPTIMIZATION_LEVEL = 2;
+const int     MAX_OPTIMIZATION_LEVEL = 2;
+
+/// Count of threads of code generation if didn`t input -threads, 0 is count of processors
+const int DEFAULT_THREAD_COUNT = 0;
+
+enum class Save {
+  TEXT,
+  TEX,
+};
+
+struct Settings {
+  char       *source;
+  char       *target;
+  char       *cache;  ///< File of AsmCache or nullptr
+  char       *passes; ///< Pipeline of MiddleEnd or nullptr for default
+  char       *listing; ///< Listing of binary of VM or nullptr
+  int         optimizationLevel; ///< -O0, -O1 or -O2
+  int         threadCount; ///< Workers of BackEnd, 0 is count of processors
+  bool        isBinary; ///< Save tree in compact binary format
+  bool        isPacked; ///< Compress binary tree
+  bool        isObject; ///< Save binary of VM instead of assembler text
+  const char *programName;
+};
+
+void setSettings(const Settings *settings);
+
+void getSettings(Settings *settings);
+
+/// Adder prefix
+/// @param [in] name C-like string
+/// @return Dimanic allocate C-like with DEFAULT_DIRECTORY like prefix
+char *addDirectory(const char *name);
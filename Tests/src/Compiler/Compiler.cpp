@@ -0,0 +1,33 @@
+#include "Compiler.h"
+#include "Tests.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+bool init()
+{
+  return true;
+}
+
+void start()
+{
+  db::TestStatus status{};
+
+  db::testConstantPropagation(&status);
+  db::testEvaluator          (&status);
+  db::testPeephole           (&status);
+  db::testTranslator         (&status);
+  db::testRegisterAllocation (&status);
+  db::testObjectCode         (&status);
+  db::testAsmCache           (&status);
+  db::testTailCalls          (&status);
+  db::testLoopInvariants     (&status);
+  db::testCommonSubexpressions(&status);
+  db::testDeadCode           (&status);
+  db::testInliner            (&status);
+  db::testStrengthReduction  (&status);
+
+  printf("Tests: %zu checks passed, %zu failed\n", status.passed, status.failed);
+
+  if (status.failed) exit(EXIT_FAILURE);
+}
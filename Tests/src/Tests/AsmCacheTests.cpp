@@ -0,0 +1,100 @@
+#include "Tests.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Assert.h"
+
+/// Several functions, so every one of them is a chunk of cache
+static const char CACHE_PROGRAM[] =
+  "var g = 2;\n"
+  "fun square(n: Double): Double {\n"
+  "  return n * n;\n"
+  "}\n"
+  "fun main() {\n"
+  "  var i = 0;\n"
+  "  while (i < 3) {\n"
+  "    out << \"i\" << square(i + g) << endl;\n"
+  "    i = i + 1;\n"
+  "  }\n"
+  "}\n";
+
+static void testCacheRoundTrip(db::TestStatus *status, int optimizationLevel);
+
+/// Asm of CACHE_PROGRAM, generated functions are searched in cache and added to it
+/// @return Text in heap or nullptr
+static char *translateCached(db::AsmCache *cache, int optimizationLevel);
+
+void db::testAsmCache(db::TestStatus *status)
+{
+  assert(status);
+
+  for (int level = 0; level <= 2; ++level)
+    testCacheRoundTrip(status, level);
+}
+
+static void testCacheRoundTrip(db::TestStatus *status, int optimizationLevel)
+{
+  assert(status);
+
+  db::AsmCache cold{};
+  db::initAsmCache(&cold);
+
+  char *coldText = translateCached(&cold, optimizationLevel);
+
+  char  *saved = nullptr;
+  size_t size  = 0;
+
+  FILE *stream = open_memstream(&saved, &size);
+  if (CHECK(status, stream))
+    {
+      db::saveAsmCache(&cold, stream);
+      fclose(stream);
+    }
+
+  db::AsmCache warm{};
+  db::initAsmCache(&warm);
+
+  stream = (saved ? fmemopen(saved, size, "r") : nullptr);
+  if (CHECK(status, stream))
+    {
+      db::loadAsmCache(&warm, stream);
+      fclose(stream);
+    }
+
+  CHECK(status, warm.size && warm.size == cold.size);
+
+  char *warmText = translateCached(&warm, optimizationLevel);
+
+  if (CHECK(status, coldText) && CHECK(status, warmText))
+    CHECK(status, !strcmp(coldText, warmText));
+
+  CHECK(status, warm.hits == cold.size && !warm.misses);
+
+  free(coldText);
+  free(warmText);
+  free(saved);
+
+  db::destroyAsmCache(&cold);
+  db::destroyAsmCache(&warm);
+}
+
+static char *translateCached(db::AsmCache *cache, int optimizationLevel)
+{
+  assert(cache);
+
+  db::Translator translator{};
+  db::initTranslator(&translator);
+
+  char *text = nullptr;
+
+  if (db::parseProgram(&translator, CACHE_PROGRAM))
+    {
+      translator.status.cache = cache;
+      text = db::translateProgram(&translator, optimizationLevel);
+    }
+
+  db::removeTranslator(&translator);
+
+  return text;
+}
@@ -0,0 +1,573 @@
+#include "Tests.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "StackIr.h"
+#include "Assert.h"
+
+#pragma GCC diagnostic ignored "-Wswitch-enum"
+
+const size_t MAX_LINE_SIZE = 128;
+
+const size_t MEMORY_SIZE = 1 << 14;
+const size_t STACK_SIZE  = 1 << 14;
+
+/// Program is stopped after it, so endless loop is error of test
+const size_t MAX_STEPS = 1000000;
+
+/// Real number is integer and fraction words of fixed point like in VM
+const long long FRACTION = 10000;
+
+const int REGISTERS_COUNT = (int)db::Register::RFX + 1;
+
+struct RunnerInstruction {
+  db::Opcode      opcode;
+  db::OperandType type;
+  long long       value;
+  db::Register    base;
+  size_t          target; ///< Index of instruction of label operand
+  char           *label;  ///< Name of label operand before it is resolved
+};
+
+struct RunnerLabel {
+  char  *name;
+  size_t index;
+};
+
+struct Runner {
+  RunnerInstruction *code;
+  size_t             size;
+
+  RunnerLabel *labels;
+  size_t       labelsCount;
+
+  long long *memory;
+  long long *stack;
+  size_t     top;
+
+  long long registers[REGISTERS_COUNT];
+
+  const db::number_t *input;
+  size_t              inputSize;
+
+  FILE *output;
+};
+
+/// Split asm into instructions and labels, operands of labels are resolved
+static bool parseAsm(Runner *runner, const char *text);
+
+static bool parseOperand(RunnerInstruction *instruction, const char *operand);
+
+static bool parseRegister(const char *name, db::Register *reg);
+
+static bool resolveLabels(Runner *runner);
+
+static bool execute(Runner *runner);
+
+static bool executeArithmetic(Runner *runner, db::Opcode opcode);
+
+static bool executeFunction(Runner *runner, db::Opcode opcode);
+
+static bool executeJump(Runner *runner, db::Opcode opcode, bool *isJump);
+
+static bool push(Runner *runner, long long value);
+
+static bool pop(Runner *runner, long long *value);
+
+/// Number of two words in real mode or one word in integral one
+static bool pushNumber(Runner *runner, long long value, bool isReal);
+
+static bool popNumber(Runner *runner, long long *value, bool isReal);
+
+static bool getAddress(const Runner *runner, const RunnerInstruction *instruction, size_t *address);
+
+static void destroyRunner(Runner *runner);
+
+char *db::runAsm(const char *text, const db::number_t *input, size_t inputSize)
+{
+  if (!text || (!input && inputSize)) return nullptr;
+
+  Runner runner{};
+  runner.input     = input;
+  runner.inputSize = inputSize;
+
+  runner.memory = (long long *)calloc(MEMORY_SIZE, sizeof(long long));
+  runner.stack  = (long long *)calloc(STACK_SIZE , sizeof(long long));
+
+  char  *output = nullptr;
+  size_t size   = 0;
+
+  bool isOk = runner.memory && runner.stack && parseAsm(&runner, text) && resolveLabels(&runner);
+
+  if (isOk)
+    {
+      runner.output = open_memstream(&output, &size);
+      isOk = runner.output && execute(&runner);
+
+      if (runner.output) fclose(runner.output);
+    }
+
+  destroyRunner(&runner);
+
+  if (!isOk)
+    {
+      free(output);
+      return nullptr;
+    }
+
+  return output;
+}
+
+char *db::runProgram(
+                     const char *source,
+                     const char *pipeline,
+                     int optimizationLevel,
+                     const db::number_t *input,
+                     size_t inputSize
+                    )
+{
+  char *text = db::compileProgram(source, pipeline, optimizationLevel);
+  if (!text) return nullptr;
+
+  char *output = db::runAsm(text, input, inputSize);
+  free(text);
+
+  return output;
+}
+
+static bool parseAsm(Runner *runner, const char *text)
+{
+  assert(runner);
+  assert(text);
+
+  size_t capacity = 1;
+  for (const char *symbol = text; *symbol; ++symbol)
+    capacity += (*symbol == '\n');
+
+  runner->code   = (RunnerInstruction *)calloc(capacity, sizeof(RunnerInstruction));
+  runner->labels = (RunnerLabel       *)calloc(capacity, sizeof(RunnerLabel      ));
+  if (!runner->code || !runner->labels) return false;
+
+  char line[MAX_LINE_SIZE] = "";
+  while (db::readAsmLine(&text, line, MAX_LINE_SIZE))
+    {
+      size_t length = strlen(line);
+
+      if (line[length - 1] == ':' && !strchr(line, ' '))
+        {
+          line[length - 1] = '\0';
+
+          RunnerLabel *label = runner->labels + runner->labelsCount++;
+          label->name  = strdup(line);
+          label->index = runner->size;
+
+          if (!label->name) return false;
+
+          continue;
+        }
+
+      char *operand = strchr(line, ' ');
+      if (operand) *operand++ = '\0';
+
+      RunnerInstruction *instruction = runner->code + runner->size++;
+
+      bool isKnown = false;
+      for (int opcode = (int)db::Opcode::PUSH; opcode <= (int)db::Opcode::HLT && !isKnown; ++opcode)
+        if (!strcmp(line, db::getOpcodeName((db::Opcode)opcode)))
+          {
+            instruction->opcode = (db::Opcode)opcode;
+            isKnown = true;
+          }
+
+      if (!isKnown || !parseOperand(instruction, operand)) return false;
+    }
+
+  return true;
+}
+
+static bool parseOperand(RunnerInstruction *instruction, const char *operand)
+{
+  assert(instruction);
+
+  instruction->type = db::OperandType::None;
+  if (!operand) return true;
+
+  if (*operand == '[')
+    {
+      instruction->type = db::OperandType::Memory;
+
+      int  value  = 0;
+      int  offset = 0;
+      char name[MAX_LINE_SIZE] = "";
+
+      if (sscanf(operand, "[%d]%n", &value, &offset) == 1 && !operand[offset])
+        {
+          instruction->value = value;
+          return true;
+        }
+
+      if (sscanf(operand, "[%d+%3[a-z]]%n", &value, name, &offset) != 2 || operand[offset])
+        return false;
+
+      instruction->value = value;
+      return parseRegister(name, &instruction->base);
+    }
+
+  if (parseRegister(operand, &instruction->base))
+    {
+      instruction->type = db::OperandType::Register;
+      return true;
+    }
+
+  int value  = 0;
+  int offset = 0;
+  if (sscanf(operand, "%d%n", &value, &offset) == 1 && !operand[offset])
+    {
+      instruction->type  = db::OperandType::Immediate;
+      instruction->value = value;
+      return true;
+    }
+
+  instruction->type  = db::OperandType::Label;
+  instruction->label = strdup(operand + (*operand == ':'));
+
+  return instruction->label;
+}
+
+static bool parseRegister(const char *name, db::Register *reg)
+{
+  assert(name);
+  assert(reg);
+
+  for (int index = (int)db::Register::RAX; index < REGISTERS_COUNT; ++index)
+    if (!strcmp(name, db::getRegisterName((db::Register)index)))
+      {
+        *reg = (db::Register)index;
+        return true;
+      }
+
+  return false;
+}
+
+static bool resolveLabels(Runner *runner)
+{
+  assert(runner);
+
+  for (size_t i = 0; i < runner->size; ++i)
+    {
+      RunnerInstruction *instruction = runner->code + i;
+      if (instruction->type != db::OperandType::Label) continue;
+
+      bool isFound = false;
+      for (size_t j = 0; j < runner->labelsCount && !isFound; ++j)
+        if (!strcmp(runner->labels[j].name, instruction->label))
+          {
+            instruction->target = runner->labels[j].index;
+            isFound = true;
+          }
+
+      if (!isFound) return false;
+    }
+
+  return true;
+}
+
+static bool execute(Runner *runner)
+{
+  assert(runner);
+
+  size_t index = 0;
+
+  for (size_t steps = 0; index < runner->size; ++steps)
+    {
+      if (steps == MAX_STEPS) return false;
+
+      const RunnerInstruction *instruction = runner->code + index++;
+
+      long long value = 0;
+      size_t address  = 0;
+
+      switch (instruction->opcode)
+        {
+        case db::Opcode::PUSH:
+          if (instruction->type == db::OperandType::Memory)
+            {
+              if (!getAddress(runner, instruction, &address)) return false;
+              value = runner->memory[address];
+            }
+          else if (instruction->type == db::OperandType::Register)
+            value = runner->registers[(int)instruction->base];
+          else
+            value = instruction->value;
+
+          if (!push(runner, value)) return false;
+          break;
+
+        case db::Opcode::POP:
+          if (!pop(runner, &value)) return false;
+
+          if (instruction->type == db::OperandType::Register)
+            runner->registers[(int)instruction->base] = value;
+          else if (getAddress(runner, instruction, &address))
+            runner->memory[address] = value;
+          else
+            return false;
+          break;
+
+        case db::Opcode::ADD:
+        case db::Opcode::SUB:
+        case db::Opcode::MUL:
+        case db::Opcode::DIV:
+        case db::Opcode::POW:
+        case db::Opcode::AND:
+        case db::Opcode::OR:
+        case db::Opcode::NEQL:
+        case db::Opcode::EQL:
+        case db::Opcode::LESS:
+        case db::Opcode::GREATER:
+          if (!executeArithmetic(runner, instruction->opcode)) return false;
+          break;
+
+        case db::Opcode::SIN:
+        case db::Opcode::COS:
+        case db::Opcode::TAN:
+        case db::Opcode::SQRT:
+          if (!executeFunction(runner, instruction->opcode)) return false;
+          break;
+
+        case db::Opcode::SWAP:
+          if (runner->top < 2) return false;
+
+          value = runner->stack[runner->top - 1];
+          runner->stack[runner->top - 1] = runner->stack[runner->top - 2];
+          runner->stack[runner->top - 2] = value;
+          break;
+
+        case db::Opcode::JMP:
+          index = instruction->target;
+          break;
+
+        case db::Opcode::JE:
+        case db::Opcode::JNE:
+        case db::Opcode::JB:
+        case db::Opcode::JA:
+        case db::Opcode::JBE:
+        case db::Opcode::JAE:
+          {
+            bool isJump = false;
+            if (!executeJump(runner, instruction->opcode, &isJump)) return false;
+
+            if (isJump) index = instruction->target;
+            break;
+          }
+
+        case db::Opcode::CALL:
+          if (!push(runner, (long long)index)) return false;
+          index = instruction->target;
+          break;
+
+        case db::Opcode::RET:
+          if (!pop(runner, &value) || value < 0) return false;
+          index = (size_t)value;
+          break;
+
+        case db::Opcode::IN:
+          if (runner->inputSize)
+            {
+              value = (long long)(*runner->input++*FRACTION);
+              --runner->inputSize;
+            }
+
+          if (!pushNumber(runner, value, true)) return false;
+          break;
+
+        case db::Opcode::OUT:
+          if (!popNumber(runner, &value, true)) return false;
+
+          fprintf(runner->output, "%.4f ", (double)value/FRACTION);
+          break;
+
+        case db::Opcode::SHOW:
+          for (address = 0; address < MEMORY_SIZE && runner->memory[address]; ++address)
+            fputc((char)runner->memory[address], runner->output);
+          break;
+
+        case db::Opcode::HLT:
+          return true;
+
+        default:
+          return false;
+        }
+    }
+
+  return true;
+}
+
+static bool executeArithmetic(Runner *runner, db::Opcode opcode)
+{
+  assert(runner);
+
+  bool isReal = runner->registers[(int)db::Register::REX] == 1;
+  long long scale = (isReal ? FRACTION : 1);
+
+  long long first  = 0;
+  long long second = 0;
+  if (!popNumber(runner, &first, isReal) || !popNumber(runner, &second, isReal)) return false;
+
+  long long result = 0;
+
+  switch (opcode)
+    {
+    case db::Opcode::ADD:     result = first + second;                  break;
+    case db::Opcode::SUB:     result = first - second;                  break;
+    case db::Opcode::MUL:     result = first*second/scale;              break;
+    case db::Opcode::DIV:     result = (second ? first*scale/second : 0); break;
+    case db::Opcode::POW:
+      result = (long long)(pow((double)first/(double)scale, (double)second/(double)scale)*(double)scale);
+      break;
+    case db::Opcode::AND:     result = scale*(first && second);         break;
+    case db::Opcode::OR:      result = scale*(first || second);         break;
+    case db::Opcode::NEQL:    result = scale*(first != second);         break;
+    case db::Opcode::EQL:     result = scale*(first == second);         break;
+    case db::Opcode::LESS:    result = scale*(first <  second);         break;
+    case db::Opcode::GREATER: result = scale*(first >  second);         break;
+    default:                  return false;
+    }
+
+  return pushNumber(runner, result, isReal);
+}
+
+static bool executeFunction(Runner *runner, db::Opcode opcode)
+{
+  assert(runner);
+
+  long long value = 0;
+  if (!popNumber(runner, &value, true)) return false;
+
+  double argument = (double)value/FRACTION;
+  double result   = 0;
+
+  switch (opcode)
+    {
+    case db::Opcode::SIN:  result = sin (argument); break;
+    case db::Opcode::COS:  result = cos (argument); break;
+    case db::Opcode::TAN:  result = tan (argument); break;
+    case db::Opcode::SQRT: result = sqrt(argument); break;
+    default:               return false;
+    }
+
+  return pushNumber(runner, (long long)(result*FRACTION), true);
+}
+
+static bool executeJump(Runner *runner, db::Opcode opcode, bool *isJump)
+{
+  assert(runner);
+  assert(isJump);
+
+  bool isReal = runner->registers[(int)db::Register::REX] == 1;
+
+  long long top   = 0;
+  long long below = 0;
+  if (!popNumber(runner, &top, isReal) || !popNumber(runner, &below, isReal)) return false;
+
+  switch (opcode)
+    {
+    case db::Opcode::JE:  *isJump = top == below; break;
+    case db::Opcode::JNE: *isJump = top != below; break;
+    case db::Opcode::JB:  *isJump = top <  below; break;
+    case db::Opcode::JA:  *isJump = top >  below; break;
+    case db::Opcode::JBE: *isJump = top <= below; break;
+    case db::Opcode::JAE: *isJump = top >= below; break;
+    default:              return false;
+    }
+
+  return true;
+}
+
+static bool push(Runner *runner, long long value)
+{
+  assert(runner);
+
+  if (runner->top == STACK_SIZE) return false;
+
+  runner->stack[runner->top++] = value;
+
+  return true;
+}
+
+static bool pop(Runner *runner, long long *value)
+{
+  assert(runner);
+  assert(value);
+
+  if (!runner->top) return false;
+
+  *value = runner->stack[--runner->top];
+
+  return true;
+}
+
+static bool pushNumber(Runner *runner, long long value, bool isReal)
+{
+  assert(runner);
+
+  if (!isReal) return push(runner, value);
+
+  long long integer = value/FRACTION;
+
+  return push(runner, value - integer*FRACTION) && push(runner, integer);
+}
+
+static bool popNumber(Runner *runner, long long *value, bool isReal)
+{
+  assert(runner);
+  assert(value);
+
+  if (!isReal) return pop(runner, value);
+
+  long long integer  = 0;
+  long long fraction = 0;
+  if (!pop(runner, &integer) || !pop(runner, &fraction)) return false;
+
+  *value = integer*FRACTION + fraction;
+
+  return true;
+}
+
+static bool getAddress(const Runner *runner, const RunnerInstruction *instruction, size_t *address)
+{
+  assert(runner);
+  assert(instruction);
+  assert(address);
+
+  if (instruction->type != db::OperandType::Memory) return false;
+
+  long long value = instruction->value;
+  if (instruction->base != db::Register::NONE) value += runner->registers[(int)instruction->base];
+
+  if (value < 0 || (size_t)value >= MEMORY_SIZE) return false;
+
+  *address = (size_t)value;
+
+  return true;
+}
+
+static void destroyRunner(Runner *runner)
+{
+  assert(runner);
+
+  for (size_t i = 0; i < runner->size; ++i)
+    free(runner->code[i].label);
+
+  for (size_t i = 0; i < runner->labelsCount; ++i)
+    free(runner->labels[i].name);
+
+  free(runner->code);
+  free(runner->labels);
+  free(runner->memory);
+  free(runner->stack);
+
+  *runner = {};
+}
@@ -0,0 +1,138 @@
+#include "Tests.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include "PassManager.h"
+#include "Settings.h"
+#include "DSL.h"
+#include "Assert.h"
+
+/// Product of sum and difference is calculated once
+static const char REPEATED_PROGRAM[] =
+  "var g = 0;\n"
+  "fun main() {\n"
+  "  var a = 0;\n"
+  "  var b = 0;\n"
+  "  in >> a >> b;\n"
+  "  var x = (a + b) * (a - b) + 1;\n"
+  "  var y = (a + b) * (a - b) + 2;\n"
+  "  out << x << y << endl;\n"
+  "}\n";
+
+/// Assignment of a between uses kills expression
+static const char KILLED_PROGRAM[] =
+  "var g = 0;\n"
+  "fun main() {\n"
+  "  var a = 0;\n"
+  "  var b = 0;\n"
+  "  in >> a >> b;\n"
+  "  var x = (a + b) * (a - b) + 1;\n"
+  "  a = a + 1;\n"
+  "  var y = (a + b) * (a - b) + 2;\n"
+  "  out << x << y << endl;\n"
+  "}\n";
+
+static const db::number_t CSE_INPUT[] = {5, 3};
+
+const size_t CSE_INPUT_SIZE = sizeof(CSE_INPUT)/sizeof(CSE_INPUT[0]);
+
+static void testRepeatedExpression(db::TestStatus *status);
+
+static void testKilledExpression(db::TestStatus *status);
+
+static void testCseOutput(db::TestStatus *status, const char *source);
+
+/// Count of statements in tree
+static size_t countStatements(const db::Token token, db::statement_t statement);
+
+/// Count of declarations of values of cse
+static size_t countValues(const db::Token token);
+
+void db::testCommonSubexpressions(db::TestStatus *status)
+{
+  assert(status);
+
+  testRepeatedExpression(status);
+  testKilledExpression  (status);
+
+  testCseOutput(status, REPEATED_PROGRAM);
+  testCseOutput(status, KILLED_PROGRAM);
+}
+
+static void testRepeatedExpression(db::TestStatus *status)
+{
+  assert(status);
+
+  db::Translator translator{};
+  db::initTranslator(&translator);
+
+  if (CHECK(status, db::parseProgram(&translator, REPEATED_PROGRAM)) &&
+      CHECK(status, db::runPipeline(&translator, "cse")))
+    {
+      db::Token root = translator.grammar.root;
+
+      CHECK(status, countValues(root) == 1);
+      CHECK(status, countStatements(root, db::STATEMENT_MUL) == 1);
+    }
+
+  db::removeTranslator(&translator);
+}
+
+static void testKilledExpression(db::TestStatus *status)
+{
+  assert(status);
+
+  db::Translator translator{};
+  db::initTranslator(&translator);
+
+  if (CHECK(status, db::parseProgram(&translator, KILLED_PROGRAM)) &&
+      CHECK(status, db::runPipeline(&translator, "cse")))
+    {
+      db::Token root = translator.grammar.root;
+
+      CHECK(status, countValues(root) == 0);
+      CHECK(status, countStatements(root, db::STATEMENT_MUL) == 2);
+    }
+
+  db::removeTranslator(&translator);
+}
+
+static void testCseOutput(db::TestStatus *status, const char *source)
+{
+  assert(status);
+  assert(source);
+
+  char *plain = db::runProgram(source, "", 0, CSE_INPUT, CSE_INPUT_SIZE);
+  char *cse   = db::runProgram(source, "cse", 0, CSE_INPUT, CSE_INPUT_SIZE);
+  char *twice = db::runProgram(source, "cse,cse", 0, CSE_INPUT, CSE_INPUT_SIZE);
+  char *full  = db::runProgram(source, db::LEVEL_PIPELINES[MAX_OPTIMIZATION_LEVEL],
+                               MAX_OPTIMIZATION_LEVEL, CSE_INPUT, CSE_INPUT_SIZE);
+
+  if (CHECK(status, plain) && CHECK(status, cse) && CHECK(status, twice) && CHECK(status, full))
+    CHECK(status, !strcmp(plain, cse) && !strcmp(plain, twice) && !strcmp(plain, full));
+
+  free(plain);
+  free(cse);
+  free(twice);
+  free(full);
+}
+
+static size_t countStatements(const db::Token token, db::statement_t statement)
+{
+  if (!token) return 0;
+
+  size_t count = (IS_STATEMENT(token) && STATEMENT(token) == statement);
+
+  return count + countStatements(token->left , statement) +
+                 countStatements(token->right, statement);
+}
+
+static size_t countValues(const db::Token token)
+{
+  if (!token) return 0;
+
+  size_t count = (IS_VAR(token) && token->left && IS_NAME(token->left) &&
+                  !strncmp(NAME(token->left), "$cse_", 5));
+
+  return count + countValues(token->left) + countValues(token->right);
+}
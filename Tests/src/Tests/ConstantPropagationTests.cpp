@@ -0,0 +1,146 @@
+#include "Tests.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include "PassManager.h"
+#include "Settings.h"
+#include "DSL.h"
+#include "Assert.h"
+
+/// Bodies of if, else and while without braces are single statements, not compound ones
+static const char BRACELESS_PROGRAM[] =
+  "var g = 0;\n"
+  "fun main() {\n"
+  "  var n = 0;\n"
+  "  in >> n;\n"
+  "  var s = 0;\n"
+  "  if (n < 2) s = 4;\n"
+  "  var c = 0;\n"
+  "  if (n) c = 1; else c = 2;\n"
+  "  var w = 0;\n"
+  "  while (w < n) w = w + 1;\n"
+  "  out << s << c << w << endl;\n"
+  "}\n";
+
+/// BackEnd requires braces around body of while
+static const char BRACELESS_IF_PROGRAM[] =
+  "var g = 0;\n"
+  "fun main() {\n"
+  "  var n = 0;\n"
+  "  in >> n;\n"
+  "  var s = 0;\n"
+  "  if (n < 2) s = 4;\n"
+  "  var c = 0;\n"
+  "  if (n) c = 1; else c = 2;\n"
+  "  out << s << c << endl;\n"
+  "}\n";
+
+static const char CONSTANT_PROGRAM[] =
+  "var g = 0;\n"
+  "val k = 4;\n"
+  "fun main() {\n"
+  "  val m = k + 1;\n"
+  "  out << m << endl;\n"
+  "}\n";
+
+static void testBracelessBodies(db::TestStatus *status);
+
+static void testBracelessLevels(db::TestStatus *status);
+
+static void testConstantBindings(db::TestStatus *status);
+
+/// Every assignment is still assignment of variable, not of substituted number
+static bool isAssignedToNames(const db::Token token);
+
+/// Some node is read, assignment or declaration of name
+static bool hasName(const db::Token token, const char *name);
+
+void db::testConstantPropagation(db::TestStatus *status)
+{
+  assert(status);
+
+  testBracelessBodies (status);
+  testBracelessLevels (status);
+  testConstantBindings(status);
+}
+
+static void testBracelessBodies(db::TestStatus *status)
+{
+  assert(status);
+
+  db::Translator translator{};
+  db::initTranslator(&translator);
+
+  if (CHECK(status, db::parseProgram(&translator, BRACELESS_PROGRAM)) &&
+      CHECK(status, db::runPipeline(&translator, "const")))
+    {
+      db::Token root = translator.grammar.root;
+
+      CHECK(status, db::searchDeclaration(root, "s"));
+      CHECK(status, db::searchDeclaration(root, "c"));
+      CHECK(status, db::searchDeclaration(root, "w"));
+
+      CHECK(status, isAssignedToNames(root));
+    }
+
+  db::removeTranslator(&translator);
+}
+
+static void testBracelessLevels(db::TestStatus *status)
+{
+  assert(status);
+
+  for (int level = 0; level <= MAX_OPTIMIZATION_LEVEL; ++level)
+    {
+      char *text = db::compileProgram(BRACELESS_IF_PROGRAM, db::LEVEL_PIPELINES[level], level);
+
+      CHECK(status, text);
+
+      free(text);
+    }
+}
+
+static void testConstantBindings(db::TestStatus *status)
+{
+  assert(status);
+
+  db::Translator translator{};
+  db::initTranslator(&translator);
+
+  if (CHECK(status, db::parseProgram(&translator, CONSTANT_PROGRAM)) &&
+      CHECK(status, db::runPipeline(&translator, "const")))
+    {
+      db::Token root = translator.grammar.root;
+
+      CHECK(status, !hasName(root, "k"));
+      CHECK(status, !hasName(root, "m"));
+    }
+
+  db::removeTranslator(&translator);
+}
+
+static bool isAssignedToNames(const db::Token token)
+{
+  for (db::Token node = token; node; node = node->right)
+    {
+      if (IS_ASSIGN(node) && (!node->left || !IS_NAME(node->left))) return false;
+
+      if (!isAssignedToNames(node->left)) return false;
+    }
+
+  return true;
+}
+
+static bool hasName(const db::Token token, const char *name)
+{
+  assert(name);
+
+  for (db::Token node = token; node; node = node->right)
+    {
+      if (IS_NAME(node) && !strcmp(NAME(node), name)) return true;
+
+      if (hasName(node->left, name)) return true;
+    }
+
+  return false;
+}
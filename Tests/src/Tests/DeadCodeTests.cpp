@@ -0,0 +1,113 @@
+#include "Tests.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include "PassManager.h"
+#include "Settings.h"
+#include "DSL.h"
+#include "Assert.h"
+
+/// Constant branches, empty loop, code after return and unused function
+static const char DEAD_PROGRAM[] =
+  "var g = 0;\n"
+  "fun unused(x: Double): Double {\n"
+  "  return x * 2;\n"
+  "}\n"
+  "fun twice(x: Double): Double {\n"
+  "  return x * 2;\n"
+  "  out << 5;\n"
+  "}\n"
+  "fun main() {\n"
+  "  var a = 0;\n"
+  "  in >> a;\n"
+  "  if (0) { out << 1; } else { out << a; }\n"
+  "  while (0) { out << 2; }\n"
+  "  if (a > 0) { if (0) { out << 4; } } else { out << 3; }\n"
+  "  out << twice(a) << endl;\n"
+  "}\n";
+
+static const db::number_t DEAD_INPUTS[] = {-2, 0, 7};
+
+const size_t DEAD_INPUTS_COUNT = sizeof(DEAD_INPUTS)/sizeof(DEAD_INPUTS[0]);
+
+static void testDeadTree(db::TestStatus *status);
+
+static void testDeadOutput(db::TestStatus *status);
+
+/// Program has function with name
+static bool hasFunction(const db::Token root, const char *name);
+
+/// Count of statements in tree
+static size_t countStatements(const db::Token token, db::statement_t statement);
+
+void db::testDeadCode(db::TestStatus *status)
+{
+  assert(status);
+
+  testDeadTree  (status);
+  testDeadOutput(status);
+}
+
+static void testDeadTree(db::TestStatus *status)
+{
+  assert(status);
+
+  db::Translator translator{};
+  db::initTranslator(&translator);
+
+  if (CHECK(status, db::parseProgram(&translator, DEAD_PROGRAM)) &&
+      CHECK(status, db::runPipeline(&translator, "dce")))
+    {
+      db::Token root = translator.grammar.root;
+
+      CHECK(status, !db::searchStatement(root, db::STATEMENT_ELSE ));
+      CHECK(status, !db::searchStatement(root, db::STATEMENT_WHILE));
+      CHECK(status, !hasFunction(root, "unused") && hasFunction(root, "twice"));
+
+      // Only print of a, print of 3 and last print are left
+      CHECK(status, countStatements(root, db::STATEMENT_OUT) == 3);
+    }
+
+  db::removeTranslator(&translator);
+}
+
+static void testDeadOutput(db::TestStatus *status)
+{
+  assert(status);
+
+  for (size_t i = 0; i < DEAD_INPUTS_COUNT; ++i)
+    {
+      char *plain = db::runProgram(DEAD_PROGRAM, "", 0, DEAD_INPUTS + i, 1);
+      char *dce   = db::runProgram(DEAD_PROGRAM, "dce", 0, DEAD_INPUTS + i, 1);
+      char *full  = db::runProgram(DEAD_PROGRAM, db::LEVEL_PIPELINES[MAX_OPTIMIZATION_LEVEL],
+                                   MAX_OPTIMIZATION_LEVEL, DEAD_INPUTS + i, 1);
+
+      if (CHECK(status, plain) && CHECK(status, dce) && CHECK(status, full))
+        CHECK(status, !strcmp(plain, dce) && !strcmp(plain, full));
+
+      free(plain);
+      free(dce);
+      free(full);
+    }
+}
+
+static bool hasFunction(const db::Token root, const char *name)
+{
+  assert(name);
+
+  for (db::Token token = root; token; token = token->right)
+    if (IS_FUN(token->left) && !strcmp(NAME(token->left->left), name))
+      return true;
+
+  return false;
+}
+
+static size_t countStatements(const db::Token token, db::statement_t statement)
+{
+  if (!token) return 0;
+
+  size_t count = (IS_STATEMENT(token) && STATEMENT(token) == statement);
+
+  return count + countStatements(token->left , statement) +
+                 countStatements(token->right, statement);
+}
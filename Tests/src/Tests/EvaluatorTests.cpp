@@ -0,0 +1,86 @@
+#include "Tests.h"
+
+#include <stddef.h>
+#include "DSL.h"
+#include "Assert.h"
+
+/// Calls in out are folded by "pure", expected values are in order of them
+static const char PURE_PROGRAM[] =
+  "var g = 0;\n"
+  "fun early(n: Double): Double {\n"
+  "  if (n < 2) return 7;\n"
+  "  return 3;\n"
+  "}\n"
+  "fun branch(n: Double): Double {\n"
+  "  var s = 0;\n"
+  "  if (n < 2) s = 4;\n"
+  "  return s;\n"
+  "}\n"
+  "fun choice(n: Double): Double {\n"
+  "  var c = 0;\n"
+  "  if (n) c = 1; else c = 2;\n"
+  "  return c;\n"
+  "}\n"
+  "fun loop(n: Double): Double {\n"
+  "  var i = 0;\n"
+  "  var t = 0;\n"
+  "  while (i < n) {\n"
+  "    if (i < 2) t = t + 1; else t = t + 5;\n"
+  "    i = i + 1;\n"
+  "  }\n"
+  "  return t;\n"
+  "}\n"
+  "fun count(n: Double): Double {\n"
+  "  var i = 0;\n"
+  "  while (i < n) i = i + 1;\n"
+  "  return i;\n"
+  "}\n"
+  "fun fact(n: Double): Double {\n"
+  "  if (n < 2) return 1;\n"
+  "  return n * fact(n - 1);\n"
+  "}\n"
+  "fun negate(n: Double): Double {\n"
+  "  return -n;\n"
+  "}\n"
+  "fun main() {\n"
+  "  out << early(1) << branch(1) << choice(1) << choice(0) << loop(4) << count(3)"
+  " << fact(5) << negate(3) << endl;\n"
+  "}\n";
+
+static const db::number_t PURE_VALUES[] = {7, 4, 1, 2, 12, 3, 120, -3};
+
+const size_t PURE_VALUES_COUNT = sizeof(PURE_VALUES)/sizeof(PURE_VALUES[0]);
+
+static void testPureValues(db::TestStatus *status);
+
+void db::testEvaluator(db::TestStatus *status)
+{
+  assert(status);
+
+  testPureValues(status);
+}
+
+static void testPureValues(db::TestStatus *status)
+{
+  assert(status);
+
+  db::Translator translator{};
+  db::initTranslator(&translator);
+
+  if (CHECK(status, db::parseProgram(&translator, PURE_PROGRAM)) &&
+      CHECK(status, db::runPipeline(&translator, "pure")))
+    {
+      db::Token out = db::searchStatement(translator.grammar.root, db::STATEMENT_OUT);
+
+      db::Token parameter = (CHECK(status, out) ? out->left : nullptr);
+
+      size_t index = 0;
+      for ( ; index < PURE_VALUES_COUNT && parameter; ++index, parameter = parameter->right)
+        CHECK(status, parameter->left && IS_NUM(parameter->left) &&
+                      db::compareNumber(NUMBER(parameter->left), PURE_VALUES[index]));
+
+      CHECK(status, index == PURE_VALUES_COUNT);
+    }
+
+  db::removeTranslator(&translator);
+}
@@ -0,0 +1,118 @@
+#include "Tests.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include "PassManager.h"
+#include "Settings.h"
+#include "DSL.h"
+#include "Assert.h"
+
+/// Quiet callees are inlined in expressions, callee with output only as command
+static const char INLINE_PROGRAM[] =
+  "var g = 0;\n"
+  "fun twice(x: Double): Double {\n"
+  "  return x * 2;\n"
+  "}\n"
+  "fun noisy(n: Double): Double {\n"
+  "  out << n;\n"
+  "  g = g + n;\n"
+  "  return n;\n"
+  "}\n"
+  "fun sign(x: Double): Double {\n"
+  "  if (x < 0) { return 0 - 1; }\n"
+  "  return 1;\n"
+  "}\n"
+  "fun main() {\n"
+  "  var a = 0;\n"
+  "  in >> a;\n"
+  "  var b = twice(a) + twice(a + 1);\n"
+  "  var c = sign(a) + sign(b - 4);\n"
+  "  noisy(a);\n"
+  "  noisy(b);\n"
+  "  out << b << c << g << endl;\n"
+  "}\n";
+
+static const db::number_t INLINE_INPUTS[] = {-3, 0, 5};
+
+const size_t INLINE_INPUTS_COUNT = sizeof(INLINE_INPUTS)/sizeof(INLINE_INPUTS[0]);
+
+static void testInlineTree(db::TestStatus *status);
+
+static void testInlineOutput(db::TestStatus *status);
+
+static db::Token searchFunction(const db::Token root, const char *name);
+
+static bool hasCall(const db::Token token, const char *name);
+
+void db::testInliner(db::TestStatus *status)
+{
+  assert(status);
+
+  testInlineTree  (status);
+  testInlineOutput(status);
+}
+
+static void testInlineTree(db::TestStatus *status)
+{
+  assert(status);
+
+  db::Translator translator{};
+  db::initTranslator(&translator);
+
+  if (CHECK(status, db::parseProgram(&translator, INLINE_PROGRAM)) &&
+      CHECK(status, db::runPipeline(&translator, "inline")))
+    {
+      db::Token main = searchFunction(translator.grammar.root, "main");
+
+      if (CHECK(status, main))
+        {
+          CHECK(status, !hasCall(main, "twice"));
+          CHECK(status, !hasCall(main, "noisy"));
+          CHECK(status, !hasCall(main, "sign" ));
+        }
+    }
+
+  db::removeTranslator(&translator);
+}
+
+static void testInlineOutput(db::TestStatus *status)
+{
+  assert(status);
+
+  for (size_t i = 0; i < INLINE_INPUTS_COUNT; ++i)
+    {
+      char *plain   = db::runProgram(INLINE_PROGRAM, "", 0, INLINE_INPUTS + i, 1);
+      char *inlined = db::runProgram(INLINE_PROGRAM, "inline", 0, INLINE_INPUTS + i, 1);
+      char *full    = db::runProgram(INLINE_PROGRAM, db::LEVEL_PIPELINES[MAX_OPTIMIZATION_LEVEL],
+                                     MAX_OPTIMIZATION_LEVEL, INLINE_INPUTS + i, 1);
+
+      if (CHECK(status, plain) && CHECK(status, inlined) && CHECK(status, full))
+        CHECK(status, !strcmp(plain, inlined) && !strcmp(plain, full));
+
+      free(plain);
+      free(inlined);
+      free(full);
+    }
+}
+
+static db::Token searchFunction(const db::Token root, const char *name)
+{
+  assert(name);
+
+  for (db::Token token = root; token; token = token->right)
+    if (IS_FUN(token->left) && !strcmp(NAME(token->left->left), name))
+      return token->left;
+
+  return nullptr;
+}
+
+static bool hasCall(const db::Token token, const char *name)
+{
+  assert(name);
+
+  if (!token) return false;
+
+  if (IS_CALL(token) && token->left && !strcmp(NAME(token->left), name)) return true;
+
+  return hasCall(token->left, name) || hasCall(token->right, name);
+}
@@ -0,0 +1,210 @@
+#include "Tests.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include "PassManager.h"
+#include "Settings.h"
+#include "DSL.h"
+#include "Assert.h"
+
+/// Partial operations are calculated only if k > 0
+static const char GUARDED_PROGRAM[] =
+  "var g = 0;\n"
+  "fun main() {\n"
+  "  var k = 0;\n"
+  "  in >> k;\n"
+  "  var i = 0;\n"
+  "  var t = 0;\n"
+  "  while (i < 3) {\n"
+  "    if (k > 0) {\n"
+  "      t = t + sqrt(k) + 1 / k;\n"
+  "    }\n"
+  "    i = i + 1;\n"
+  "  }\n"
+  "  out << t << endl;\n"
+  "}\n";
+
+/// Loop isn`t run if n is 0, sum of k and 1 is still hoisted
+static const char ZERO_TRIP_PROGRAM[] =
+  "var g = 0;\n"
+  "fun main() {\n"
+  "  var k = 0;\n"
+  "  var n = 0;\n"
+  "  in >> k >> n;\n"
+  "  var i = 0;\n"
+  "  var t = 0;\n"
+  "  while (i < n) {\n"
+  "    t = t + sqrt(k) * (k + 1);\n"
+  "    i = i + 1;\n"
+  "  }\n"
+  "  out << t << endl;\n"
+  "}\n";
+
+/// Body of loop is run at least once and root is calculated before return
+static const char ENTERED_PROGRAM[] =
+  "var g = 0;\n"
+  "fun sum(k: Double): Double {\n"
+  "  var i = 0;\n"
+  "  var t = 0;\n"
+  "  while (1) {\n"
+  "    t = t + sqrt(k);\n"
+  "    i = i + 1;\n"
+  "    if (i > 2) return t;\n"
+  "    t = t + 1 / k;\n"
+  "  }\n"
+  "}\n"
+  "fun main() {\n"
+  "  var k = 0;\n"
+  "  in >> k;\n"
+  "  out << sum(k) << endl;\n"
+  "}\n";
+
+struct LicmCase {
+  const char *source;
+  db::number_t input[2];
+  size_t       inputSize;
+};
+
+static const LicmCase LICM_CASES[] = {
+  { GUARDED_PROGRAM  , {4   }, 1 },
+  { GUARDED_PROGRAM  , {-1  }, 1 },
+  { ZERO_TRIP_PROGRAM, {4, 3}, 2 },
+  { ZERO_TRIP_PROGRAM, {4, 0}, 2 },
+  { ENTERED_PROGRAM  , {4   }, 1 },
+};
+
+const size_t LICM_CASES_COUNT = sizeof(LICM_CASES)/sizeof(LICM_CASES[0]);
+
+static void testGuardedPartial(db::TestStatus *status);
+
+static void testZeroTripPartial(db::TestStatus *status);
+
+static void testEnteredPartial(db::TestStatus *status);
+
+static void testLicmOutput(db::TestStatus *status);
+
+/// Tree of program after licm
+/// @param [out] translator Initialized translator
+static bool hoistProgram(db::TestStatus *status, db::Translator *translator, const char *source);
+
+/// Some loop of program has statement
+static bool isInLoop(const db::Token root, db::statement_t statement);
+
+/// Some declaration of licm has statement in its value
+static bool isHoisted(const db::Token token, db::statement_t statement);
+
+void db::testLoopInvariants(db::TestStatus *status)
+{
+  assert(status);
+
+  testGuardedPartial (status);
+  testZeroTripPartial(status);
+  testEnteredPartial (status);
+  testLicmOutput     (status);
+}
+
+static void testGuardedPartial(db::TestStatus *status)
+{
+  assert(status);
+
+  db::Translator translator{};
+  db::initTranslator(&translator);
+
+  if (hoistProgram(status, &translator, GUARDED_PROGRAM))
+    {
+      db::Token root = translator.grammar.root;
+
+      CHECK(status, isInLoop(root, db::STATEMENT_SQRT) && !isHoisted(root, db::STATEMENT_SQRT));
+      CHECK(status, isInLoop(root, db::STATEMENT_DIV ) && !isHoisted(root, db::STATEMENT_DIV ));
+    }
+
+  db::removeTranslator(&translator);
+}
+
+static void testZeroTripPartial(db::TestStatus *status)
+{
+  assert(status);
+
+  db::Translator translator{};
+  db::initTranslator(&translator);
+
+  if (hoistProgram(status, &translator, ZERO_TRIP_PROGRAM))
+    {
+      db::Token root = translator.grammar.root;
+
+      CHECK(status, isInLoop(root, db::STATEMENT_SQRT) && !isHoisted(root, db::STATEMENT_SQRT));
+      CHECK(status, isHoisted(root, db::STATEMENT_ADD));
+    }
+
+  db::removeTranslator(&translator);
+}
+
+static void testEnteredPartial(db::TestStatus *status)
+{
+  assert(status);
+
+  db::Translator translator{};
+  db::initTranslator(&translator);
+
+  if (hoistProgram(status, &translator, ENTERED_PROGRAM))
+    {
+      db::Token root = translator.grammar.root;
+
+      // Division is after return, so it may be not calculated
+      CHECK(status, !isInLoop(root, db::STATEMENT_SQRT) && isHoisted(root, db::STATEMENT_SQRT));
+      CHECK(status,  isInLoop(root, db::STATEMENT_DIV ) && !isHoisted(root, db::STATEMENT_DIV));
+    }
+
+  db::removeTranslator(&translator);
+}
+
+static void testLicmOutput(db::TestStatus *status)
+{
+  assert(status);
+
+  for (size_t i = 0; i < LICM_CASES_COUNT; ++i)
+    {
+      const LicmCase *test = LICM_CASES + i;
+
+      char *plain = db::runProgram(test->source, "", 0, test->input, test->inputSize);
+      char *licm  = db::runProgram(test->source, "licm", 0, test->input, test->inputSize);
+      char *full  = db::runProgram(test->source, db::LEVEL_PIPELINES[MAX_OPTIMIZATION_LEVEL],
+                                   MAX_OPTIMIZATION_LEVEL, test->input, test->inputSize);
+
+      if (CHECK(status, plain) && CHECK(status, licm) && CHECK(status, full))
+        CHECK(status, !strcmp(plain, licm) && !strcmp(plain, full));
+
+      free(plain);
+      free(licm);
+      free(full);
+    }
+}
+
+static bool hoistProgram(db::TestStatus *status, db::Translator *translator, const char *source)
+{
+  assert(status);
+  assert(translator);
+  assert(source);
+
+  return CHECK(status, db::parseProgram(translator, source)) &&
+         CHECK(status, db::runPipeline(translator, "licm"));
+}
+
+static bool isInLoop(const db::Token root, db::statement_t statement)
+{
+  db::Token loop = db::searchStatement(root, db::STATEMENT_WHILE);
+
+  return loop && db::searchStatement(loop, statement);
+}
+
+static bool isHoisted(const db::Token token, db::statement_t statement)
+{
+  if (!token) return false;
+
+  if (IS_VAR(token) && token->left && IS_NAME(token->left) &&
+      !strncmp(NAME(token->left), "$licm_", 6) &&
+      db::searchStatement(token->right, statement))
+    return true;
+
+  return isHoisted(token->left, statement) || isHoisted(token->right, statement);
+}
@@ -0,0 +1,259 @@
+#include "Tests.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "StackIr.h"
+#include "Assert.h"
+
+/// Jumps forward and backward, calls, locals, globals and string
+static const char OBJECT_PROGRAM[] =
+  "var g = 2;\n"
+  "fun fact(n: Double): Double {\n"
+  "  if (n < 2) return 1;\n"
+  "  return n * fact(n - 1);\n"
+  "}\n"
+  "fun main() {\n"
+  "  var i = 0;\n"
+  "  while (i < 3) {\n"
+  "    out << \"i\" << fact(i + g) << endl;\n"
+  "    i = i + 1;\n"
+  "  }\n"
+  "}\n";
+
+const size_t MAX_LINE_SIZE = 256;
+
+const int OPCODE_MASK        = 0xFF;
+const int OPERAND_TYPE_SHIFT = 8;
+const int REGISTER_SHIFT     = 16;
+
+/// Definition of label in asm and address of the next instruction in binary
+struct AsmLabel {
+  char  *name;
+  size_t address;
+};
+
+struct AsmLabels {
+  AsmLabel *labels;
+  size_t    size;
+};
+
+static void testObjectRoundTrip(db::TestStatus *status, int optimizationLevel);
+
+/// Every instruction of asm is equal to decoded words of binary
+static bool compareObject(const char *text, const int *words, size_t size);
+
+/// Addresses of labels, sizes of instructions are taken from words
+static bool collectLabels(const char *text, const int *words, size_t size, AsmLabels *labels);
+
+/// Decoded instruction at address is line of asm
+static bool compareInstruction(
+                               const char *line,
+                               const int *words,
+                               size_t size,
+                               size_t address,
+                               const AsmLabels *labels
+                              );
+
+static size_t getInstructionSize(int word);
+
+static void destroyLabels(AsmLabels *labels);
+
+void db::testObjectCode(db::TestStatus *status)
+{
+  assert(status);
+
+  for (int level = 0; level <= 2; ++level)
+    testObjectRoundTrip(status, level);
+}
+
+static void testObjectRoundTrip(db::TestStatus *status, int optimizationLevel)
+{
+  assert(status);
+
+  db::Translator asmTranslator{};
+  db::initTranslator(&asmTranslator);
+
+  db::Translator objectTranslator{};
+  db::initTranslator(&objectTranslator);
+
+  char  *text   = nullptr;
+  char  *binary = nullptr;
+  size_t size   = 0;
+
+  if (CHECK(status, db::parseProgram(&asmTranslator   , OBJECT_PROGRAM)) &&
+      CHECK(status, db::parseProgram(&objectTranslator, OBJECT_PROGRAM)))
+    {
+      text   = db::translateProgram      (&asmTranslator   , optimizationLevel);
+      binary = db::translateProgramObject(&objectTranslator, optimizationLevel, &size);
+    }
+
+  if (CHECK(status, text) && CHECK(status, binary) &&
+      CHECK(status, size >= sizeof(db::ObjectHeader)))
+    {
+      const db::ObjectHeader *header = (const db::ObjectHeader *)binary;
+
+      CHECK(status, !memcmp(header->signature, db::OBJECT_SIGNATURE, sizeof(header->signature)));
+      CHECK(status, header->version == db::OBJECT_VERSION);
+
+      size_t wordsCount = (size - sizeof(db::ObjectHeader))/sizeof(int);
+      CHECK(status, header->size >= 0 && (size_t)header->size == wordsCount);
+
+      const int *words = (const int *)(binary + sizeof(db::ObjectHeader));
+      CHECK(status, compareObject(text, words, wordsCount));
+    }
+
+  free(text);
+  free(binary);
+
+  db::removeTranslator(&asmTranslator);
+  db::removeTranslator(&objectTranslator);
+}
+
+static bool compareObject(const char *text, const int *words, size_t size)
+{
+  assert(text);
+  assert(words);
+
+  AsmLabels labels{};
+  if (!collectLabels(text, words, size, &labels))
+    {
+      destroyLabels(&labels);
+      return false;
+    }
+
+  bool isSame = true;
+  size_t address = 0;
+
+  char line[MAX_LINE_SIZE] = "";
+  while (isSame && db::readAsmLine(&text, line, MAX_LINE_SIZE))
+    {
+      if (line[strlen(line) - 1] == ':') continue;
+
+      isSame = compareInstruction(line, words, size, address, &labels);
+
+      if (isSame) address += getInstructionSize(words[address]);
+    }
+
+  destroyLabels(&labels);
+
+  return isSame && address == size;
+}
+
+static bool collectLabels(const char *text, const int *words, size_t size, AsmLabels *labels)
+{
+  assert(text);
+  assert(words);
+  assert(labels);
+
+  size_t capacity = 1;
+  for (const char *symbol = text; *symbol; ++symbol)
+    capacity += (*symbol == '\n');
+
+  labels->labels = (AsmLabel *)calloc(capacity, sizeof(AsmLabel));
+  if (!labels->labels) return false;
+
+  size_t address = 0;
+
+  char line[MAX_LINE_SIZE] = "";
+  while (db::readAsmLine(&text, line, MAX_LINE_SIZE))
+    {
+      size_t length = strlen(line);
+      if (line[length - 1] != ':')
+        {
+          if (address >= size) return false;
+
+          address += getInstructionSize(words[address]);
+          continue;
+        }
+
+      line[length - 1] = '\0';
+
+      AsmLabel *label = labels->labels + labels->size++;
+      label->name    = strdup(line);
+      label->address = address;
+
+      if (!label->name) return false;
+    }
+
+  return true;
+}
+
+static bool compareInstruction(
+                               const char *line,
+                               const int *words,
+                               size_t size,
+                               size_t address,
+                               const AsmLabels *labels
+                              )
+{
+  assert(line);
+  assert(words);
+  assert(labels);
+
+  if (address >= size) return false;
+
+  int word = words[address];
+
+  db::Opcode       opcode = (db::Opcode)(word & OPCODE_MASK);
+  db::OperandType  type   = (db::OperandType)(word >> OPERAND_TYPE_SHIFT & OPCODE_MASK);
+  db::Register     base   = (db::Register)(word >> REGISTER_SHIFT);
+
+  const char *name = db::getOpcodeName(opcode);
+  size_t nameLength = strlen(name);
+  if (strncmp(line, name, nameLength)) return false;
+
+  const char *operand = line + nameLength;
+  if (type == db::OperandType::None) return *operand == '\0';
+
+  if (*operand++ != ' ') return false;
+
+  if (type == db::OperandType::Label)
+    {
+      if (*operand == ':') ++operand;
+
+      if (address + 1 >= size) return false;
+
+      for (size_t i = 0; i < labels->size; ++i)
+        if (!strcmp(labels->labels[i].name, operand))
+          return labels->labels[i].address == (size_t)words[address + 1];
+
+      return false;
+    }
+
+  int value = (getInstructionSize(word) > 1 && address + 1 < size ? words[address + 1] : 0);
+  db::IrOperand decoded = { .type = type, .value = value, .base = base };
+
+  char  *text   = nullptr;
+  size_t length = 0;
+
+  FILE *stream = open_memstream(&text, &length);
+  if (!stream) return false;
+
+  db::printOperand(&decoded, stream);
+  fclose(stream);
+
+  bool isSame = text && !strcmp(text, operand);
+  free(text);
+
+  return isSame;
+}
+
+static size_t getInstructionSize(int word)
+{
+  db::OperandType type = (db::OperandType)(word >> OPERAND_TYPE_SHIFT & OPCODE_MASK);
+
+  return (type == db::OperandType::None || type == db::OperandType::Register ? 1 : 2);
+}
+
+static void destroyLabels(AsmLabels *labels)
+{
+  assert(labels);
+
+  for (size_t i = 0; i < labels->size; ++i)
+    free(labels->labels[i].name);
+
+  free(labels->labels);
+
+  *labels = {};
+}
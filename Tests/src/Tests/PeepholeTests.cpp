@@ -0,0 +1,116 @@
+#include "Tests.h"
+
+#include <stdio.h>
+#include "StackIr.h"
+#include "Assert.h"
+
+const size_t MAX_CASE_SIZE = 6;
+
+/// Code before optimizePeephole and code expected after it
+struct PeepholeCase {
+  const char       *name;
+  size_t            size;
+  db::IrInstruction before[MAX_CASE_SIZE];
+  size_t            keptSize;
+  db::IrInstruction after [MAX_CASE_SIZE];
+};
+
+using enum db::Opcode;
+
+static const db::IrOperand RAX   = db::registerOperand(db::Register::RAX);
+static const db::IrOperand RBX   = db::registerOperand(db::Register::RBX);
+static const db::IrOperand LOCAL = db::memoryOperand(2, db::Register::RDX);
+static const db::IrOperand ZERO  = db::immediateOperand(0);
+static const db::IrOperand ONE   = db::immediateOperand(1);
+static const db::IrOperand TWO   = db::immediateOperand(2);
+static const db::IrOperand ELSE  = db::labelOperand("ELSE" , "main", 1);
+static const db::IrOperand WHILE = db::labelOperand("WHILE", "main", 2);
+
+static const PeepholeCase CASES[] = {
+  { "push x; pop x",
+    2, { {PUSH, LOCAL}, {POP, LOCAL} },
+    0, {                             } },
+  { "push x; pop x across comment",
+    3, { {PUSH, RAX}, {COMMENT, {}, "note"}, {POP, RAX} },
+    1, { {COMMENT, {}, "note"}                          } },
+  { "push x; pop y is kept",
+    2, { {PUSH, RAX}, {POP, RBX} },
+    2, { {PUSH, RAX}, {POP, RBX} } },
+  { "dead store to reg",
+    4, { {PUSH, ONE}, {POP, RAX}, {PUSH, TWO}, {POP, RAX} },
+    2, {                          {PUSH, TWO}, {POP, RAX} } },
+  { "store read by next one is kept",
+    4, { {PUSH, ONE}, {POP, RAX}, {PUSH, db::memoryOperand(0, db::Register::RAX)}, {POP, RAX} },
+    4, { {PUSH, ONE}, {POP, RAX}, {PUSH, db::memoryOperand(0, db::Register::RAX)}, {POP, RAX} } },
+  { "jmp to next",
+    2, { {JMP, ELSE}, {LABEL, ELSE} },
+    1, {              {LABEL, ELSE} } },
+  { "jmp over label",
+    3, { {JMP, ELSE}, {LABEL, WHILE}, {LABEL, ELSE} },
+    2, {              {LABEL, WHILE}, {LABEL, ELSE} } },
+  { "jmp to other label is kept",
+    2, { {JMP, WHILE}, {LABEL, ELSE} },
+    2, { {JMP, WHILE}, {LABEL, ELSE} } },
+  { "unreachable",
+    4, { {RET}, {PUSH, ONE}, {POP, RBX}, {LABEL, ELSE} },
+    2, { {RET},                          {LABEL, ELSE} } },
+  // Two zeros are one real number or two integral ones, so sum isn`t removed
+  { "add zero is kept",
+    5, { {PUSH, LOCAL}, {PUSH, ZERO}, {PUSH, ZERO}, {ADD}, {POP, RAX} },
+    5, { {PUSH, LOCAL}, {PUSH, ZERO}, {PUSH, ZERO}, {ADD}, {POP, RAX} } },
+  { "add one is kept",
+    4, { {PUSH, ZERO}, {PUSH, ONE}, {ADD}, {POP, RAX} },
+    4, { {PUSH, ZERO}, {PUSH, ONE}, {ADD}, {POP, RAX} } },
+};
+
+const size_t CASES_COUNT = sizeof(CASES)/sizeof(CASES[0]);
+
+static void testPeepholeCase(db::TestStatus *status, const PeepholeCase *peepholeCase);
+
+static bool isSameInstruction(const db::IrInstruction *first, const db::IrInstruction *second);
+
+void db::testPeephole(db::TestStatus *status)
+{
+  assert(status);
+
+  for (size_t i = 0; i < CASES_COUNT; ++i)
+    testPeepholeCase(status, CASES + i);
+}
+
+static void testPeepholeCase(db::TestStatus *status, const PeepholeCase *peepholeCase)
+{
+  assert(status);
+  assert(peepholeCase);
+
+  db::IrCode code{};
+  db::initIr(&code);
+
+  for (size_t i = 0; i < peepholeCase->size; ++i)
+    {
+      const db::IrInstruction *instruction = peepholeCase->before + i;
+      db::emitIr(&code, instruction->opcode, instruction->operand, instruction->comment);
+    }
+
+  int errorCode = 0;
+  db::optimizePeephole(&code, &errorCode);
+
+  bool isSame = !code.isFailed && !errorCode && code.size == peepholeCase->keptSize;
+  for (size_t i = 0; isSame && i < code.size; ++i)
+    isSame = isSameInstruction(code.instructions + i, peepholeCase->after + i);
+
+  if (!CHECK(status, isSame))
+    {
+      fprintf(stderr, "Peephole case \"%s\" gives:\n", peepholeCase->name);
+      db::printIr(&code, stderr);
+    }
+
+  db::destroyIr(&code);
+}
+
+static bool isSameInstruction(const db::IrInstruction *first, const db::IrInstruction *second)
+{
+  assert(first);
+  assert(second);
+
+  return first->opcode == second->opcode && db::isSameOperand(&first->operand, &second->operand);
+}
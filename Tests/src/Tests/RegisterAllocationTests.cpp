@@ -0,0 +1,120 @@
+#include "Tests.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include "Assert.h"
+
+/// Locals of loop are hot enough to take all free registers and live across call
+static const char CALL_PROGRAM[] =
+  "var g = 0;\n"
+  "fun twice(n: Double): Double {\n"
+  "  return n + n;\n"
+  "}\n"
+  "fun main() {\n"
+  "  var i = 0;\n"
+  "  var s = 0;\n"
+  "  var t = 0;\n"
+  "  while (i < 10) {\n"
+  "    s = s + twice(i) + t + t + t + s + s;\n"
+  "    t = t + s + i + t + s + t;\n"
+  "    i = i + 1;\n"
+  "  }\n"
+  "  out << s << t << endl;\n"
+  "}\n";
+
+/// Registers of allocateRegisters, rax and rbx hold return value after call
+static const char *const REGISTERS[] = {"rfx", "rax", "rbx"};
+
+const size_t REGISTERS_COUNT = sizeof(REGISTERS)/sizeof(REGISTERS[0]);
+
+/// Return value is pushed right after call, before any reload
+static const char *const RETURN_SEQUENCE[] = {"POP rdx", "PUSH rbx", "PUSH rax"};
+
+const size_t RETURN_SEQUENCE_SIZE = sizeof(RETURN_SEQUENCE)/sizeof(RETURN_SEQUENCE[0]);
+
+const size_t MAX_LINE_SIZE = 128;
+
+static void testReturnValueRegisters(db::TestStatus *status);
+
+/// Label, jump, return or halt, value of register isn`t tracked across it
+static bool isBoundary(const char *line);
+
+void db::testRegisterAllocation(db::TestStatus *status)
+{
+  assert(status);
+
+  testReturnValueRegisters(status);
+}
+
+static void testReturnValueRegisters(db::TestStatus *status)
+{
+  assert(status);
+
+  char *text = db::compileProgram(CALL_PROGRAM, "fold", 2);
+  if (!CHECK(status, text)) return;
+
+  bool isReturnPushed = true;
+  bool isReadLoaded   = true;
+  bool isReloaded[REGISTERS_COUNT] = {};
+  size_t calls = 0;
+
+  // Position after last call or -1 if registers aren`t checked
+  int  afterCall = -1;
+  bool isLoaded[REGISTERS_COUNT] = {};
+
+  const char *position = text;
+  char line[MAX_LINE_SIZE] = "";
+  while (db::readAsmLine(&position, line, MAX_LINE_SIZE))
+    {
+      if (!strncmp(line, "CALL ", 5))
+        {
+          ++calls;
+          afterCall = 0;
+          for (size_t i = 0; i < REGISTERS_COUNT; ++i) isLoaded[i] = false;
+
+          continue;
+        }
+
+      if (afterCall < 0) continue;
+
+      // Call of main is followed by HLT
+      if (isBoundary(line))
+        {
+          afterCall = -1;
+          continue;
+        }
+
+      if ((size_t)afterCall < RETURN_SEQUENCE_SIZE)
+        {
+          isReturnPushed &= !strcmp(line, RETURN_SEQUENCE[afterCall++]);
+          continue;
+        }
+
+      for (size_t i = 0; i < REGISTERS_COUNT; ++i)
+        {
+          if (!strncmp(line, "POP ", 4) && !strcmp(line + 4, REGISTERS[i]))
+            isReloaded[i] = isLoaded[i] = true;
+          else if (strstr(line, REGISTERS[i]))
+            isReadLoaded &= isLoaded[i];
+        }
+    }
+
+  CHECK(status, calls);
+  CHECK(status, isReturnPushed);
+  CHECK(status, isReadLoaded);
+
+  for (size_t i = 0; i < REGISTERS_COUNT; ++i)
+    CHECK(status, isReloaded[i]);
+
+  free(text);
+}
+
+static bool isBoundary(const char *line)
+{
+  assert(line);
+
+  size_t size = strlen(line);
+
+  return line[0] == 'J' || !strcmp(line, "RET") || !strcmp(line, "HLT") ||
+         (size && line[size - 1] == ':');
+}
@@ -0,0 +1,152 @@
+#include "Tests.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include "PassManager.h"
+#include "DSL.h"
+#include "Assert.h"
+
+/// FrontEnd has no syntax of ^, so p is (a + 1)^3 and s is a^2 after injectPowers
+static const char STRENGTH_PROGRAM[] =
+  "var g = 0;\n"
+  "fun main() {\n"
+  "  var a = 0;\n"
+  "  in >> a;\n"
+  "  var p = (a + 1) * 3;\n"
+  "  var s = a - 2;\n"
+  "  var d = a * 2;\n"
+  "  var q = a / 4;\n"
+  "  out << p << s << d << q << endl;\n"
+  "}\n";
+
+static const db::number_t STRENGTH_INPUTS[] = {-3, 0, 5};
+
+const size_t STRENGTH_INPUTS_COUNT = sizeof(STRENGTH_INPUTS)/sizeof(STRENGTH_INPUTS[0]);
+
+static void testStrengthTree(db::TestStatus *status);
+
+static void testStrengthOutput(db::TestStatus *status);
+
+/// Replace first product and first difference of program by powers
+static bool injectPowers(db::Translator *translator);
+
+/// Output of STRENGTH_PROGRAM with powers through pipeline and BackEnd without optimizations
+/// @return Text in heap or nullptr if some stage failed
+static char *runPowers(const char *pipeline, const db::number_t *input);
+
+/// Count of statements in tree
+static size_t countStatements(const db::Token token, db::statement_t statement);
+
+/// Count of declarations of values of strength reduction
+static size_t countValues(const db::Token token);
+
+void db::testStrengthReduction(db::TestStatus *status)
+{
+  assert(status);
+
+  testStrengthTree  (status);
+  testStrengthOutput(status);
+}
+
+static void testStrengthTree(db::TestStatus *status)
+{
+  assert(status);
+
+  db::Translator translator{};
+  db::initTranslator(&translator);
+
+  if (CHECK(status, db::parseProgram(&translator, STRENGTH_PROGRAM)) &&
+      CHECK(status, injectPowers(&translator)) &&
+      CHECK(status, db::runPipeline(&translator, "strength")))
+    {
+      db::Token root = translator.grammar.root;
+
+      CHECK(status, !db::searchStatement(root, db::STATEMENT_POW));
+      CHECK(status, !db::searchStatement(root, db::STATEMENT_DIV));
+
+      // Complex base of cube is declared once, a * 2 becomes a + a
+      CHECK(status, countValues(root) == 1);
+      CHECK(status, countStatements(root, db::STATEMENT_MUL) == 4);
+      CHECK(status, countStatements(root, db::STATEMENT_ADD) == 2);
+    }
+
+  db::removeTranslator(&translator);
+}
+
+static void testStrengthOutput(db::TestStatus *status)
+{
+  assert(status);
+
+  for (size_t i = 0; i < STRENGTH_INPUTS_COUNT; ++i)
+    {
+      char *plain   = runPowers("", STRENGTH_INPUTS + i);
+      char *reduced = runPowers("strength", STRENGTH_INPUTS + i);
+      char *twice   = runPowers("strength,strength", STRENGTH_INPUTS + i);
+
+      if (CHECK(status, plain) && CHECK(status, reduced) && CHECK(status, twice))
+        CHECK(status, !strcmp(plain, reduced) && !strcmp(plain, twice));
+
+      free(plain);
+      free(reduced);
+      free(twice);
+    }
+}
+
+static bool injectPowers(db::Translator *translator)
+{
+  assert(translator);
+
+  db::Token cube   = db::searchStatement(translator->grammar.root, db::STATEMENT_MUL);
+  db::Token square = db::searchStatement(translator->grammar.root, db::STATEMENT_SUB);
+  if (!cube || !square) return false;
+
+  STATEMENT(cube  ) = db::STATEMENT_POW;
+  STATEMENT(square) = db::STATEMENT_POW;
+
+  return true;
+}
+
+static char *runPowers(const char *pipeline, const db::number_t *input)
+{
+  assert(pipeline);
+  assert(input);
+
+  db::Translator middle{};
+  db::Translator back{};
+  db::initTranslator(&middle);
+  db::initTranslator(&back);
+
+  char *text = nullptr;
+
+  if (db::parseProgram(&middle, STRENGTH_PROGRAM) && injectPowers(&middle) &&
+      db::runPipeline(&middle, pipeline) && db::passTree(&middle, &back))
+    text = db::translateProgram(&back, 0);
+
+  db::removeTranslator(&middle);
+  db::removeTranslator(&back);
+
+  char *output = (text ? db::runAsm(text, input, 1) : nullptr);
+  free(text);
+
+  return output;
+}
+
+static size_t countStatements(const db::Token token, db::statement_t statement)
+{
+  if (!token) return 0;
+
+  size_t count = (IS_STATEMENT(token) && STATEMENT(token) == statement);
+
+  return count + countStatements(token->left , statement) +
+                 countStatements(token->right, statement);
+}
+
+static size_t countValues(const db::Token token)
+{
+  if (!token) return 0;
+
+  size_t count = (IS_VAL(token) && token->left && IS_NAME(token->left) &&
+                  !strncmp(NAME(token->left), "$pow_", 5));
+
+  return count + countValues(token->left) + countValues(token->right);
+}
@@ -0,0 +1,136 @@
+#include "Tests.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include "PassManager.h"
+#include "Settings.h"
+#include "DSL.h"
+#include "Assert.h"
+
+/// Arguments print themselves, call calculates them from the last one
+static const char ORDER_PROGRAM[] =
+  "var g = 0;\n"
+  "fun a(n: Double): Double {\n"
+  "  out << n;\n"
+  "  return n;\n"
+  "}\n"
+  "fun f(x: Double, y: Double, k: Double): Double {\n"
+  "  if (k < 1) return x + y;\n"
+  "  return f(a(x + 1), a(y + 10), k - 1);\n"
+  "}\n"
+  "fun main() {\n"
+  "  out << f(0, 0, 2) << endl;\n"
+  "}\n";
+
+static const char ORDER_OUTPUT[] = "10.0000 1.0000 20.0000 2.0000 22.0000 \n";
+
+/// Arguments read parameters which are assigned before them
+static const char SWAP_PROGRAM[] =
+  "var g = 0;\n"
+  "fun swap(a: Double, b: Double, k: Double): Double {\n"
+  "  if (k < 1) return a - b;\n"
+  "  return swap(b, a, k - 1);\n"
+  "}\n"
+  "fun main() {\n"
+  "  var n = 0;\n"
+  "  in >> n;\n"
+  "  out << swap(n, 2, 3) << endl;\n"
+  "}\n";
+
+static const db::number_t SWAP_INPUT[] = {5};
+
+static void testArgumentOrder(db::TestStatus *status);
+
+static void testSwappedArguments(db::TestStatus *status);
+
+/// Function has loop instead of self call
+static bool isLoop(db::Translator *translator, const char *name);
+
+static bool hasCall(const db::Token token, const char *name);
+
+void db::testTailCalls(db::TestStatus *status)
+{
+  assert(status);
+
+  testArgumentOrder   (status);
+  testSwappedArguments(status);
+}
+
+static void testArgumentOrder(db::TestStatus *status)
+{
+  assert(status);
+
+  db::Translator translator{};
+  db::initTranslator(&translator);
+
+  if (CHECK(status, db::parseProgram(&translator, ORDER_PROGRAM)) &&
+      CHECK(status, db::runPipeline(&translator, "tail")))
+    CHECK(status, isLoop(&translator, "f"));
+
+  db::removeTranslator(&translator);
+
+  char *plain = db::runProgram(ORDER_PROGRAM, "", 0, nullptr, 0);
+  char *tail  = db::runProgram(ORDER_PROGRAM, "tail", 0, nullptr, 0);
+  char *full  = db::runProgram(ORDER_PROGRAM, db::LEVEL_PIPELINES[MAX_OPTIMIZATION_LEVEL],
+                               MAX_OPTIMIZATION_LEVEL, nullptr, 0);
+
+  if (CHECK(status, plain)) CHECK(status, !strcmp(plain, ORDER_OUTPUT));
+  if (CHECK(status, tail )) CHECK(status, !strcmp(tail , ORDER_OUTPUT));
+  if (CHECK(status, full )) CHECK(status, !strcmp(full , ORDER_OUTPUT));
+
+  free(plain);
+  free(tail);
+  free(full);
+}
+
+static void testSwappedArguments(db::TestStatus *status)
+{
+  assert(status);
+
+  const size_t inputSize = sizeof(SWAP_INPUT)/sizeof(SWAP_INPUT[0]);
+
+  db::Translator translator{};
+  db::initTranslator(&translator);
+
+  if (CHECK(status, db::parseProgram(&translator, SWAP_PROGRAM)) &&
+      CHECK(status, db::runPipeline(&translator, "tail")))
+    CHECK(status, isLoop(&translator, "swap"));
+
+  db::removeTranslator(&translator);
+
+  char *plain = db::runProgram(SWAP_PROGRAM, "", 0, SWAP_INPUT, inputSize);
+  char *tail  = db::runProgram(SWAP_PROGRAM, "tail", 0, SWAP_INPUT, inputSize);
+
+  if (CHECK(status, plain) && CHECK(status, tail))
+    CHECK(status, !strcmp(plain, tail) && !strcmp(plain, "-3.0000 \n"));
+
+  free(plain);
+  free(tail);
+}
+
+static bool isLoop(db::Translator *translator, const char *name)
+{
+  assert(translator);
+  assert(name);
+
+  db::Token function = nullptr;
+  for (db::Token token = translator->grammar.root; token && !function; token = token->right)
+    if (IS_FUN(token->left) && !strcmp(NAME(token->left->left), name))
+      function = token->left;
+
+  if (!function || !function->right) return false;
+
+  return !hasCall(function->right, name) &&
+         db::searchStatement(function->right, db::STATEMENT_WHILE);
+}
+
+static bool hasCall(const db::Token token, const char *name)
+{
+  assert(name);
+
+  if (!token) return false;
+
+  if (IS_CALL(token) && token->left && !strcmp(NAME(token->left), name)) return true;
+
+  return hasCall(token->left, name) || hasCall(token->right, name);
+}
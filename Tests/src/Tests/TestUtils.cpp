@@ -0,0 +1,245 @@
+#include "Tests.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "TokenAnalysis.h"
+#include "SyntaxAnalysis.h"
+#include "PassManager.h"
+#include "DSL.h"
+#include "Assert.h"
+
+bool db::checkTest(db::TestStatus *status, bool condition, const char *text, const char *file, int line)
+{
+  assert(status);
+  assert(text);
+  assert(file);
+
+  if (condition)
+    ++status->passed;
+  else
+    {
+      ++status->failed;
+      fprintf(stderr, "%s:%d: Check failed: %s\n", file, line, text);
+    }
+
+  return condition;
+}
+
+bool db::parseProgram(db::Translator *translator, const char *source)
+{
+  if (!translator || !source) return false;
+
+  db::Translator front{};
+  db::initTranslator(&front);
+  front.status.sourceName = "test";
+
+  int errorCode = 0;
+
+  front.tokens = db::getTokens(source, &front.stringPool, &errorCode);
+  if (!front.tokens || errorCode)
+    {
+      db::removeTranslator(&front);
+      return false;
+    }
+
+  db::getGrammarly(&front, &errorCode);
+  free(front.tokens);
+
+  bool isOk = !errorCode && front.grammar.root && db::passTree(&front, translator);
+
+  db::removeTranslator(&front);
+
+  return isOk;
+}
+
+bool db::runPipeline(db::Translator *translator, const char *pipeline)
+{
+  if (!translator || !pipeline) return false;
+
+  // Tree of program without optimizations
+  if (!*pipeline) return true;
+
+  db::PassManager manager{};
+
+  int errorCode = 0;
+  db::initPassManager(&manager, pipeline, &errorCode);
+  if (errorCode) return false;
+
+  db::runPasses(&manager, translator, &errorCode);
+
+  db::destroyPassManager(&manager);
+
+  return !errorCode;
+}
+
+bool db::passTree(db::Translator *source, db::Translator *target)
+{
+  if (!source || !target) return false;
+
+  char  *text = nullptr;
+  size_t size = 0;
+
+  FILE *stream = open_memstream(&text, &size);
+  if (!stream) return false;
+
+  int errorCode = 0;
+  db::saveTranslator(source, stream, &errorCode);
+  fclose(stream);
+
+  if (errorCode)
+    {
+      free(text);
+      return false;
+    }
+
+  stream = fmemopen(text, size, "r");
+  if (!stream)
+    {
+      free(text);
+      return false;
+    }
+
+  db::loadTranslator(target, stream, &errorCode);
+
+  fclose(stream);
+  free(text);
+
+  return !errorCode && target->grammar.root;
+}
+
+char *db::translateProgram(db::Translator *translator, int optimizationLevel)
+{
+  if (!translator) return nullptr;
+
+  translator->status.optimizationLevel = optimizationLevel;
+  translator->status.threadCount       = 1;
+
+  char  *text = nullptr;
+  size_t size = 0;
+
+  FILE *target = open_memstream(&text, &size);
+  if (!target) return nullptr;
+
+  int errorCode = 0;
+  db::translate(translator, target, &errorCode);
+
+  fclose(target);
+
+  if (errorCode)
+    {
+      free(text);
+      return nullptr;
+    }
+
+  return text;
+}
+
+char *db::translateProgramObject(db::Translator *translator, int optimizationLevel, size_t *size)
+{
+  if (!translator || !size) return nullptr;
+
+  translator->status.optimizationLevel = optimizationLevel;
+  translator->status.threadCount       = 1;
+
+  char *binary = nullptr;
+
+  FILE *target = open_memstream(&binary, size);
+  if (!target) return nullptr;
+
+  int errorCode = 0;
+  db::translateObject(translator, target, nullptr, &errorCode);
+
+  fclose(target);
+
+  if (errorCode)
+    {
+      free(binary);
+      return nullptr;
+    }
+
+  return binary;
+}
+
+char *db::compileProgram(const char *source, const char *pipeline, int optimizationLevel)
+{
+  if (!source || !pipeline) return nullptr;
+
+  db::Translator middle{};
+  db::initTranslator(&middle);
+
+  db::Translator back{};
+  db::initTranslator(&back);
+
+  char *text = nullptr;
+
+  if (db::parseProgram(&middle, source) &&
+      db::runPipeline (&middle, pipeline) &&
+      db::passTree    (&middle, &back))
+    text = db::translateProgram(&back, optimizationLevel);
+
+  db::removeTranslator(&middle);
+  db::removeTranslator(&back);
+
+  return text;
+}
+
+db::Token db::searchStatement(db::Token token, db::statement_t statement)
+{
+  for ( ; token; token = token->right)
+    {
+      if (IS_STATEMENT(token) && STATEMENT(token) == statement) return token;
+
+      db::Token found = db::searchStatement(token->left, statement);
+      if (found) return found;
+    }
+
+  return nullptr;
+}
+
+db::Token db::searchDeclaration(db::Token token, const char *name)
+{
+  assert(name);
+
+  for ( ; token; token = token->right)
+    {
+      if ((IS_VAR(token) || IS_VAL(token)) && token->left && IS_NAME(token->left) &&
+          !strcmp(NAME(token->left), name))
+        return token;
+
+      db::Token found = db::searchDeclaration(token->left, name);
+      if (found) return found;
+    }
+
+  return nullptr;
+}
+
+bool db::readAsmLine(const char **text, char *line, size_t size)
+{
+  assert(text);
+  assert(*text);
+  assert(line);
+  assert(size);
+
+  while (**text)
+    {
+      const char *end = strchr(*text, '\n');
+      if (!end) end = *text + strlen(*text);
+
+      size_t length = (size_t)(end - *text);
+      const char *comment = (const char *)memchr(*text, ';', length);
+      if (comment) length = (size_t)(comment - *text);
+
+      while (length && (*text)[length - 1] == ' ') --length;
+      if (length >= size) length = size - 1;
+
+      memcpy(line, *text, length);
+      line[length] = '\0';
+
+      *text = (*end ? end + 1 : end);
+
+      if (length) return true;
+    }
+
+  return false;
+}
@@ -0,0 +1,122 @@
+#include "Tests.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include "DSL.h"
+#include "Assert.h"
+
+/// FrontEnd has no syntax of !, so NOT is put in tree of condition by test
+static const char CONDITION_PROGRAM[] =
+  "var g = 0;\n"
+  "fun main() {\n"
+  "  var n = 0;\n"
+  "  in >> n;\n"
+  "  var s = 0;\n"
+  "  if (n < 2) s = 4;\n"
+  "  out << s << endl;\n"
+  "}\n";
+
+/// Literals and endl of one out are shown at once from -O1
+static const char OUT_PROGRAM[] =
+  "var g = 0;\n"
+  "fun main() {\n"
+  "  out << \"ab\" << \"c\" << endl;\n"
+  "}\n";
+
+const size_t MAX_LINE_SIZE = 256;
+
+static void testNotLevels(db::TestStatus *status);
+
+static void testOutLiterals(db::TestStatus *status);
+
+/// Count of lines of asm, which start by prefix
+static size_t countInstructions(const char *text, const char *prefix);
+
+/// Asm of CONDITION_PROGRAM, condition of if is negated by NOT if isNegated
+/// @return Text in heap or nullptr
+static char *translateCondition(bool isNegated, int optimizationLevel);
+
+void db::testTranslator(db::TestStatus *status)
+{
+  assert(status);
+
+  testNotLevels  (status);
+  testOutLiterals(status);
+}
+
+static void testNotLevels(db::TestStatus *status)
+{
+  assert(status);
+
+  for (int level = 0; level <= 1; ++level)
+    {
+      char *plain   = translateCondition(false, level);
+      char *negated = translateCondition(true , level);
+
+      if (CHECK(status, plain) && CHECK(status, negated))
+        CHECK(status, strcmp(plain, negated));
+
+      if (level == 0 && negated)
+        CHECK(status, strstr(negated, "EQL"));
+
+      free(plain);
+      free(negated);
+    }
+}
+
+static char *translateCondition(bool isNegated, int optimizationLevel)
+{
+  db::Translator translator{};
+  db::initTranslator(&translator);
+
+  char *text = nullptr;
+
+  if (db::parseProgram(&translator, CONDITION_PROGRAM))
+    {
+      db::Token statement = db::searchStatement(translator.grammar.root, db::STATEMENT_IF);
+
+      if (statement && isNegated)
+        statement->left = CREATE_STATEMENT(NOT, statement->left, nullptr);
+
+      if (statement && statement->left)
+        text = db::translateProgram(&translator, optimizationLevel);
+    }
+
+  db::removeTranslator(&translator);
+
+  return text;
+}
+
+static void testOutLiterals(db::TestStatus *status)
+{
+  assert(status);
+
+  // Every literal and endl is shown by itself at -O0
+  const size_t SHOWS[] = {3, 1};
+
+  for (int level = 0; level <= 1; ++level)
+    {
+      char *text = db::compileProgram(OUT_PROGRAM, "fold", level);
+      if (!CHECK(status, text)) continue;
+
+      CHECK(status, countInstructions(text, "SHOW")   == SHOWS[level]);
+      CHECK(status, countInstructions(text, "SHOW [") == 0);
+
+      free(text);
+    }
+}
+
+static size_t countInstructions(const char *text, const char *prefix)
+{
+  assert(text);
+  assert(prefix);
+
+  size_t count = 0;
+  size_t length = strlen(prefix);
+
+  char line[MAX_LINE_SIZE] = "";
+  while (db::readAsmLine(&text, line, sizeof(line)))
+    count += !strncmp(line, prefix, length);
+
+  return count;
+}
@@ -45,6 +45,8 @@ namespace db {
   typedef TreeNode *Token;
   typedef Tree    Grammar;
 
+  typedef unsigned long long hash_t;
+
   enum TreeError {
     TREE_NULLPTR = 0x01 << 0,
   };
@@ -86,6 +88,25 @@ namespace db {
 
   void removeNode(TreeNode *node, int *error = nullptr);
 
+  /// Count of nodes in subtree (node may be nullptr)
+  size_t countNodes(const TreeNode *node);
+
+  /// Subtree has no calls, assignments and input (node may be nullptr)
+  /// @note Such subtree may be removed, repeated or moved over other pure code
+  bool isPureNode(const TreeNode *node);
+
+  /// Structural hash of subtree
+  /// @param [in] node Root of subtree (may be nullptr)
+  /// @param [in] seed Start value of hash
+  /// @return Hash which depends only on types, values and shape of nodes
+  /// @note Names and strings are hashed by content, positions are ignored
+  hash_t hashNode(const TreeNode *node, hash_t seed = 0);
+
+  /// Structural equality of subtrees, positions are ignored like in hashNode
+  bool isSameNode(const TreeNode *first, const TreeNode *second);
+
+  hash_t combineHash(hash_t hash, const void *data, size_t size);
+
 
   unsigned validateTree(const Tree *tree);
 
@@ -103,6 +124,13 @@ namespace db {
 #define dumpTreeWithMessage(TREE, ERROR, FILE, MESSAGE, ...)            \
   do_dumpTree(TREE, ERROR, FILE, __FILE__, __func__, __LINE__, MESSAGE __VA_OPT__(,) __VA_ARGS__)
 
+  /// Writer of nodes and edges of graph into body of digraph
+  typedef void (*graphGenerator_t)(const void *graph, FILE *file);
+
+  /// Image of graph in log directory like images of dumpTree
+  /// @return File name of image, it is valid until next image, or nullptr
+  char *createGraphImage(const void *graph, graphGenerator_t generator);
+
   void do_dumpTree(
                    const Tree *tree,
                    unsigned error,
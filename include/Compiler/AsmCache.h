@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdio.h>
+#include "Tree.h"
+
+namespace db {
+
+  /// Generated code of one function
+  struct AsmChunk {
+    hash_t hash;
+    char  *name;
+    char  *text;
+    size_t size;
+    bool   isUsed;
+  };
+
+  /// Cache of generated functions between compilations
+  /// @note Chunk is valid while hash of function and environment is same
+  struct AsmCache {
+    AsmChunk *chunks;
+    size_t size;
+    size_t capacity;
+
+    size_t hits;
+    size_t misses;
+
+    AsmCache &operator=(const AsmCache &original) = delete;
+  };
+
+  void initAsmCache(AsmCache *cache, int *error = nullptr);
+
+  void destroyAsmCache(AsmCache *cache, int *error = nullptr);
+
+  /// Load chunks from file created by saveAsmCache
+  void loadAsmCache(AsmCache *cache, FILE *source, int *error = nullptr);
+
+  /// Save only chunks which were used in the last compilation
+  void saveAsmCache(const AsmCache *cache, FILE *target, int *error = nullptr);
+
+  /// Search chunk of function and mark it as used
+  /// @note Name is compared too, so collision of hashes of different functions isn`t a hit
+  /// @return Chunk or nullptr if cache hasn`t it
+  const AsmChunk *searchAsmChunk(
+                                 AsmCache *cache,
+                                 hash_t hash,
+                                 const char *name,
+                                 int *error = nullptr
+                                );
+
+  /// Add chunk, cache takes ownership of text
+  bool addAsmChunk(
+                   AsmCache *cache,
+                   hash_t hash,
+                   const char *name,
+                   char *text,
+                   size_t size,
+                   int *error = nullptr
+                  );
+
+}
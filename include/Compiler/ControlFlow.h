@@ -0,0 +1,77 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdio.h>
+#include "StackIr.h"
+
+namespace db {
+
+  /// Index of absent block or location
+  const size_t CFG_NIL = (size_t)-1;
+
+  /// Straight code of IrCode, only its last instruction may jump
+  struct BasicBlock {
+    size_t start; ///< First instruction in IrCode
+    size_t end;   ///< Next instruction after block
+
+    size_t successors[2]; ///< Fall through and target of jump
+    size_t successorsSize;
+
+    size_t *predecessors;
+    size_t  predecessorsSize;
+    size_t  predecessorsCapacity;
+
+    size_t dominator; ///< Immediate dominator, CFG_NIL for entry and unreachable blocks
+
+    /// Flags of ControlFlow::locations
+    bool *use; ///< Read before written in block
+    bool *def; ///< Written in block
+    bool *liveIn;
+    bool *liveOut;
+  };
+
+  /// Graph of basic blocks of function with dominator tree and liveness
+  /// @note Locations are registers and words of frame relative to rdx, rcx-relative memory is
+  ///       the same word after PUSH rdx, POP rcx in one block, other memory isn`t tracked
+  struct ControlFlow {
+    const IrCode *code;
+
+    BasicBlock *blocks; ///< Entry is the first block
+    size_t size;
+    size_t capacity;
+
+    size_t *order; ///< Reverse postorder of reachable blocks
+    size_t  orderSize;
+
+    IrOperand *locations;
+    size_t     locationsSize;
+    size_t     locationsCapacity;
+
+    bool *sets; ///< Storage of flags of blocks
+
+    ControlFlow &operator=(const ControlFlow &original) = delete;
+  };
+
+  /// Find blocks and edges, then dominators and liveness of locations by iterations
+  /// @note Code must be alive until flow is destroyed
+  void buildControlFlow(ControlFlow *flow, const IrCode *code, int *error = nullptr);
+
+  void destroyControlFlow(ControlFlow *flow, int *error = nullptr);
+
+  /// @return Block of instruction or CFG_NIL
+  size_t searchBlock(const ControlFlow *flow, size_t instruction);
+
+  /// @return Index in flow->locations or CFG_NIL if operand isn`t location
+  size_t searchLocation(const ControlFlow *flow, const IrOperand *operand);
+
+  /// Every path from entry to block goes through dominator, block dominates itself
+  bool isDominator(const ControlFlow *flow, size_t dominator, size_t block);
+
+  bool isLiveIn (const ControlFlow *flow, size_t block, const IrOperand *location);
+
+  bool isLiveOut(const ControlFlow *flow, size_t block, const IrOperand *location);
+
+  /// Write blocks, dominators and liveness and image of graph
+  void dumpControlFlow(const ControlFlow *flow, FILE *target, int *error = nullptr);
+
+}
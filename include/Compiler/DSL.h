@@ -51,6 +51,7 @@
 #define IS_START_BRACE(NODE) IS_IT_STATEMENT(NODE, START_BRACE)
 #define IS_END_BRACE(NODE)   IS_IT_STATEMENT(NODE, END_BRACE  )
 #define IS_RETURN(NODE)      IS_IT_STATEMENT(NODE, RETURN     )
+#define IS_CALL(NODE)        IS_IT_STATEMENT(NODE, CALL       )
 #define IS_FUN(NODE)         IS_IT_STATEMENT(NODE, FUN        )
 #define IS_TYPE(NODE)        IS_IT_STATEMENT(NODE, TYPE       )
 #define IS_VOID(NODE)        IS_IT_STATEMENT(NODE, VOID       )
@@ -80,6 +81,7 @@
 #define IS_PARAM(NODE)       IS_IT_STATEMENT(NODE, PARAMETER  )
 #define IS_TAN(NODE)         IS_IT_STATEMENT(NODE, TAN        )
 #define IS_DIFF(NODE)        IS_IT_STATEMENT(NODE, DIFF       )
+#define IS_POW(NODE)         IS_IT_STATEMENT(NODE, POW        )
 
 #define IS_NUM(NODE)       (NODE->type == db::type_t::NUMBER   )
 #define IS_STATEMENT(NODE) (NODE->type == db::type_t::STATEMENT)
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <stddef.h>
+#include "Tree.h"
+
+namespace db {
+
+  /// Index of absent operand
+  const size_t DAG_NIL = (size_t)-1;
+
+  /// Node of expression DAG, operands are indices in ExpressionDag::nodes
+  struct DagNode {
+    type_t      type;
+    treeValue_t value;
+    size_t      left;
+    size_t      right;
+    hash_t      hash;
+  };
+
+  /// Memoized derivative of node by variable
+  struct DagDerivative {
+    size_t      node;
+    const char *variable;
+    size_t      derivative;
+  };
+
+  /// Hash-consed expression graph: equal subexpressions are one node
+  struct ExpressionDag {
+    DagNode *nodes;
+    size_t size;
+    size_t capacity;
+
+    size_t *table; ///< Open addressing set of nodes
+    size_t  tableCapacity;
+
+    DagDerivative *derivatives; ///< Open addressing map (node, variable) -> derivative
+    size_t derivativesSize;
+    size_t derivativesCapacity;
+
+    ExpressionDag &operator=(const ExpressionDag &original) = delete;
+  };
+
+  void initExpressionDag(ExpressionDag *dag, int *error = nullptr);
+
+  void destroyExpressionDag(ExpressionDag *dag, int *error = nullptr);
+
+  /// Add expression, DIFF statements are replaced by derivatives
+  /// @return Index of node or DAG_NIL if expression can`t be differentiated
+  /// @note Variable of DIFF is the first name in its argument
+  size_t addExpression(ExpressionDag *dag, const TreeNode *token, int *error = nullptr);
+
+  /// Derivative of node, memoized per (node, variable)
+  size_t differentiate(ExpressionDag *dag, size_t node, const char *variable, int *error = nullptr);
+
+  /// Count references of nodes reachable from node
+  /// @param [out] references Array of dag->size zeros
+  void countReferences(const ExpressionDag *dag, size_t node, size_t *references, int *error = nullptr);
+
+  /// Create tree from node, shared nodes are copied
+  /// @param [in] names Names of nodes bound to values (may be nullptr), operands
+  /// with name become NAME nodes
+  TreeNode *createTree(
+                       const ExpressionDag *dag,
+                       size_t node,
+                       char *const *names = nullptr,
+                       int *error = nullptr
+                      );
+
+}
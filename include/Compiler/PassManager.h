@@ -0,0 +1,74 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdio.h>
+#include "Translator.h"
+
+namespace db {
+
+  /// Pipeline of MiddleEnd if -passes isn`t set
+  const char * const DEFAULT_PIPELINE = "fold,tail,inline,[const,pure],dce,licm,cse,strength";
+
+  /// Pipelines of levels of optimizations, index is level
+  /// -O0 - only fold, it expands derivatives, which backend can`t translate
+  /// -O1 - local passes, which are linear in size of tree
+  /// -O2 - DEFAULT_PIPELINE, interprocedural and loop passes too
+  const char * const LEVEL_PIPELINES[] = {
+    "fold",
+    "fold,const,dce,strength",
+    DEFAULT_PIPELINE,
+  };
+
+  /// Maximal count of runs of fixpoint group, tree is left as it is after them
+  const size_t MAX_FIXPOINT_ITERATIONS = 16;
+
+  typedef void (*pass_t)(Translator *translator, int *error);
+
+  /// Named transformation of tree
+  struct Pass {
+    const char *name;
+    const char *description;
+    pass_t      run;
+  };
+
+  /// Element of parsed pipeline
+  struct PipelineStep {
+    const Pass *pass;      ///< nullptr for fixpoint group
+    size_t      groupSize; ///< Count of next steps in group, they are repeated while tree changes
+  };
+
+  struct PassStatistics {
+    size_t    runs;
+    size_t    changes;    ///< Runs which changed tree
+    double    seconds;    ///< Wall time of all runs
+    long long nodesDelta; ///< Sum of changes of node count
+  };
+
+  struct PassManager {
+    PipelineStep *steps;
+    size_t size;
+    size_t capacity;
+
+    PassStatistics *statistics; ///< Indexed like registry of passes
+
+    size_t groupRuns;
+    size_t groupLimits; ///< Groups stopped by MAX_FIXPOINT_ITERATIONS
+
+    PassManager &operator=(const PassManager &original) = delete;
+  };
+
+  /// Parse pipeline like "fold,[const,pure],dce", [] is group repeated until fixpoint
+  /// @param [in] pipeline Specification or nullptr for DEFAULT_PIPELINE
+  void initPassManager(PassManager *manager, const char *pipeline, int *error = nullptr);
+
+  void destroyPassManager(PassManager *manager, int *error = nullptr);
+
+  void runPasses(PassManager *manager, Translator *translator, int *error = nullptr);
+
+  /// Write time and node count delta of every pass
+  void dumpPassReport(const PassManager *manager, FILE *target, int *error = nullptr);
+
+  /// Write names and descriptions of registered passes
+  void dumpPasses(FILE *target, int *error = nullptr);
+
+}
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdio.h>
+
+namespace db {
+
+  /// Instructions of VM and pseudo instructions of listing
+  enum class Opcode {
+    PUSH,
+    POP,
+    ADD,
+    SUB,
+    MUL,
+    DIV,
+    POW,
+    SIN,
+    COS,
+    TAN,
+    SQRT,
+    AND,
+    OR,
+    NEQL,
+    EQL,
+    LESS,
+    GREATER,
+    SWAP,
+    JMP,
+    JE,  ///< Conditional jumps compare number on top with number below it,
+    JNE, ///< so JB jumps if top < below like LESS
+    JB,
+    JA,
+    JBE,
+    JAE,
+    CALL,
+    RET,
+    IN,
+    OUT,
+    SHOW, ///< String from video memory up to zero
+    HLT,
+
+    LABEL,   ///< Definition of label of operand
+    COMMENT, ///< Line of listing, it isn`t executed
+  };
+
+  enum class Register {
+    NONE,
+    RAX,
+    RBX,
+    RCX,
+    RDX,
+    REX,
+    RFX,
+  };
+
+  enum class OperandType {
+    None,
+    Immediate, ///< value
+    Register,  ///< base
+    Memory,    ///< [value] or [value+base]
+    Label,     ///< prefix_name or prefix_name_value
+  };
+
+  struct IrOperand {
+    OperandType type;
+    int         value;
+    Register    base;
+    const char *prefix; ///< Kind of label like FUN, ELSE or WHILE
+    const char *name;   ///< Namespace of label, name of function
+  };
+
+  struct IrInstruction {
+    Opcode      opcode;
+    IrOperand   operand;
+    const char *comment; ///< Text of COMMENT or note after instruction, may be nullptr
+                         ///< @note Operand of COMMENT is written after its text
+  };
+
+  /// Linear code of function or of global initialization
+  struct IrCode {
+    IrInstruction *instructions;
+    size_t size;
+    size_t capacity;
+
+    bool isFailed; ///< Some instruction wasn`t emitted, like ferror of stream
+
+    IrCode &operator=(const IrCode &original) = delete;
+  };
+
+  /// Label without number, it is unique itself like FUN_main
+  const int NO_LABEL_NUMBER = -1;
+
+  /// Binary of VM: ObjectHeader, then words of code
+  /// Instruction is word of opcode | operand type << 8 | register << 16
+  /// and word of value if it has operand, address of label is index of word
+  const char OBJECT_SIGNATURE[] = "DBVM";
+  const int  OBJECT_VERSION     = 1;
+
+  struct ObjectHeader {
+    char signature[4];
+    int  version;
+    int  size; ///< Count of words of code
+  };
+
+  void initIr(IrCode *code, int *error = nullptr);
+
+  void destroyIr(IrCode *code, int *error = nullptr);
+
+  bool emitIr(
+              IrCode *code,
+              Opcode opcode,
+              IrOperand operand = {},
+              const char *comment = nullptr,
+              int *error = nullptr
+             );
+
+  IrOperand immediateOperand(int value);
+
+  IrOperand registerOperand(Register reg);
+
+  IrOperand memoryOperand(int address, Register base = Register::NONE);
+
+  IrOperand labelOperand(const char *prefix, const char *name, int number = NO_LABEL_NUMBER);
+
+  bool isSameOperand(const IrOperand *first, const IrOperand *second);
+
+  const char *getOpcodeName(Opcode opcode);
+
+  const char *getRegisterName(Register reg);
+
+  /// Rewrite short sequences of instructions by rules until none of them is applicable
+  /// @note Labels are kept, so code isn`t changed across targets of jumps
+  void optimizePeephole(IrCode *code, int *error = nullptr);
+
+  /// Keep the most used words of frame in free registers, linear scan over intervals of them
+  /// @note Convention: rax, rbx and rfx are caller-saved and are spilled around calls,
+  ///       rax and rbx hold return value after CALL, so they are reloaded after it is pushed,
+  ///       rdx is saved by caller, rcx is restored by callee, rex is 1 between statements
+  void allocateRegisters(IrCode *code, int *error = nullptr);
+
+  /// Write hit counts of peephole rules
+  void dumpPeepholeStatistics(FILE *target, int *error = nullptr);
+
+  /// Copy instructions of source to the end of code
+  void appendIr(IrCode *code, const IrCode *source, int *error = nullptr);
+
+  /// Write code as text of assembler
+  void printIr(const IrCode *code, FILE *target, int *error = nullptr);
+
+  void printInstruction(const IrInstruction *instruction, FILE *target, int *error = nullptr);
+
+  /// Write binary of VM, labels are resolved by fixups after the whole code
+  /// @param [in] listing Addresses, words and text of instructions or nullptr
+  void assembleIr(const IrCode *code, FILE *target, FILE *listing = nullptr, int *error = nullptr);
+
+  void printOperand(const IrOperand *operand, FILE *target, int *error = nullptr);
+
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stdio.h>
+#include "Tree.h"
+#include "StringPool.h"
+
+namespace db {
+
+  /// Check first byte of stream without reading it
+  /// @param [in] source Stream with tree, may be unseekable
+  /// @return Is tree in stream saved by saveBinaryTree
+  bool isBinaryTree(FILE *source);
+
+  /// Save tree in compact format
+  /// @param [in] root Root of tree
+  /// @param [in] target Stream for write
+  /// @param [in] isPacked Compress blocks of data
+  /// @return Count of written bytes
+  size_t saveBinaryTree(const TreeNode *root, FILE *target, bool isPacked, int *error = nullptr);
+
+  /// Load tree saved by saveBinaryTree
+  /// @param [in] source Stream for read, stream is read only up to the end of tree
+  /// @param [in] pool Pool for names and strings
+  /// @param [out] bytes Count of read bytes, may be nullptr
+  /// @return Root of tree or nullptr if was error
+  TreeNode *loadBinaryTree(FILE *source, StringPool *pool, size_t *bytes = nullptr, int *error = nullptr);
+
+}
@@ -10,6 +10,7 @@ namespace db {
     int number;
     bool isConst;
     bool isGlobal;
+    bool isIntegral; ///< Only int word of local is used, see inferIntegers
   };
 
   struct VarTable {
@@ -4,6 +4,7 @@
 #include <stddef.h>
 #include <stdio.h>
 #include "Stack.h"
+#include "AsmCache.h"
 
 namespace db {
 
@@ -15,11 +16,43 @@ namespace db {
     None,
   };
 
+  /// Format of tree for saveTranslator, loadTranslator detects it itself
+  enum class TreeFormat {
+    Text,
+    Binary, ///< See SyntaxBinary.h
+    Packed, ///< Binary with compressed blocks
+  };
+
+  /// Declarations of locals of function whose values are proved to be integral
+  struct IntegerTypes {
+    Token *declarations;
+    size_t size;
+    size_t capacity;
+  };
+
   struct TranslatorStatus {
     const char *sourceName;
     ReturnType returnType;
     bool hasMain;
     int stackOffset;
+
+    const char *functionName; ///< Namespace of labels of current function
+    int ifCount;
+    int whileCount;
+    int skipCount; ///< Labels of short-circuit conditions
+
+    int blockCount;       ///< Blocks of current function, see allocateVariable
+    int variableCount;    ///< Words of locals of current scopes, see allocateVariable
+    int maxVariableCount; ///< Most of words of locals, which are visible together
+
+    AsmCache *cache; ///< Generated functions of previous compilation or nullptr
+
+    int optimizationLevel; ///< Selects lowering strategies of backend, 0 is naive code
+    int threadCount;       ///< Workers of code generation of functions, 0 is count of processors
+
+    IntegerTypes integers; ///< Locals of current function, which are kept as single words
+
+    TreeFormat format;
   };
 
   struct Translator {
@@ -43,6 +76,43 @@ namespace db {
 
   void simplyGrammar(Translator *translator, int *error = nullptr);
 
+  /// Value of operator with numeric operands
+  /// @param [in] right Right operand or nullptr for unary form like -left
+  /// @return false if operator can not be calculated or value is undefined
+  bool calculateStatement(statement_t statement, number_t left, const number_t *right, number_t *result);
+
+  /// Replace self calls in tail position by assignments of parameters in loop
+  void eliminateTailCalls(Translator *translator, int *error = nullptr);
+
+  /// Replace calls of small and once called functions by their code
+  void inlineFunctions(Translator *translator, int *error = nullptr);
+
+  /// Substitute values of never assigned variables with constant initializers and fold them
+  void propagateConstants(Translator *translator, int *error = nullptr);
+
+  /// Replace calls of pure functions with numeric arguments by their values
+  void evaluatePureCalls(Translator *translator, int *error = nullptr);
+
+  /// Compute expressions of loops, whose operands are not changed in them, before loops
+  void hoistLoopInvariants(Translator *translator, int *error = nullptr);
+
+  /// Bind repeated arithmetic expressions of blocks to compiler-generated locals
+  void eliminateCommonSubexpressions(Translator *translator, int *error = nullptr);
+
+  /// Replace small powers, doublings and divisions by exact constants with cheaper operators of VM
+  void reduceStrength(Translator *translator, int *error = nullptr);
+
+  /// Remove constant branches, commands after return and functions unreachable from main
+  void eliminateDeadCode(Translator *translator, int *error = nullptr);
+
+  /// Find locals of function, which are assigned only integral values
+  /// @note Integers are numbers without fraction, sums, differences and products of them and int()
+  void inferIntegers(const Function *function, IntegerTypes *types, int *error = nullptr);
+
+  bool isIntegerDeclaration(const IntegerTypes *types, const Token declaration);
+
+  void destroyIntegerTypes(IntegerTypes *types, int *error = nullptr);
+
   void saveGrammary(const Translator *translator, FILE *target, int *error = nullptr);
 
   void initTranslator(Translator *translator, int *error = nullptr);
@@ -70,8 +140,13 @@ namespace db {
                         int *error = nullptr
                        );
 
+  /// Functions are generated by status.threadCount workers, output doesn`t depend on it
   bool translate(Translator *translator, FILE *target, int *error = nullptr);
 
+  /// Write binary of VM instead of text of assembler, cache of chunks isn`t used
+  /// @param [in] listing Listing of binary or nullptr
+  bool translateObject(Translator *translator, FILE *target, FILE *listing = nullptr, int *error = nullptr);
+
   bool addFunction(
                    const char *name,
                    Token function,
@@ -16,6 +16,31 @@ enum FiofunctionsError {
 /// @return Size of buffer in heap or error`s code
 size_t readFile(char **buffer, const char *filename);
 
+/// Read whole stream in buffer
+/// @param [out] buffer Address of pointer to buffer
+/// @param [in] stream Stream which need to read, may be unseekable (pipe)
+/// @return Size of buffer in heap or error`s code
+size_t readStream(char **buffer, FILE *stream);
+
+/// Name of standard stream in command line
+const char *const STANDARD_STREAM_NAME = "-";
+
+/// Check that name means stdin/stdout
+/// @param [in] fileName Name of file
+/// @return Is it STANDARD_STREAM_NAME
+bool isStandardStream(const char *fileName);
+
+/// Open file or get standard stream
+/// @param [in] fileName Name of file or STANDARD_STREAM_NAME
+/// @param [in] mode Mode for fopen, stdin is returned for read modes and stdout for others
+/// @return Stream or nullptr if fail to open file
+FILE *openStream(const char *fileName, const char *mode);
+
+/// Close stream from openStream
+/// @param [in] stream Stream for close
+/// @note Standard streams are only flushed
+void closeStream(FILE *stream);
+
 /// Read bin file to buffer
 /// @param [out] buffer Buffer for write
 /// @param [in] size elementSize Size of one element
@@ -20,6 +20,10 @@ static char *toString(db::treeValue_t value, db::type_t type);
 
 static char *generateDotFile(const db::Tree *tree, int isDump);
 
+/// Convert dot file to png with the same name
+/// @return Name of image or nullptr
+static char *renderImage(char *dotFileName);
+
 static char *generateNewFileName();
 
 static void openDigraph(FILE *file);
@@ -36,7 +40,38 @@ char *db::createImage(const db::Tree *tree, int isDump)
 {
   assert(tree);
 
-  char *dotFileName = generateDotFile(tree, isDump);
+  return renderImage(generateDotFile(tree, isDump));
+}
+
+char *db::createGraphImage(const void *graph, db::graphGenerator_t generator)
+{
+  assert(generator);
+
+  char *fileName = generateNewFileName();
+
+  if (!fileName)
+    return nullptr;
+
+  FILE *file = fopen(fileName, "w");
+
+  if (!file)
+    return nullptr;
+
+  openDigraph(file);
+
+  generator(graph, file);
+
+  closeDigraph(file);
+
+  fclose(file);
+
+  return renderImage(fileName);
+}
+
+static char *renderImage(char *dotFileName)
+{
+  if (!dotFileName)
+    return nullptr;
 
   size_t size = strlen(dotFileName);
 
@@ -0,0 +1,82 @@
+#include "Tree.h"
+
+#include <string.h>
+
+const db::hash_t FNV_OFFSET = 0xcbf29ce484222325ull;
+const db::hash_t FNV_PRIME  = 0x00000100000001b3ull;
+
+/// Marker of empty child, so (a (b)) and ((a) b) have different hashes
+const unsigned char NIL_MARKER = 0xff;
+
+db::hash_t db::combineHash(db::hash_t hash, const void *data, size_t size)
+{
+  const unsigned char *bytes = (const unsigned char *)data;
+
+  for (size_t i = 0; i < size; ++i)
+    {
+      hash ^= bytes[i];
+      hash *= FNV_PRIME;
+    }
+
+  return hash;
+}
+
+db::hash_t db::hashNode(const db::TreeNode *node, db::hash_t seed)
+{
+  db::hash_t hash = seed ? seed : FNV_OFFSET;
+
+  if (!node)
+    return combineHash(hash, &NIL_MARKER, sizeof(NIL_MARKER));
+
+  hash = combineHash(hash, &node->type, sizeof(node->type));
+
+  switch (node->type)
+    {
+    case db::type_t::STATEMENT:
+      hash = combineHash(hash, &node->value.statement, sizeof(node->value.statement));
+      break;
+    case db::type_t::NUMBER:
+      hash = combineHash(hash, &node->value.number, sizeof(node->value.number));
+      break;
+    case db::type_t::NAME:
+    case db::type_t::STRING:
+      if (node->value.name)
+        hash = combineHash(hash, node->value.name, strlen(node->value.name) + 1);
+      break;
+    default: break;
+    }
+
+  hash = hashNode(node->left , hash);
+  hash = hashNode(node->right, hash);
+
+  return hash;
+}
+
+bool db::isSameNode(const db::TreeNode *first, const db::TreeNode *second)
+{
+  if (!first || !second) return first == second;
+
+  if (first->type != second->type) return false;
+
+  switch (first->type)
+    {
+    case db::type_t::STATEMENT:
+      if (first->value.statement != second->value.statement) return false;
+      break;
+    case db::type_t::NUMBER:
+      if (!db::compareNumber(first->value.number, second->value.number)) return false;
+      break;
+    case db::type_t::NAME:
+    case db::type_t::STRING:
+      if (!first->value.name || !second->value.name)
+        {
+          if (first->value.name != second->value.name) return false;
+        }
+      else if (strcmp(first->value.name, second->value.name)) return false;
+      break;
+    default: return false;
+    }
+
+  return isSameNode(first->left , second->left ) &&
+         isSameNode(first->right, second->right);
+}
@@ -142,3 +142,23 @@ void db::removeNode(db::TreeNode *node, int *error)
   */
   free(node);
 }
+
+size_t db::countNodes(const db::TreeNode *node)
+{
+  if (!node) return 0;
+
+  return 1 + countNodes(node->left) + countNodes(node->right);
+}
+
+bool db::isPureNode(const db::TreeNode *node)
+{
+  if (!node) return true;
+
+  if (node->type == db::type_t::STATEMENT &&
+      (node->value.statement == db::STATEMENT_CALL       ||
+       node->value.statement == db::STATEMENT_ASSIGNMENT ||
+       node->value.statement == db::STATEMENT_IN))
+    return false;
+
+  return isPureNode(node->left) && isPureNode(node->right);
+}
@@ -0,0 +1,158 @@
+#include "AsmCache.h"
+
+#include <malloc.h>
+#include <string.h>
+#include "SystemLike.h"
+#include "ErrorHandler.h"
+#include "Error.h"
+
+const int GROWTH_FACTOR = 2;
+
+/// Width of names in scanf, db::MAX_NAME_SIZE of Tree.h is too short for it
+#define CHUNK_NAME_WIDTH 255
+#define WIDTH_STRING(WIDTH) #WIDTH
+#define WIDTH_FORMAT(WIDTH) "%" WIDTH_STRING(WIDTH) "s"
+
+const int MAX_CHUNK_NAME_SIZE = CHUNK_NAME_WIDTH + 1;
+
+const char *const CHUNK_HEADER = ";chunk";
+
+void db::initAsmCache(db::AsmCache *cache, int *error)
+{
+  if (!cache) ERROR();
+
+  cache->chunks   = nullptr;
+  cache->size     = 0;
+  cache->capacity = 0;
+
+  cache->hits   = 0;
+  cache->misses = 0;
+}
+
+void db::destroyAsmCache(db::AsmCache *cache, int *error)
+{
+  if (!cache) ERROR();
+
+  for (size_t i = 0; i < cache->size; ++i)
+    {
+      free(cache->chunks[i].name);
+      free(cache->chunks[i].text);
+    }
+  free(cache->chunks);
+
+  cache->chunks   = nullptr;
+  cache->size     = 0;
+  cache->capacity = 0;
+}
+
+void db::loadAsmCache(db::AsmCache *cache, FILE *source, int *error)
+{
+  if (!cache || !source) ERROR();
+
+  char header[MAX_CHUNK_NAME_SIZE] = "";
+  char name  [MAX_CHUNK_NAME_SIZE] = "";
+  db::hash_t hash = 0;
+  size_t size = 0;
+
+  while (fscanf(source,
+                WIDTH_FORMAT(CHUNK_NAME_WIDTH) " %llx %zu " WIDTH_FORMAT(CHUNK_NAME_WIDTH),
+                header, &hash, &size, name) == 4)
+    {
+      if (strcmp(header, CHUNK_HEADER) || getc(source) != '\n')
+        {
+          handleWarning("Cache is corrupted, it will be rebuilt");
+          break;
+        }
+
+      char *text = (char *)calloc(size + 1, sizeof(char));
+      if (!text) ERROR();
+
+      if (fread(text, sizeof(char), size, source) != size)
+        {
+          free(text);
+          handleWarning("Cache is corrupted, it will be rebuilt");
+          break;
+        }
+
+      if (!db::addAsmChunk(cache, hash, name, text, size))
+        ERROR();
+    }
+
+  for (size_t i = 0; i < cache->size; ++i)
+    cache->chunks[i].isUsed = false;
+}
+
+void db::saveAsmCache(const db::AsmCache *cache, FILE *target, int *error)
+{
+  if (!cache || !target) ERROR();
+
+  for (size_t i = 0; i < cache->size; ++i)
+    {
+      const db::AsmChunk *chunk = cache->chunks + i;
+
+      if (!chunk->isUsed) continue;
+
+      fprintf(target, "%s %016llx %zu %s\n",
+              CHUNK_HEADER, chunk->hash, chunk->size, chunk->name);
+      fwrite(chunk->text, sizeof(char), chunk->size, target);
+    }
+}
+
+const db::AsmChunk *db::searchAsmChunk(
+                                       db::AsmCache *cache,
+                                       db::hash_t hash,
+                                       const char *name,
+                                       int *error
+                                      )
+{
+  if (!cache || !name) ERROR(nullptr);
+
+  for (size_t i = 0; i < cache->size; ++i)
+    if (cache->chunks[i].hash == hash && !strcmp(cache->chunks[i].name, name))
+      {
+        cache->chunks[i].isUsed = true;
+        ++cache->hits;
+
+        return cache->chunks + i;
+      }
+
+  ++cache->misses;
+
+  return nullptr;
+}
+
+bool db::addAsmChunk(
+                     db::AsmCache *cache,
+                     db::hash_t hash,
+                     const char *name,
+                     char *text,
+                     size_t size,
+                     int *error
+                    )
+{
+  if (!cache || !name || !text) ERROR(false);
+
+  if (cache->size == cache->capacity)
+    {
+      cache->capacity = GROWTH_FACTOR*cache->capacity + 1;
+      db::AsmChunk *temp =
+        (db::AsmChunk *)recalloc(
+                                 cache->chunks,
+                                 cache->capacity,
+                                 sizeof(db::AsmChunk)
+                                );
+      if (!temp) { free(text); ERROR(false); }
+
+      cache->chunks = temp;
+    }
+
+  cache->chunks[cache->size++] = {
+    .hash   = hash,
+    .name   = strdup(name),
+    .text   = text,
+    .size   = size,
+    .isUsed = true,
+  };
+
+  return true;
+}
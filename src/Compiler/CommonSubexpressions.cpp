@@ -0,0 +1,487 @@
+#include "Translator.h"
+
+#include <stdio.h>
+#include <malloc.h>
+#include "DSL.h"
+#include "Assert.h"
+#include "SystemLike.h"
+#include "Logging.h"
+#include "Error.h"
+
+#pragma GCC diagnostic ignored "-Wswitch-enum"
+
+/// Instructions of backend for one number: PUSH pair of load or POP pair of store
+const size_t NUMBER_COST = 2;
+
+const int GROWTH_FACTOR = 2;
+
+/// Expression of block with its repeats
+struct Expression {
+  db::Token  token;   ///< First occurrence
+  db::Token  command; ///< Command of block with first occurrence
+  db::hash_t hash;
+  size_t     cost;    ///< Instructions of one computation
+  size_t     count;
+  bool       isAlive; ///< Operands are not changed after first occurrence
+};
+
+struct Occurrence {
+  db::Token token;
+  size_t    expression;
+};
+
+struct CseState {
+  Expression *expressions;
+  size_t      expressionsSize;
+  size_t      expressionsCapacity;
+
+  Occurrence *occurrences;
+  size_t      occurrencesSize;
+  size_t      occurrencesCapacity;
+
+  const char **writes; ///< Names changed by current statement
+  size_t       writesSize;
+  size_t       writesCapacity;
+  bool         hasCall;
+
+  size_t eliminated;
+  size_t values;
+  size_t saved;
+  size_t countOfNames;
+};
+
+static bool eliminateInCode(db::Translator *translator, CseState *state, db::Token code);
+
+/// Bind repeated expressions of block while it is profitable, then process nested blocks
+static bool eliminateInBlock(db::Translator *translator, CseState *state, db::Token block);
+
+static bool collectBlock(CseState *state, db::Token block);
+
+/// @return Is token a candidate or an operand of candidate
+static bool collectOccurrences(CseState *state, db::Token token, db::Token command, bool *isCandidateToken);
+
+static bool pushOccurrence(CseState *state, db::Token token, db::Token command);
+
+static bool collectWrites(CseState *state, const db::Token token);
+
+static bool pushWrite(CseState *state, const char *name);
+
+static void killExpressions(CseState *state);
+
+static bool isRead(const db::Token token, const char *name);
+
+static bool hasCall(const db::Token token);
+
+static bool isCandidate(const db::Token token);
+
+/// Count of backend instructions of expression
+static size_t calculateCost(const db::Token token);
+
+/// Instructions saved by binding of expression
+static size_t calculateBenefit(const Expression *expression);
+
+static bool bindExpression(db::Translator *translator, CseState *state, size_t index);
+
+/// Name of value, which isn`t used by tree yet, names of previous runs are in pool
+static char *createName(db::Translator *translator, CseState *state);
+
+void db::eliminateCommonSubexpressions(db::Translator *translator, int *error)
+{
+  if (!translator || !translator->grammar.root) ERROR();
+
+  CseState state{};
+
+  bool isOk = true;
+
+  for (db::Token token = translator->grammar.root; token && isOk; token = token->right)
+    if (IS_FUN(token->left))
+      isOk = eliminateInCode(translator, &state, token->left->right);
+
+  free(state.expressions);
+  free(state.occurrences);
+  free(state.writes);
+
+  if (!isOk) ERROR();
+
+  FILE *log = getLogFile();
+  if (!log) return;
+
+  fprintf(log, "<pre>Common subexpressions: %zu eliminated, %zu values, "
+          "%zu asm instructions saved</pre>\n",
+          state.eliminated, state.values, state.saved);
+}
+
+static bool eliminateInCode(db::Translator *translator, CseState *state, db::Token code)
+{
+  assert(translator);
+  assert(state);
+
+  if (!code || !IS_COMP(code)) return true;
+
+  return eliminateInBlock(translator, state, code);
+}
+
+static bool eliminateInBlock(db::Translator *translator, CseState *state, db::Token block)
+{
+  assert(translator);
+  assert(state);
+  assert(block);
+
+  while (true)
+    {
+      if (!collectBlock(state, block)) return false;
+
+      size_t best    = 0;
+      size_t benefit = 0;
+
+      for (size_t i = 0; i < state->expressionsSize; ++i)
+        {
+          size_t current = calculateBenefit(state->expressions + i);
+          if (current > benefit) { best = i; benefit = current; }
+        }
+
+      if (!benefit) break;
+
+      if (!bindExpression(translator, state, best)) return false;
+    }
+
+  for (db::Token command = block; command; command = command->right)
+    {
+      db::Token statement = command->left;
+      bool isOk = true;
+
+      if (IS_IF(statement) && IS_ELSE(statement->right))
+        isOk = eliminateInCode(translator, state, statement->right->left ) &&
+               eliminateInCode(translator, state, statement->right->right);
+      else if (IS_IF(statement) || IS_WHILE(statement))
+        isOk = eliminateInCode(translator, state, statement->right);
+      else if (IS_COMP(statement))
+        isOk = eliminateInCode(translator, state, statement);
+
+      if (!isOk) return false;
+    }
+
+  return true;
+}
+
+static bool collectBlock(CseState *state, db::Token block)
+{
+  assert(state);
+  assert(block);
+
+  state->expressionsSize = 0;
+  state->occurrencesSize = 0;
+
+  bool isCandidateToken = false;
+
+  for (db::Token command = block; command; command = command->right)
+    {
+      db::Token statement = command->left;
+      if (!statement) continue;
+
+      if (IS_ASSIGN(statement) || IS_VAR(statement) || IS_VAL(statement))
+        {
+          if (!hasCall(statement) &&
+              !collectOccurrences(state, statement->right, command, &isCandidateToken))
+            return false;
+        }
+      else if (IS_RETURN(statement) || IS_IF(statement))
+        {
+          if (!hasCall(statement->left) &&
+              !collectOccurrences(state, statement->left, command, &isCandidateToken))
+            return false;
+        }
+      else if (IS_OUT(statement) && !hasCall(statement))
+        {
+          for (db::Token parameter = statement->left; parameter; parameter = parameter->right)
+            if (!collectOccurrences(state, parameter->left, command, &isCandidateToken))
+              return false;
+        }
+
+      state->writesSize = 0;
+      state->hasCall    = false;
+
+      if (!collectWrites(state, statement)) return false;
+
+      killExpressions(state);
+    }
+
+  return true;
+}
+
+static bool collectOccurrences(CseState *state, db::Token token, db::Token command, bool *isCandidateToken)
+{
+  assert(state);
+  assert(command);
+  assert(isCandidateToken);
+
+  *isCandidateToken = false;
+
+  if (!token) return true;
+
+  if (IS_NAME(token) || IS_NUM(token))
+    {
+      *isCandidateToken = true;
+      return true;
+    }
+
+  bool isLeft  = false;
+  bool isRight = false;
+
+  if (!collectOccurrences(state, token->left , command, &isLeft )) return false;
+  if (!collectOccurrences(state, token->right, command, &isRight)) return false;
+
+  if (!isCandidate(token) || !isLeft || (token->right && !isRight)) return true;
+
+  *isCandidateToken = true;
+
+  return pushOccurrence(state, token, command);
+}
+
+static bool pushOccurrence(CseState *state, db::Token token, db::Token command)
+{
+  assert(state);
+  assert(token);
+  assert(command);
+
+  db::hash_t hash = db::hashNode(token);
+
+  size_t index = 0;
+  for ( ; index < state->expressionsSize; ++index)
+    {
+      Expression *expression = state->expressions + index;
+
+      if (expression->isAlive && expression->hash == hash &&
+          db::isSameNode(expression->token, token))
+        break;
+    }
+
+  if (index == state->expressionsSize)
+    {
+      if (state->expressionsSize == state->expressionsCapacity)
+        {
+          state->expressionsCapacity = GROWTH_FACTOR*state->expressionsCapacity + 1;
+          Expression *temp =
+            (Expression *)recalloc(state->expressions, state->expressionsCapacity, sizeof(Expression));
+          if (!temp) return false;
+
+          state->expressions = temp;
+        }
+
+      state->expressions[state->expressionsSize++] = {
+        .token   = token,
+        .command = command,
+        .hash    = hash,
+        .cost    = calculateCost(token),
+        .count   = 0,
+        .isAlive = true,
+      };
+    }
+
+  ++state->expressions[index].count;
+
+  if (state->occurrencesSize == state->occurrencesCapacity)
+    {
+      state->occurrencesCapacity = GROWTH_FACTOR*state->occurrencesCapacity + 1;
+      Occurrence *temp =
+        (Occurrence *)recalloc(state->occurrences, state->occurrencesCapacity, sizeof(Occurrence));
+      if (!temp) return false;
+
+      state->occurrences = temp;
+    }
+
+  state->occurrences[state->occurrencesSize++] = { .token = token, .expression = index };
+
+  return true;
+}
+
+static bool collectWrites(CseState *state, const db::Token token)
+{
+  assert(state);
+
+  if (!token) return true;
+
+  if (IS_CALL(token)) state->hasCall = true;
+
+  if ((IS_ASSIGN(token) || IS_VAR(token) || IS_VAL(token)) && token->left && IS_NAME(token->left))
+    if (!pushWrite(state, NAME(token->left))) return false;
+
+  if (IS_IN(token))
+    for (db::Token parameter = token->left; parameter; parameter = parameter->right)
+      if (parameter->left && IS_NAME(parameter->left) && !pushWrite(state, NAME(parameter->left)))
+        return false;
+
+  return collectWrites(state, token->left) && collectWrites(state, token->right);
+}
+
+static bool pushWrite(CseState *state, const char *name)
+{
+  assert(state);
+  assert(name);
+
+  if (state->writesSize == state->writesCapacity)
+    {
+      state->writesCapacity = GROWTH_FACTOR*state->writesCapacity + 1;
+      const char **temp =
+        (const char **)recalloc(state->writes, state->writesCapacity, sizeof(const char *));
+      if (!temp) return false;
+
+      state->writes = temp;
+    }
+
+  state->writes[state->writesSize++] = name;
+
+  return true;
+}
+
+static void killExpressions(CseState *state)
+{
+  assert(state);
+
+  for (size_t i = 0; i < state->expressionsSize; ++i)
+    {
+      Expression *expression = state->expressions + i;
+      if (!expression->isAlive) continue;
+
+      if (state->hasCall) { expression->isAlive = false; continue; }
+
+      for (size_t j = 0; j < state->writesSize && expression->isAlive; ++j)
+        if (isRead(expression->token, state->writes[j]))
+          expression->isAlive = false;
+    }
+}
+
+static bool isRead(const db::Token token, const char *name)
+{
+  assert(name);
+
+  if (!token) return false;
+
+  if (IS_NAME(token)) return db::compareStrings(NAME(token), name);
+
+  return isRead(token->left, name) || isRead(token->right, name);
+}
+
+static bool hasCall(const db::Token token)
+{
+  if (!token) return false;
+
+  if (IS_CALL(token) || IS_IN(token)) return true;
+
+  return hasCall(token->left) || hasCall(token->right);
+}
+
+static bool isCandidate(const db::Token token)
+{
+  assert(token);
+
+  if (!IS_STATEMENT(token)) return false;
+
+  switch (STATEMENT(token))
+    {
+    case db::STATEMENT_ADD:
+    case db::STATEMENT_SUB:
+    case db::STATEMENT_MUL:
+    case db::STATEMENT_DIV:
+    case db::STATEMENT_SIN:
+    case db::STATEMENT_COS:
+    case db::STATEMENT_TAN:
+    case db::STATEMENT_SQRT:
+    case db::STATEMENT_POW:
+      return token->left;
+    default: return false;
+    }
+}
+
+static size_t calculateCost(const db::Token token)
+{
+  if (!token) return 0;
+
+  if (!IS_STATEMENT(token)) return NUMBER_COST;
+
+  size_t cost = calculateCost(token->left) + calculateCost(token->right) + 1;
+
+  // Unary + and - push zero operand
+  if ((IS_ADD(token) || IS_SUB(token)) && !token->right) cost += NUMBER_COST;
+
+  return cost;
+}
+
+static size_t calculateBenefit(const Expression *expression)
+{
+  assert(expression);
+
+  if (expression->count < 2) return 0;
+
+  size_t removed = (expression->count - 1)*expression->cost;
+  size_t added   = NUMBER_COST*(expression->count + 1);
+
+  return removed > added ? removed - added : 0;
+}
+
+static bool bindExpression(db::Translator *translator, CseState *state, size_t index)
+{
+  assert(translator);
+  assert(state);
+  assert(index < state->expressionsSize);
+
+  Expression *expression = state->expressions + index;
+
+  char *string = createName(translator, state);
+  if (!string) return false;
+
+  db::Token value = db::createNode(expression->token);
+  if (!value) return false;
+
+  db::Token variable    = db::createNode({.name = string}, db::type_t::NAME);
+  db::Token declaration = (variable ? CREATE_STATEMENT(VAR, variable, value) : nullptr);
+
+  db::Token command = expression->command;
+  db::Token next    = (declaration ? CREATE_STATEMENT(COMPOUND, command->left, command->right) : nullptr);
+
+  if (!next)
+    {
+      if (declaration) db::removeNode(declaration);
+      else
+        {
+          if (variable) db::removeNode(variable);
+          db::removeNode(value);
+        }
+
+      return false;
+    }
+
+  db::setChildren(command, declaration, next);
+
+  for (size_t i = 0; i < state->occurrencesSize; ++i)
+    {
+      if (state->occurrences[i].expression != index) continue;
+
+      db::Token token = state->occurrences[i].token;
+
+      if (token->left ) db::removeNode(token->left );
+      if (token->right) db::removeNode(token->right);
+
+      token->type  = db::type_t::NAME;
+      token->value = {.name = string};
+      db::setChildren(token, nullptr, nullptr);
+    }
+
+  state->eliminated += expression->count - 1;
+  state->saved      += calculateBenefit(expression);
+  ++state->values;
+
+  return true;
+}
+
+static char *createName(db::Translator *translator, CseState *state)
+{
+  assert(translator);
+  assert(state);
+
+  char name[db::MAX_NAME_SIZE] = "";
+  do sprintf(name, "$cse_%zu", state->countOfNames++);
+  while (db::compareString(&translator->stringPool, name));
+
+  return db::addString(&translator->stringPool, name);
+}
@@ -0,0 +1,509 @@
+#include "Translator.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <malloc.h>
+#include "DSL.h"
+#include "Assert.h"
+#include "SystemLike.h"
+#include "Logging.h"
+#include "Error.h"
+
+const int GROWTH_FACTOR = 2;
+
+const size_t NO_BINDING = (size_t)-1;
+
+/// Declared variable, value or parameter
+struct Binding {
+  const char *name;
+  db::Token   declaration; ///< VAR or VAL, nullptr for parameters
+  bool        isAssigned;  ///< Target of assignment or in
+};
+
+/// Name read as value of binding
+struct Use {
+  db::Token token;
+  size_t    binding;
+};
+
+struct PropagationState {
+  Binding *bindings;
+  size_t   bindingsSize;
+  size_t   bindingsCapacity;
+
+  size_t *scope; ///< Indexes of visible bindings, inner are at the end
+  size_t  scopeSize;
+  size_t  scopeCapacity;
+
+  Use   *uses;
+  size_t usesSize;
+  size_t usesCapacity;
+
+  size_t substituted;
+  size_t removed;
+};
+
+static bool resolveProgram(PropagationState *state, db::Token root);
+
+static bool resolveBlock(PropagationState *state, db::Token block);
+
+/// Body of if, else or while is compound statement or single statement without braces
+static bool resolveBody(PropagationState *state, db::Token body);
+
+static bool resolveStatement(PropagationState *state, db::Token statement);
+
+static bool resolveExpression(PropagationState *state, db::Token token);
+
+static bool pushBinding(PropagationState *state, const char *name, db::Token declaration);
+
+static bool pushUse(PropagationState *state, db::Token token);
+
+static void markAssigned(PropagationState *state, const char *name);
+
+/// @return Index of innermost visible binding or NO_BINDING
+static size_t searchBinding(const PropagationState *state, const char *name);
+
+static bool isConstant(const Binding *binding);
+
+/// Replace reads of constant bindings by numbers
+/// @return Count of replaced names
+static size_t substituteUses(PropagationState *state);
+
+/// Remove declarations of constant bindings, their values are substituted everywhere
+static bool removeConstants(PropagationState *state, db::Token *root);
+
+/// @param [in] declarations Sorted array of declarations for removal
+static void removeDeclarations(
+                               PropagationState *state,
+                               const db::Token *declarations,
+                               size_t size,
+                               db::Token *block
+                              );
+
+/// Remove declarations in bodies of statement
+static void removeNestedDeclarations(
+                                     PropagationState *state,
+                                     const db::Token *declarations,
+                                     size_t size,
+                                     db::Token statement
+                                    );
+
+/// Single statement of body without braces is kept, only its nested bodies are visited
+static void removeBodyDeclarations(
+                                   PropagationState *state,
+                                   const db::Token *declarations,
+                                   size_t size,
+                                   db::Token *body
+                                  );
+
+static int compareTokens(const void *first, const void *second);
+
+void db::propagateConstants(db::Translator *translator, int *error)
+{
+  if (!translator || !translator->grammar.root) ERROR();
+
+  PropagationState state{};
+
+  bool isOk = true;
+  while (isOk)
+    {
+      state.bindingsSize = 0;
+      state.scopeSize    = 0;
+      state.usesSize     = 0;
+
+      isOk = resolveProgram(&state, translator->grammar.root);
+      if (!isOk) break;
+
+      size_t count = substituteUses(&state);
+      if (!count) break;
+
+      state.substituted += count;
+
+      int errorCode = 0;
+      db::simplyGrammar(translator, &errorCode);
+      isOk = !errorCode;
+    }
+
+  if (isOk) isOk = removeConstants(&state, &translator->grammar.root);
+
+  free(state.bindings);
+  free(state.scope);
+  free(state.uses);
+
+  if (!isOk) ERROR();
+
+  FILE *log = getLogFile();
+  if (!log) return;
+
+  fprintf(log, "<pre>Constant propagation: %zu names substituted, %zu declarations removed</pre>\n",
+          state.substituted, state.removed);
+}
+
+static bool resolveProgram(PropagationState *state, db::Token root)
+{
+  assert(state);
+
+  for (db::Token token = root; token; token = token->right)
+    {
+      db::Token declaration = token->left;
+
+      if ((IS_VAR(declaration) || IS_VAL(declaration)) &&
+          !pushBinding(state, NAME(declaration->left), declaration))
+        return false;
+    }
+
+  size_t global = 0;
+  for (db::Token token = root; token; token = token->right)
+    {
+      db::Token declaration = token->left;
+      if (!IS_VAR(declaration) && !IS_VAL(declaration)) continue;
+
+      size_t usesSize = state->usesSize;
+      if (!resolveExpression(state, declaration->right)) return false;
+
+      // Globals are initialized in order, the next ones are zero yet
+      for (size_t i = usesSize; i < state->usesSize; ++i)
+        if (state->uses[i].binding >= global)
+          state->bindings[state->uses[i].binding].isAssigned = true;
+
+      ++global;
+    }
+
+  for (db::Token token = root; token; token = token->right)
+    {
+      db::Token function = token->left;
+      if (!IS_FUN(function)) continue;
+
+      size_t scopeSize = state->scopeSize;
+
+      for (db::Token parameter = function->left->left; parameter; parameter = parameter->right)
+        if (IS_VAR(parameter->left) &&
+            !pushBinding(state, NAME(parameter->left->left), nullptr))
+          return false;
+
+      if (!resolveBlock(state, function->right)) return false;
+
+      state->scopeSize = scopeSize;
+    }
+
+  return true;
+}
+
+static bool resolveBlock(PropagationState *state, db::Token block)
+{
+  assert(state);
+
+  size_t scopeSize = state->scopeSize;
+
+  for (db::Token command = block; command; command = command->right)
+    if (!resolveStatement(state, command->left)) return false;
+
+  state->scopeSize = scopeSize;
+
+  return true;
+}
+
+static bool resolveBody(PropagationState *state, db::Token body)
+{
+  assert(state);
+
+  if (IS_COMP(body)) return resolveBlock(state, body);
+
+  size_t scopeSize = state->scopeSize;
+
+  bool isOk = resolveStatement(state, body);
+
+  state->scopeSize = scopeSize;
+
+  return isOk;
+}
+
+static bool resolveStatement(PropagationState *state, db::Token statement)
+{
+  assert(state);
+
+  if (!statement) return true;
+
+  if (IS_VAR(statement) || IS_VAL(statement))
+    return resolveExpression(state, statement->right) &&
+           pushBinding(state, NAME(statement->left), statement);
+
+  if (IS_ASSIGN(statement))
+    {
+      if (!resolveExpression(state, statement->right)) return false;
+
+      markAssigned(state, NAME(statement->left));
+      return true;
+    }
+
+  if (IS_IN(statement))
+    {
+      for (db::Token parameter = statement->left; parameter; parameter = parameter->right)
+        if (parameter->left && IS_NAME(parameter->left))
+          markAssigned(state, NAME(parameter->left));
+
+      return true;
+    }
+
+  if (IS_IF(statement))
+    {
+      if (!resolveExpression(state, statement->left)) return false;
+
+      if (IS_ELSE(statement->right))
+        return resolveBody(state, statement->right->left) &&
+               resolveBody(state, statement->right->right);
+
+      return resolveBody(state, statement->right);
+    }
+
+  if (IS_WHILE(statement))
+    return resolveExpression(state, statement->left) &&
+           resolveBody(state, statement->right);
+
+  if (IS_COMP(statement)) return resolveBlock(state, statement);
+
+  return resolveExpression(state, statement);
+}
+
+static bool resolveExpression(PropagationState *state, db::Token token)
+{
+  assert(state);
+
+  if (!token) return true;
+
+  if (IS_NAME(token)) return pushUse(state, token);
+
+  // Name of function is not a value
+  if (IS_CALL(token))
+    return !token->left || resolveExpression(state, token->left->left);
+
+  return resolveExpression(state, token->left) &&
+         resolveExpression(state, token->right);
+}
+
+static bool pushBinding(PropagationState *state, const char *name, db::Token declaration)
+{
+  assert(state);
+  assert(name);
+
+  if (state->bindingsSize == state->bindingsCapacity)
+    {
+      state->bindingsCapacity = GROWTH_FACTOR*state->bindingsCapacity + 1;
+      Binding *temp =
+        (Binding *)recalloc(state->bindings, state->bindingsCapacity, sizeof(Binding));
+      if (!temp) return false;
+
+      state->bindings = temp;
+    }
+
+  if (state->scopeSize == state->scopeCapacity)
+    {
+      state->scopeCapacity = GROWTH_FACTOR*state->scopeCapacity + 1;
+      size_t *temp = (size_t *)recalloc(state->scope, state->scopeCapacity, sizeof(size_t));
+      if (!temp) return false;
+
+      state->scope = temp;
+    }
+
+  state->scope[state->scopeSize++] = state->bindingsSize;
+
+  state->bindings[state->bindingsSize++] = {
+    .name        = name,
+    .declaration = declaration,
+    .isAssigned  = false,
+  };
+
+  return true;
+}
+
+static bool pushUse(PropagationState *state, db::Token token)
+{
+  assert(state);
+  assert(token);
+
+  size_t binding = searchBinding(state, NAME(token));
+  if (binding == NO_BINDING) return true;
+
+  if (state->usesSize == state->usesCapacity)
+    {
+      state->usesCapacity = GROWTH_FACTOR*state->usesCapacity + 1;
+      Use *temp = (Use *)recalloc(state->uses, state->usesCapacity, sizeof(Use));
+      if (!temp) return false;
+
+      state->uses = temp;
+    }
+
+  state->uses[state->usesSize++] = { .token = token, .binding = binding };
+
+  return true;
+}
+
+static void markAssigned(PropagationState *state, const char *name)
+{
+  assert(state);
+  assert(name);
+
+  size_t binding = searchBinding(state, name);
+  if (binding != NO_BINDING) state->bindings[binding].isAssigned = true;
+}
+
+static size_t searchBinding(const PropagationState *state, const char *name)
+{
+  assert(state);
+  assert(name);
+
+  for (size_t i = state->scopeSize; i > 0; --i)
+    {
+      size_t binding = state->scope[i - 1];
+      if (db::compareStrings(state->bindings[binding].name, name)) return binding;
+    }
+
+  return NO_BINDING;
+}
+
+static bool isConstant(const Binding *binding)
+{
+  assert(binding);
+
+  return binding->declaration && !binding->isAssigned &&
+         binding->declaration->right && IS_NUM(binding->declaration->right);
+}
+
+static size_t substituteUses(PropagationState *state)
+{
+  assert(state);
+
+  size_t count = 0;
+
+  for (size_t i = 0; i < state->usesSize; ++i)
+    {
+      const Binding *binding = state->bindings + state->uses[i].binding;
+      if (!isConstant(binding)) continue;
+
+      db::Token token = state->uses[i].token;
+
+      token->type  = db::type_t::NUMBER;
+      token->value = {.number = NUMBER(binding->declaration->right)};
+
+      ++count;
+    }
+
+  return count;
+}
+
+static bool removeConstants(PropagationState *state, db::Token *root)
+{
+  assert(state);
+  assert(root);
+
+  size_t size = 0;
+  for (size_t i = 0; i < state->bindingsSize; ++i)
+    if (isConstant(state->bindings + i)) ++size;
+
+  if (!size) return true;
+
+  db::Token *declarations = (db::Token *)calloc(size, sizeof(db::Token));
+  if (!declarations) return false;
+
+  size = 0;
+  for (size_t i = 0; i < state->bindingsSize; ++i)
+    if (isConstant(state->bindings + i))
+      declarations[size++] = state->bindings[i].declaration;
+
+  qsort(declarations, size, sizeof(db::Token), compareTokens);
+
+  removeDeclarations(state, declarations, size, root);
+
+  free(declarations);
+
+  return true;
+}
+
+static void removeDeclarations(
+                               PropagationState *state,
+                               const db::Token *declarations,
+                               size_t size,
+                               db::Token *block
+                              )
+{
+  assert(state);
+  assert(declarations);
+  assert(block);
+
+  db::Token *slot = block;
+  while (*slot)
+    {
+      db::Token command   = *slot;
+      db::Token statement = command->left;
+
+      bool isDeclaration =
+        statement && bsearch(&statement, declarations, size, sizeof(db::Token), compareTokens);
+
+      // Backend does not accept empty blocks
+      if (isDeclaration && (slot != block || command->right))
+        {
+          *slot = command->right;
+          command->right = nullptr;
+          db::removeNode(command);
+
+          ++state->removed;
+          continue;
+        }
+
+      if (IS_COMP(statement))
+        removeDeclarations(state, declarations, size, &command->left);
+      else
+        removeNestedDeclarations(state, declarations, size, statement);
+
+      slot = &command->right;
+    }
+}
+
+static void removeNestedDeclarations(
+                                     PropagationState *state,
+                                     const db::Token *declarations,
+                                     size_t size,
+                                     db::Token statement
+                                    )
+{
+  assert(state);
+  assert(declarations);
+
+  if (IS_FUN(statement) || IS_WHILE(statement))
+    removeBodyDeclarations(state, declarations, size, &statement->right);
+  else if (IS_IF(statement) && IS_ELSE(statement->right))
+    {
+      removeBodyDeclarations(state, declarations, size, &statement->right->left );
+      removeBodyDeclarations(state, declarations, size, &statement->right->right);
+    }
+  else if (IS_IF(statement))
+    removeBodyDeclarations(state, declarations, size, &statement->right);
+}
+
+static void removeBodyDeclarations(
+                                   PropagationState *state,
+                                   const db::Token *declarations,
+                                   size_t size,
+                                   db::Token *body
+                                  )
+{
+  assert(state);
+  assert(declarations);
+  assert(body);
+
+  if (IS_COMP(*body))
+    removeDeclarations(state, declarations, size, body);
+  else if (*body)
+    removeNestedDeclarations(state, declarations, size, *body);
+}
+
+static int compareTokens(const void *first, const void *second)
+{
+  assert(first);
+  assert(second);
+
+  db::Token firstToken  = *(const db::Token *)first;
+  db::Token secondToken = *(const db::Token *)second;
+
+  return (firstToken > secondToken) - (firstToken < secondToken);
+}
@@ -0,0 +1,835 @@
+#include "ControlFlow.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <malloc.h>
+#include "Tree.h"
+#include "SystemLike.h"
+#include "Assert.h"
+#include "Error.h"
+
+#pragma GCC diagnostic ignored "-Wswitch-enum"
+
+const int GROWTH_FACTOR = 2;
+
+/// Count of flags of every block: use, def, liveIn and liveOut
+const size_t SETS_COUNT = 4;
+
+/// Registers are the first locations in order of Register
+const db::Register FIRST_REGISTER = db::Register::RAX;
+const db::Register  LAST_REGISTER = db::Register::RFX;
+
+/// Mode of arithmetic, it is read by every instruction which computes
+const db::Register MODE_REGISTER = db::Register::REX;
+
+/// Words of frame are tracked relative to frame base
+const db::Register FRAME_REGISTER = db::Register::RDX;
+/// Stack pointer is equal to frame base after it is copied in prologue and epilogue
+const db::Register STACK_REGISTER = db::Register::RCX;
+
+static bool findBlocks(db::ControlFlow *flow);
+
+static bool addLocation(db::ControlFlow *flow, const db::IrOperand *operand);
+
+static bool findLocations(db::ControlFlow *flow);
+
+static bool addEdge(db::ControlFlow *flow, size_t from, size_t to);
+
+static bool findEdges(db::ControlFlow *flow);
+
+/// Depth-first search from entry, blocks are added to order after their successors
+static void visitBlock(db::ControlFlow *flow, size_t block, bool *isVisited);
+
+static bool findOrder(db::ControlFlow *flow);
+
+/// Cooper, Harvey and Kennedy: idoms are intersected over predecessors in reverse postorder
+static bool findDominators(db::ControlFlow *flow);
+
+static size_t intersect(const db::ControlFlow *flow, const size_t *indexes, size_t first, size_t second);
+
+static void findAccesses(db::ControlFlow *flow);
+
+static void findLiveness(db::ControlFlow *flow);
+
+/// Word of frame of memory relative to stack pointer or nullptr if it is unknown
+/// @param [out] location Memory relative to frame base
+static const db::IrOperand *getLocation(
+                                        const db::IrOperand *operand,
+                                        bool isFrameBase,
+                                        db::IrOperand *location
+                                       );
+
+/// @param [in] isFrameBase Stack pointer is equal to frame base
+/// @note Memory relative to unknown stack pointer may be any word of frame
+static void readLocation (
+                          db::ControlFlow *flow,
+                          db::BasicBlock *block,
+                          const db::IrOperand *operand,
+                          bool isFrameBase
+                         );
+static void writeLocation(
+                          db::ControlFlow *flow,
+                          db::BasicBlock *block,
+                          const db::IrOperand *operand,
+                          bool isFrameBase
+                         );
+
+static void readRegister (db::ControlFlow *flow, db::BasicBlock *block, db::Register reg);
+static void writeRegister(db::ControlFlow *flow, db::BasicBlock *block, db::Register reg);
+
+/// @return Index of last instruction of block, which isn`t comment, or CFG_NIL
+static size_t findLast(const db::ControlFlow *flow, const db::BasicBlock *block);
+
+static bool isJump(db::Opcode opcode);
+
+static bool isComputation(db::Opcode opcode);
+
+static void printLocations(const db::ControlFlow *flow, const bool *set, FILE *target);
+
+static void generateGraph(const void *graph, FILE *file);
+
+void db::buildControlFlow(db::ControlFlow *flow, const db::IrCode *code, int *error)
+{
+  if (!flow || !code) ERROR();
+
+  flow->code   = code;
+  flow->blocks = nullptr;
+  flow->order  = nullptr;
+  flow->sets   = nullptr;
+  flow->locations = nullptr;
+  flow->size = flow->capacity = flow->orderSize = 0;
+  flow->locationsSize = flow->locationsCapacity = 0;
+
+  bool isCorrect = findBlocks(flow) && findLocations(flow) && findEdges(flow);
+
+  if (isCorrect)
+    {
+      size_t size = flow->size*flow->locationsSize;
+
+      flow->sets = (bool *)calloc(SETS_COUNT*size + 1, sizeof(bool));
+      isCorrect = flow->sets != nullptr;
+
+      for (size_t i = 0; i < flow->size && isCorrect; ++i)
+        {
+          bool *sets = flow->sets + SETS_COUNT*flow->locationsSize*i;
+
+          flow->blocks[i].use     = sets;
+          flow->blocks[i].def     = sets + flow->locationsSize;
+          flow->blocks[i].liveIn  = sets + flow->locationsSize*2;
+          flow->blocks[i].liveOut = sets + flow->locationsSize*3;
+        }
+    }
+
+  isCorrect = isCorrect && findOrder(flow) && findDominators(flow);
+
+  if (!isCorrect)
+    {
+      db::destroyControlFlow(flow);
+      ERROR();
+    }
+
+  findAccesses(flow);
+  findLiveness(flow);
+}
+
+void db::destroyControlFlow(db::ControlFlow *flow, int *error)
+{
+  if (!flow) ERROR();
+
+  for (size_t i = 0; i < flow->size; ++i)
+    free(flow->blocks[i].predecessors);
+
+  free(flow->blocks);
+  free(flow->order);
+  free(flow->locations);
+  free(flow->sets);
+
+  flow->blocks = nullptr;
+  flow->order  = nullptr;
+  flow->sets   = nullptr;
+  flow->locations = nullptr;
+  flow->size = flow->capacity = flow->orderSize = 0;
+  flow->locationsSize = flow->locationsCapacity = 0;
+}
+
+size_t db::searchBlock(const db::ControlFlow *flow, size_t instruction)
+{
+  if (!flow || !flow->size) return db::CFG_NIL;
+
+  size_t left  = 0;
+  size_t right = flow->size;
+
+  while (right - left > 1)
+    {
+      size_t middle = (left + right)/2;
+
+      if (flow->blocks[middle].start <= instruction) left  = middle;
+      else                                           right = middle;
+    }
+
+  const db::BasicBlock *block = flow->blocks + left;
+
+  return (block->start <= instruction && instruction < block->end ? left : db::CFG_NIL);
+}
+
+size_t db::searchLocation(const db::ControlFlow *flow, const db::IrOperand *operand)
+{
+  if (!flow || !operand) return db::CFG_NIL;
+
+  for (size_t i = 0; i < flow->locationsSize; ++i)
+    if (db::isSameOperand(flow->locations + i, operand))
+      return i;
+
+  return db::CFG_NIL;
+}
+
+bool db::isDominator(const db::ControlFlow *flow, size_t dominator, size_t block)
+{
+  if (!flow || dominator >= flow->size || block >= flow->size) return false;
+
+  for ( ; block != db::CFG_NIL; block = flow->blocks[block].dominator)
+    if (block == dominator) return true;
+
+  return false;
+}
+
+bool db::isLiveIn(const db::ControlFlow *flow, size_t block, const db::IrOperand *location)
+{
+  if (!flow || block >= flow->size) return false;
+
+  size_t index = db::searchLocation(flow, location);
+
+  return index != db::CFG_NIL && flow->blocks[block].liveIn[index];
+}
+
+bool db::isLiveOut(const db::ControlFlow *flow, size_t block, const db::IrOperand *location)
+{
+  if (!flow || block >= flow->size) return false;
+
+  size_t index = db::searchLocation(flow, location);
+
+  return index != db::CFG_NIL && flow->blocks[block].liveOut[index];
+}
+
+void db::dumpControlFlow(const db::ControlFlow *flow, FILE *target, int *error)
+{
+  if (!flow || !target) ERROR();
+
+  fprintf(target, "<pre>ControlFlow: %zu blocks, %zu locations\n",
+          flow->size, flow->locationsSize);
+
+  for (size_t i = 0; i < flow->size; ++i)
+    {
+      const db::BasicBlock *block = flow->blocks + i;
+
+      fprintf(target, "  B%-4zu [%zu, %zu)", i, block->start, block->end);
+
+      if (block->dominator != db::CFG_NIL) fprintf(target, " idom B%zu", block->dominator);
+
+      fprintf(target, " ->");
+      for (size_t j = 0; j < block->successorsSize; ++j)
+        fprintf(target, " B%zu", block->successors[j]);
+
+      fprintf(target, "\n         in:");
+      printLocations(flow, block->liveIn, target);
+      fprintf(target, "\n        out:");
+      printLocations(flow, block->liveOut, target);
+      fprintf(target, "\n");
+    }
+
+  fprintf(target, "</pre>\n");
+
+  const char *image = db::createGraphImage(flow, generateGraph);
+  if (image) fprintf(target, "<image src=../%s />\n", image);
+}
+
+static bool findBlocks(db::ControlFlow *flow)
+{
+  assert(flow);
+
+  const db::IrCode *code = flow->code;
+
+  bool *isLeader = (bool *)calloc(code->size + 1, sizeof(bool));
+  if (!isLeader) return false;
+
+  isLeader[0] = true;
+  for (size_t i = 0; i < code->size; ++i)
+    {
+      db::Opcode opcode = code->instructions[i].opcode;
+
+      if (opcode == db::Opcode::LABEL) isLeader[i] = true;
+
+      if (isJump(opcode) || opcode == db::Opcode::RET || opcode == db::Opcode::HLT)
+        isLeader[i + 1] = true;
+    }
+
+  // Comments between blocks are kept in the previous block or in the first one
+  for (size_t i = 0; i < code->size; )
+    {
+      size_t next = i + 1;
+      while (next < code->size && !isLeader[next]) ++next;
+
+      bool isComment = true;
+      for (size_t j = i; j < next && isComment; ++j)
+        isComment = code->instructions[j].opcode == db::Opcode::COMMENT;
+
+      if (isComment && !i && next < code->size)
+        {
+          isLeader[next] = false;
+          continue;
+        }
+
+      if (isComment && i) isLeader[i] = false;
+
+      i = next;
+    }
+
+  bool isCorrect = true;
+
+  for (size_t i = 0; i < code->size && isCorrect; ++i)
+    {
+      if (!isLeader[i]) continue;
+
+      if (flow->size == flow->capacity)
+        {
+          flow->capacity = GROWTH_FACTOR*flow->capacity + 1;
+          db::BasicBlock *temp =
+            (db::BasicBlock *)recalloc(flow->blocks, flow->capacity, sizeof(db::BasicBlock));
+          if (!temp)
+            {
+              isCorrect = false;
+              break;
+            }
+
+          flow->blocks = temp;
+        }
+
+      if (flow->size) flow->blocks[flow->size - 1].end = i;
+
+      flow->blocks[flow->size++] = { .start = i, .end = code->size, .dominator = db::CFG_NIL };
+    }
+
+  free(isLeader);
+
+  return isCorrect;
+}
+
+static bool addLocation(db::ControlFlow *flow, const db::IrOperand *operand)
+{
+  assert(flow);
+  assert(operand);
+
+  if (db::searchLocation(flow, operand) != db::CFG_NIL) return true;
+
+  if (flow->locationsSize == flow->locationsCapacity)
+    {
+      flow->locationsCapacity = GROWTH_FACTOR*flow->locationsCapacity + 1;
+      db::IrOperand *temp =
+        (db::IrOperand *)recalloc(flow->locations, flow->locationsCapacity, sizeof(db::IrOperand));
+      if (!temp) return false;
+
+      flow->locations = temp;
+    }
+
+  flow->locations[flow->locationsSize++] = *operand;
+
+  return true;
+}
+
+static bool findLocations(db::ControlFlow *flow)
+{
+  assert(flow);
+
+  for (int reg = (int)FIRST_REGISTER; reg <= (int)LAST_REGISTER; ++reg)
+    {
+      db::IrOperand operand = db::registerOperand((db::Register)reg);
+      if (!addLocation(flow, &operand)) return false;
+    }
+
+  for (size_t i = 0; i < flow->code->size; ++i)
+    {
+      const db::IrInstruction *instruction = flow->code->instructions + i;
+
+      if (instruction->opcode == db::Opcode::COMMENT) continue;
+
+      db::IrOperand location = {};
+      if (getLocation(&instruction->operand, true, &location) && !addLocation(flow, &location))
+        return false;
+    }
+
+  return true;
+}
+
+static bool addEdge(db::ControlFlow *flow, size_t from, size_t to)
+{
+  assert(flow);
+  assert(from < flow->size);
+  assert(to   < flow->size);
+
+  db::BasicBlock *source = flow->blocks + from;
+  db::BasicBlock *target = flow->blocks + to;
+
+  for (size_t i = 0; i < source->successorsSize; ++i)
+    if (source->successors[i] == to) return true;
+
+  source->successors[source->successorsSize++] = to;
+
+  if (target->predecessorsSize == target->predecessorsCapacity)
+    {
+      target->predecessorsCapacity = GROWTH_FACTOR*target->predecessorsCapacity + 1;
+      size_t *temp =
+        (size_t *)recalloc(target->predecessors, target->predecessorsCapacity, sizeof(size_t));
+      if (!temp) return false;
+
+      target->predecessors = temp;
+    }
+
+  target->predecessors[target->predecessorsSize++] = from;
+
+  return true;
+}
+
+static bool findEdges(db::ControlFlow *flow)
+{
+  assert(flow);
+
+  const db::IrCode *code = flow->code;
+
+  for (size_t i = 0; i < flow->size; ++i)
+    {
+      size_t last = findLast(flow, flow->blocks + i);
+      db::Opcode opcode = (last == db::CFG_NIL ? db::Opcode::COMMENT : code->instructions[last].opcode);
+
+      if (opcode == db::Opcode::RET || opcode == db::Opcode::HLT) continue;
+
+      if (opcode != db::Opcode::JMP && i + 1 < flow->size && !addEdge(flow, i, i + 1))
+        return false;
+
+      if (!isJump(opcode)) continue;
+
+      // Jump to label out of code, like to other function, leaves the graph
+      for (size_t j = 0; j < code->size; ++j)
+        if (code->instructions[j].opcode == db::Opcode::LABEL &&
+            db::isSameOperand(&code->instructions[j].operand, &code->instructions[last].operand))
+          {
+            if (!addEdge(flow, i, db::searchBlock(flow, j))) return false;
+            break;
+          }
+    }
+
+  return true;
+}
+
+static void visitBlock(db::ControlFlow *flow, size_t block, bool *isVisited)
+{
+  assert(flow);
+  assert(isVisited);
+
+  isVisited[block] = true;
+
+  const db::BasicBlock *current = flow->blocks + block;
+  for (size_t i = 0; i < current->successorsSize; ++i)
+    if (!isVisited[current->successors[i]])
+      visitBlock(flow, current->successors[i], isVisited);
+
+  flow->order[flow->orderSize++] = block;
+}
+
+static bool findOrder(db::ControlFlow *flow)
+{
+  assert(flow);
+
+  flow->order = (size_t *)calloc(flow->size + 1, sizeof(size_t));
+  bool *isVisited = (bool *)calloc(flow->size + 1, sizeof(bool));
+
+  if (!flow->order || !isVisited)
+    {
+      free(isVisited);
+      return false;
+    }
+
+  if (flow->size) visitBlock(flow, 0, isVisited);
+
+  for (size_t i = 0; i < flow->orderSize/2; ++i)
+    {
+      size_t temp = flow->order[i];
+      flow->order[i] = flow->order[flow->orderSize - 1 - i];
+      flow->order[flow->orderSize - 1 - i] = temp;
+    }
+
+  free(isVisited);
+
+  return true;
+}
+
+static bool findDominators(db::ControlFlow *flow)
+{
+  assert(flow);
+
+  if (!flow->orderSize) return true;
+
+  size_t *indexes = (size_t *)calloc(flow->size + 1, sizeof(size_t));
+  if (!indexes) return false;
+
+  for (size_t i = 0; i < flow->size; ++i) indexes[i] = db::CFG_NIL;
+  for (size_t i = 0; i < flow->orderSize; ++i) indexes[flow->order[i]] = i;
+
+  size_t entry = flow->order[0];
+  flow->blocks[entry].dominator = entry;
+
+  bool isChanged = true;
+  while (isChanged)
+    {
+      isChanged = false;
+
+      for (size_t i = 1; i < flow->orderSize; ++i)
+        {
+          db::BasicBlock *block = flow->blocks + flow->order[i];
+
+          size_t dominator = db::CFG_NIL;
+          for (size_t j = 0; j < block->predecessorsSize; ++j)
+            {
+              size_t predecessor = block->predecessors[j];
+              if (flow->blocks[predecessor].dominator == db::CFG_NIL) continue;
+
+              dominator = (dominator == db::CFG_NIL ? predecessor :
+                           intersect(flow, indexes, predecessor, dominator));
+            }
+
+          if (block->dominator != dominator)
+            {
+              block->dominator = dominator;
+              isChanged = true;
+            }
+        }
+    }
+
+  flow->blocks[entry].dominator = db::CFG_NIL;
+
+  free(indexes);
+
+  return true;
+}
+
+static size_t intersect(const db::ControlFlow *flow, const size_t *indexes, size_t first, size_t second)
+{
+  assert(flow);
+  assert(indexes);
+
+  while (first != second)
+    {
+      while (indexes[first ] > indexes[second]) first  = flow->blocks[first ].dominator;
+      while (indexes[second] > indexes[first ]) second = flow->blocks[second].dominator;
+    }
+
+  return first;
+}
+
+static void findAccesses(db::ControlFlow *flow)
+{
+  assert(flow);
+
+  for (size_t i = 0; i < flow->size; ++i)
+    {
+      db::BasicBlock *block = flow->blocks + i;
+
+      bool isFrameBase = false;
+      const db::IrInstruction *previous = nullptr;
+
+      for (size_t j = block->start; j < block->end; ++j)
+        {
+          const db::IrInstruction *instruction = flow->code->instructions + j;
+          const db::IrOperand *operand = &instruction->operand;
+
+          // Reads of instruction are before its writes
+          switch (instruction->opcode)
+            {
+            case db::Opcode::COMMENT:
+              continue;
+            case db::Opcode::LABEL:
+            case db::Opcode::HLT:
+              break;
+            case db::Opcode::PUSH:
+              readLocation(flow, block, operand, isFrameBase);
+              break;
+            case db::Opcode::POP:
+              if (operand->type == db::OperandType::Memory) readRegister(flow, block, operand->base);
+              writeLocation(flow, block, operand, isFrameBase);
+              break;
+            case db::Opcode::SHOW:
+              if (operand->type == db::OperandType::Memory) readRegister(flow, block, operand->base);
+              break;
+            case db::Opcode::CALL:
+              // Callee reads the stack pointer and the mode, see convention of allocateRegisters
+              readRegister (flow, block, STACK_REGISTER);
+              readRegister (flow, block, MODE_REGISTER);
+              writeRegister(flow, block, db::Register::RAX);
+              writeRegister(flow, block, db::Register::RBX);
+              writeRegister(flow, block, FRAME_REGISTER);
+              writeRegister(flow, block, db::Register::RFX);
+              break;
+            case db::Opcode::RET:
+              readRegister(flow, block, db::Register::RAX);
+              readRegister(flow, block, db::Register::RBX);
+              readRegister(flow, block, STACK_REGISTER);
+              readRegister(flow, block, MODE_REGISTER);
+              break;
+            default:
+              if (isComputation(instruction->opcode)) readRegister(flow, block, MODE_REGISTER);
+              break;
+            }
+
+          // PUSH rcx, POP rdx or PUSH rdx, POP rcx
+          if (instruction->opcode == db::Opcode::CALL)
+            isFrameBase = false;
+          else if (instruction->opcode == db::Opcode::POP &&
+                   operand->type == db::OperandType::Register &&
+                   (operand->base == FRAME_REGISTER || operand->base == STACK_REGISTER))
+            isFrameBase =
+              previous && previous->opcode == db::Opcode::PUSH &&
+              previous->operand.type == db::OperandType::Register &&
+              (previous->operand.base == FRAME_REGISTER || previous->operand.base == STACK_REGISTER) &&
+              previous->operand.base != operand->base;
+
+          previous = instruction;
+        }
+    }
+}
+
+static void findLiveness(db::ControlFlow *flow)
+{
+  assert(flow);
+
+  size_t size = flow->locationsSize;
+
+  bool isChanged = true;
+  while (isChanged)
+    {
+      isChanged = false;
+
+      // Backward problem converges faster from the end of code
+      for (size_t i = flow->size; i > 0; --i)
+        {
+          db::BasicBlock *block = flow->blocks + i - 1;
+
+          for (size_t j = 0; j < size; ++j)
+            {
+              bool isLive = false;
+              for (size_t k = 0; k < block->successorsSize && !isLive; ++k)
+                isLive = flow->blocks[block->successors[k]].liveIn[j];
+
+              block->liveOut[j] = isLive;
+
+              isLive = block->use[j] || (isLive && !block->def[j]);
+              if (block->liveIn[j] != isLive)
+                {
+                  block->liveIn[j] = isLive;
+                  isChanged = true;
+                }
+            }
+        }
+    }
+}
+
+static const db::IrOperand *getLocation(
+                                        const db::IrOperand *operand,
+                                        bool isFrameBase,
+                                        db::IrOperand *location
+                                       )
+{
+  assert(operand);
+  assert(location);
+
+  if (operand->type == db::OperandType::Register) return operand;
+
+  if (operand->type != db::OperandType::Memory) return nullptr;
+
+  if (operand->base == FRAME_REGISTER) return operand;
+
+  if (operand->base == STACK_REGISTER && isFrameBase)
+    {
+      *location = db::memoryOperand(operand->value, FRAME_REGISTER);
+      return location;
+    }
+
+  return nullptr;
+}
+
+static void readLocation(
+                         db::ControlFlow *flow,
+                         db::BasicBlock *block,
+                         const db::IrOperand *operand,
+                         bool isFrameBase
+                        )
+{
+  assert(flow);
+  assert(block);
+  assert(operand);
+
+  if (operand->type == db::OperandType::Memory) readRegister(flow, block, operand->base);
+
+  db::IrOperand temp = {};
+  const db::IrOperand *location = getLocation(operand, isFrameBase, &temp);
+
+  if (!location)
+    {
+      if (operand->type != db::OperandType::Memory || operand->base != STACK_REGISTER) return;
+
+      for (size_t i = 0; i < flow->locationsSize; ++i)
+        if (flow->locations[i].type == db::OperandType::Memory && !block->def[i])
+          block->use[i] = true;
+
+      return;
+    }
+
+  size_t index = db::searchLocation(flow, location);
+  if (index != db::CFG_NIL && !block->def[index]) block->use[index] = true;
+}
+
+static void writeLocation(
+                          db::ControlFlow *flow,
+                          db::BasicBlock *block,
+                          const db::IrOperand *operand,
+                          bool isFrameBase
+                         )
+{
+  assert(flow);
+  assert(block);
+  assert(operand);
+
+  db::IrOperand temp = {};
+  const db::IrOperand *location = getLocation(operand, isFrameBase, &temp);
+  if (!location) return;
+
+  size_t index = db::searchLocation(flow, location);
+  if (index != db::CFG_NIL) block->def[index] = true;
+}
+
+static void readRegister(db::ControlFlow *flow, db::BasicBlock *block, db::Register reg)
+{
+  assert(flow);
+  assert(block);
+
+  if (reg == db::Register::NONE) return;
+
+  db::IrOperand operand = db::registerOperand(reg);
+  readLocation(flow, block, &operand, false);
+}
+
+static void writeRegister(db::ControlFlow *flow, db::BasicBlock *block, db::Register reg)
+{
+  assert(flow);
+  assert(block);
+
+  db::IrOperand operand = db::registerOperand(reg);
+  writeLocation(flow, block, &operand, false);
+}
+
+static size_t findLast(const db::ControlFlow *flow, const db::BasicBlock *block)
+{
+  assert(flow);
+  assert(block);
+
+  for (size_t i = block->end; i > block->start; --i)
+    if (flow->code->instructions[i - 1].opcode != db::Opcode::COMMENT)
+      return i - 1;
+
+  return db::CFG_NIL;
+}
+
+static bool isJump(db::Opcode opcode)
+{
+  switch (opcode)
+    {
+    case db::Opcode::JMP:
+    case db::Opcode::JE:
+    case db::Opcode::JNE:
+    case db::Opcode::JB:
+    case db::Opcode::JA:
+    case db::Opcode::JBE:
+    case db::Opcode::JAE:
+      return true;
+    default:
+      return false;
+    }
+}
+
+static bool isComputation(db::Opcode opcode)
+{
+  switch (opcode)
+    {
+    case db::Opcode::ADD:
+    case db::Opcode::SUB:
+    case db::Opcode::MUL:
+    case db::Opcode::DIV:
+    case db::Opcode::POW:
+    case db::Opcode::SIN:
+    case db::Opcode::COS:
+    case db::Opcode::TAN:
+    case db::Opcode::SQRT:
+    case db::Opcode::AND:
+    case db::Opcode::OR:
+    case db::Opcode::NEQL:
+    case db::Opcode::EQL:
+    case db::Opcode::LESS:
+    case db::Opcode::GREATER:
+    case db::Opcode::IN:
+    case db::Opcode::OUT:
+      return true;
+    default:
+      return isJump(opcode) && opcode != db::Opcode::JMP;
+    }
+}
+
+static void printLocations(const db::ControlFlow *flow, const bool *set, FILE *target)
+{
+  assert(flow);
+  assert(set);
+  assert(target);
+
+  for (size_t i = 0; i < flow->locationsSize; ++i)
+    if (set[i])
+      {
+        fprintf(target, " ");
+        db::printOperand(flow->locations + i, target);
+      }
+}
+
+static void generateGraph(const void *graph, FILE *file)
+{
+  const db::ControlFlow *flow = (const db::ControlFlow *)graph;
+  assert(flow);
+  assert(file);
+
+  fprintf(file, "\tnode[shape=Mrecord];\n");
+
+  for (size_t i = 0; i < flow->size; ++i)
+    {
+      const db::BasicBlock *block = flow->blocks + i;
+      const db::IrInstruction *first = flow->code->instructions + block->start;
+
+      fprintf(file, "\t\tBLOCK_%zu [ label=\"{ B%zu ", i, i);
+      if (first->opcode == db::Opcode::LABEL)
+        {
+          fprintf(file, " ");
+          db::printOperand(&first->operand, file);
+        }
+
+      fprintf(file, " | %zu..%zu | in:", block->start, block->end);
+      printLocations(flow, block->liveIn, file);
+      fprintf(file, " | out:");
+      printLocations(flow, block->liveOut, file);
+      fprintf(file, " }\" ];\n");
+    }
+
+  for (size_t i = 0; i < flow->size; ++i)
+    {
+      const db::BasicBlock *block = flow->blocks + i;
+
+      for (size_t j = 0; j < block->successorsSize; ++j)
+        fprintf(file, "\tBLOCK_%zu->BLOCK_%zu;\n", i, block->successors[j]);
+
+      if (block->dominator != db::CFG_NIL)
+        fprintf(file, "\tBLOCK_%zu->BLOCK_%zu[style=dashed,color=BLUE];\n", block->dominator, i);
+    }
+}
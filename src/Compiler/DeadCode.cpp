@@ -0,0 +1,394 @@
+#include "Translator.h"
+
+#include <stdio.h>
+#include <malloc.h>
+#include "DSL.h"
+#include "Assert.h"
+#include "Logging.h"
+#include "Error.h"
+
+struct DceState {
+  size_t branches;   ///< Branches of if/else with constant or dead part
+  size_t statements; ///< Removed commands
+  size_t functions;  ///< Removed unreachable functions
+};
+
+/// Prune commands of not dead block
+/// @param [in, out] block Pointer to first command of block
+static bool pruneBlock(DceState *state, db::Token *block);
+
+/// @param [in, out] command Pointer to command, block of constant if replaces it
+/// @param [out] isSpliced Commands of branch were inserted instead of command
+static bool pruneStatement(DceState *state, db::Token *command, bool *isSpliced);
+
+static bool pruneIf(DceState *state, db::Token *command, bool *isSpliced);
+
+/// Statement may be removed without change of behavior
+static bool isDead(const db::Token statement);
+
+static bool isDeadBlock(const db::Token block);
+
+static bool isZero(const db::Token condition);
+
+static bool hasDeclarations(const db::Token block);
+
+static size_t countCommands(const db::Token block);
+
+static bool removeUnreachable(db::Translator *translator, DceState *state);
+
+static void markCalls(
+                     const db::Translator *translator,
+                     const db::Token token,
+                     bool *isReachable,
+                     size_t *stack,
+                     size_t *stackSize
+                    );
+
+static void markFunction(
+                         const db::Translator *translator,
+                         const char *name,
+                         bool *isReachable,
+                         size_t *stack,
+                         size_t *stackSize
+                        );
+
+void db::eliminateDeadCode(db::Translator *translator, int *error)
+{
+  if (!translator || !translator->grammar.root) ERROR();
+
+  DceState state{};
+
+  bool isOk = true;
+
+  for (db::Token token = translator->grammar.root; token && isOk; token = token->right)
+    if (IS_FUN(token->left) && !isDeadBlock(token->left->right))
+      isOk = pruneBlock(&state, &token->left->right);
+
+  if (isOk) isOk = removeUnreachable(translator, &state);
+
+  if (!isOk) ERROR();
+
+  FILE *log = getLogFile();
+  if (!log) return;
+
+  fprintf(log, "<pre>Dead code: %zu branches, %zu statements, %zu functions removed</pre>\n",
+          state.branches, state.statements, state.functions);
+}
+
+static bool pruneBlock(DceState *state, db::Token *block)
+{
+  assert(state);
+  assert(block);
+
+  db::Token *slot = block;
+  while (*slot)
+    {
+      db::Token command = *slot;
+
+      if (isDead(command->left))
+        {
+          *slot = command->right;
+          command->right = nullptr;
+          db::removeNode(command);
+
+          ++state->statements;
+          continue;
+        }
+
+      if (IS_RETURN(command->left) && command->right)
+        {
+          state->statements += countCommands(command->right);
+
+          db::removeNode(command->right);
+          command->right = nullptr;
+        }
+
+      bool isSpliced = false;
+      if (!pruneStatement(state, slot, &isSpliced)) return false;
+
+      if (!isSpliced) slot = &(*slot)->right;
+    }
+
+  return true;
+}
+
+static bool pruneStatement(DceState *state, db::Token *command, bool *isSpliced)
+{
+  assert(state);
+  assert(command);
+  assert(isSpliced);
+
+  db::Token statement = (*command)->left;
+
+  if (IS_IF(statement)) return pruneIf(state, command, isSpliced);
+
+  if (IS_WHILE(statement) && !isDeadBlock(statement->right))
+    return pruneBlock(state, &statement->right);
+
+  if (IS_COMP(statement))
+    return pruneBlock(state, &(*command)->left);
+
+  return true;
+}
+
+static bool pruneIf(DceState *state, db::Token *command, bool *isSpliced)
+{
+  assert(state);
+  assert(command);
+  assert(isSpliced);
+
+  db::Token statement = (*command)->left;
+  db::Token condition = statement->left;
+
+  bool hasElse = IS_ELSE(statement->right);
+
+  db::Token *thenBlock = (hasElse ? &statement->right->left  : &statement->right);
+  db::Token *elseBlock = (hasElse ? &statement->right->right : nullptr);
+
+  if (IS_NUM(condition))
+    {
+      // Statement is not dead, so chosen branch exists and is not dead
+      db::Token *branch = (isZero(condition) ? elseBlock : thenBlock);
+      if (!pruneBlock(state, branch)) return false;
+
+      db::Token body = *branch;
+      *branch = nullptr;
+      ++state->branches;
+
+      if (!hasDeclarations(body))
+        {
+          db::Token last = body;
+          for ( ; last->right; last = last->right) continue;
+
+          last->right = (*command)->right;
+          (*command)->right = nullptr;
+          db::removeNode(*command);
+
+          *command   = body;
+          *isSpliced = true;
+
+          return true;
+        }
+
+      // Keep scope of local variables
+      if (statement->right) db::removeNode(statement->right);
+
+      NUMBER(condition) = 1;
+      db::setChildren(statement, condition, body);
+
+      return true;
+    }
+
+  if (hasElse && isDeadBlock(*elseBlock))
+    {
+      db::Token elseNode = statement->right;
+      db::setChildren(statement, condition, elseNode->left);
+
+      elseNode->left = nullptr;
+      db::removeNode(elseNode);
+
+      thenBlock = &statement->right;
+      elseBlock = nullptr;
+      ++state->branches;
+    }
+  else if (hasElse && isDeadBlock(*thenBlock))
+    {
+      db::Token elseNode = statement->right;
+      db::Token zero     = db::createNode({.number = 0}, db::type_t::NUMBER);
+      db::Token negation = (zero ? CREATE_STATEMENT(EQUAL, condition, zero) : nullptr);
+      if (!negation)
+        {
+          if (zero) db::removeNode(zero);
+          return false;
+        }
+
+      db::setChildren(statement, negation, elseNode->right);
+
+      elseNode->right = nullptr;
+      db::removeNode(elseNode);
+
+      thenBlock = &statement->right;
+      elseBlock = nullptr;
+      ++state->branches;
+    }
+
+  if (!isDeadBlock(*thenBlock) && !pruneBlock(state, thenBlock)) return false;
+
+  if (elseBlock && !pruneBlock(state, elseBlock)) return false;
+
+  return true;
+}
+
+static bool isDead(const db::Token statement)
+{
+  if (!statement) return false;
+
+  if (IS_IF(statement))
+    {
+      bool hasElse = IS_ELSE(statement->right);
+
+      db::Token thenBlock = (hasElse ? statement->right->left  : statement->right);
+      db::Token elseBlock = (hasElse ? statement->right->right : nullptr);
+
+      if (IS_NUM(statement->left))
+        return isZero(statement->left) ? isDeadBlock(elseBlock) : isDeadBlock(thenBlock);
+
+      return db::isPureNode(statement->left) && isDeadBlock(thenBlock) && isDeadBlock(elseBlock);
+    }
+
+  if (IS_WHILE(statement)) return IS_NUM(statement->left) && isZero(statement->left);
+
+  if (IS_COMP(statement)) return isDeadBlock(statement);
+
+  return false;
+}
+
+static bool isDeadBlock(const db::Token block)
+{
+  for (db::Token command = block; command; command = command->right)
+    if (!isDead(command->left)) return false;
+
+  return true;
+}
+
+static bool isZero(const db::Token condition)
+{
+  assert(condition);
+
+  return db::compareNumber(NUMBER(condition), 0);
+}
+
+static bool hasDeclarations(const db::Token block)
+{
+  for (db::Token command = block; command; command = command->right)
+    if (IS_VAR(command->left) || IS_VAL(command->left)) return true;
+
+  return false;
+}
+
+static size_t countCommands(const db::Token block)
+{
+  size_t count = 0;
+  for (db::Token command = block; command; command = command->right)
+    ++count;
+
+  return count;
+}
+
+static bool removeUnreachable(db::Translator *translator, DceState *state)
+{
+  assert(translator);
+  assert(state);
+
+  db::FunTable *table = &translator->functions;
+  if (!table->size || !db::searchFunction("main", translator)) return true;
+
+  bool   *isReachable = (bool   *)calloc(table->size, sizeof(bool  ));
+  size_t *stack       = (size_t *)calloc(table->size, sizeof(size_t));
+
+  size_t stackSize = 0;
+  bool   isOk      = isReachable && stack;
+
+  for (db::Token token = translator->grammar.root; token && isOk; token = token->right)
+    {
+      db::Token declaration = token->left;
+
+      if (!IS_FUN(declaration))
+        markCalls(translator, declaration, isReachable, stack, &stackSize);
+      else if (NAME(declaration->left)[0] == '$' ||
+               db::compareStrings(NAME(declaration->left), "main"))
+        markFunction(translator, NAME(declaration->left), isReachable, stack, &stackSize);
+    }
+
+  while (isOk && stackSize)
+    markCalls(translator, table->table[stack[--stackSize]].token->right,
+              isReachable, stack, &stackSize);
+
+  if (isOk)
+    {
+      db::Token *slot = &translator->grammar.root;
+      while (*slot)
+        {
+          db::Token declaration = (*slot)->left;
+
+          size_t index = 0;
+          if (IS_FUN(declaration))
+            for ( ; index < table->size; ++index)
+              if (table->table[index].token == declaration) break;
+
+          if (!IS_FUN(declaration) || index == table->size || isReachable[index])
+            {
+              slot = &(*slot)->right;
+              continue;
+            }
+
+          db::Token command = *slot;
+          *slot = command->right;
+          command->right = nullptr;
+          db::removeNode(command);
+
+          table->table[index].token = nullptr;
+          ++state->functions;
+        }
+
+      size_t size = 0;
+      for (size_t i = 0; i < table->size; ++i)
+        if (table->table[i].token)
+          table->table[size++] = table->table[i];
+      table->size = size;
+    }
+
+  free(isReachable);
+  free(stack);
+
+  return isOk;
+}
+
+static void markCalls(
+                      const db::Translator *translator,
+                      const db::Token token,
+                      bool *isReachable,
+                      size_t *stack,
+                      size_t *stackSize
+                     )
+{
+  assert(translator);
+
+  if (!token) return;
+
+  if (IS_CALL(token) && token->left)
+    markFunction(translator, NAME(token->left), isReachable, stack, stackSize);
+
+  markCalls(translator, token->left , isReachable, stack, stackSize);
+  markCalls(translator, token->right, isReachable, stack, stackSize);
+}
+
+static void markFunction(
+                         const db::Translator *translator,
+                         const char *name,
+                         bool *isReachable,
+                         size_t *stack,
+                         size_t *stackSize
+                        )
+{
+  assert(translator);
+  assert(name);
+  assert(isReachable);
+  assert(stack);
+  assert(stackSize);
+
+  const db::FunTable *table = &translator->functions;
+
+  for (size_t i = 0; i < table->size; ++i)
+    {
+      if (!db::compareStrings(table->table[i].name, name)) continue;
+
+      if (!isReachable[i])
+        {
+          isReachable[i] = true;
+          stack[(*stackSize)++] = i;
+        }
+
+      return;
+    }
+}
@@ -0,0 +1,578 @@
+#include "Translator.h"
+
+#include <stdio.h>
+#include <math.h>
+#include <malloc.h>
+#include "DSL.h"
+#include "Assert.h"
+#include "SystemLike.h"
+#include "Logging.h"
+#include "Error.h"
+
+#pragma GCC diagnostic ignored "-Wswitch-enum"
+
+const int GROWTH_FACTOR = 2;
+
+/// Evaluation of call is abandoned after this count of visited nodes
+const size_t MAX_STEPS = 1 << 20;
+
+/// Nesting of calls in evaluation
+const size_t MAX_DEPTH = 512;
+
+struct PureFunction {
+  const char *name;
+  db::Token   function;
+  bool        isPure; ///< Without in, out, globals and calls of not pure functions
+};
+
+/// Local of function, in purity analysis only its name is used
+struct Slot {
+  const char  *name; ///< nullptr for argument which is not bound yet
+  db::number_t value;
+};
+
+struct EvaluatorState {
+  PureFunction *functions;
+  size_t        functionsSize;
+
+  Slot  *slots;
+  size_t slotsSize;
+  size_t slotsCapacity;
+  size_t frame; ///< First slot of current function
+
+  size_t steps;
+  size_t depth;
+  bool   isBroken; ///< Memory allocation failed
+
+  size_t pure;
+  size_t evaluated;
+};
+
+static bool collectFunctions(EvaluatorState *state, db::Token root);
+
+/// Mark functions as not pure until fixed point, so purity is transitive over calls
+static void analyzePurity(EvaluatorState *state);
+
+static bool isPureBlock(EvaluatorState *state, const db::Token block);
+
+/// Body of if, else or while is compound statement or single statement without braces
+static bool isPureBody(EvaluatorState *state, const db::Token body);
+
+static bool isPureStatement(EvaluatorState *state, const db::Token statement);
+
+static bool isPureExpression(EvaluatorState *state, const db::Token token);
+
+static PureFunction *searchPureFunction(EvaluatorState *state, const char *name);
+
+/// Replace calls with numeric arguments by values, inner calls are replaced first
+static void foldCalls(EvaluatorState *state, db::Token token);
+
+static bool hasNumericArguments(const db::Token call);
+
+/// @return false if call can not be evaluated
+static bool evaluateCall(EvaluatorState *state, const db::Token call, db::number_t *result);
+
+static bool executeBlock(EvaluatorState *state, const db::Token block, bool *isReturned, db::number_t *result);
+
+static bool executeBody(EvaluatorState *state, const db::Token body, bool *isReturned, db::number_t *result);
+
+static bool executeStatement(
+                             EvaluatorState *state,
+                             const db::Token statement,
+                             bool *isReturned,
+                             db::number_t *result
+                            );
+
+static bool evaluateExpression(EvaluatorState *state, const db::Token token, db::number_t *value);
+
+static bool isTrue(db::number_t value);
+
+static bool pushSlot(EvaluatorState *state, const char *name, db::number_t value);
+
+/// Search local of current function
+static Slot *searchSlot(EvaluatorState *state, const char *name);
+
+void db::evaluatePureCalls(db::Translator *translator, int *error)
+{
+  if (!translator || !translator->grammar.root) ERROR();
+
+  EvaluatorState state{};
+
+  bool isOk = collectFunctions(&state, translator->grammar.root);
+
+  if (isOk)
+    {
+      analyzePurity(&state);
+      isOk = !state.isBroken;
+    }
+
+  if (isOk && state.pure)
+    {
+      foldCalls(&state, translator->grammar.root);
+      isOk = !state.isBroken;
+    }
+
+  free(state.functions);
+  free(state.slots);
+
+  if (!isOk) ERROR();
+
+  // Values of calls may be folded with their operands
+  if (state.evaluated) db::simplyGrammar(translator, error);
+
+  FILE *log = getLogFile();
+  if (!log) return;
+
+  fprintf(log, "<pre>Pure calls: %zu pure functions, %zu calls evaluated</pre>\n",
+          state.pure, state.evaluated);
+}
+
+static bool collectFunctions(EvaluatorState *state, db::Token root)
+{
+  assert(state);
+
+  size_t size = 0;
+  for (db::Token token = root; token; token = token->right)
+    if (IS_FUN(token->left)) ++size;
+
+  state->functions = (PureFunction *)calloc(size, sizeof(PureFunction));
+  if (!state->functions) return !size;
+
+  for (db::Token token = root; token; token = token->right)
+    if (IS_FUN(token->left))
+      state->functions[state->functionsSize++] = {
+        .name     = NAME(token->left->left),
+        .function = token->left,
+        .isPure   = true,
+      };
+
+  return true;
+}
+
+static void analyzePurity(EvaluatorState *state)
+{
+  assert(state);
+
+  bool isChanged = true;
+  while (isChanged && !state->isBroken)
+    {
+      isChanged = false;
+
+      for (size_t i = 0; i < state->functionsSize; ++i)
+        {
+          PureFunction *function = state->functions + i;
+          if (!function->isPure) continue;
+
+          state->slotsSize = 0;
+
+          bool isPure = true;
+          for (db::Token parameter = function->function->left->left;
+               parameter && isPure; parameter = parameter->right)
+            isPure = pushSlot(state, NAME(parameter->left->left), 0);
+
+          if (isPure && isPureBlock(state, function->function->right)) continue;
+
+          function->isPure = false;
+          isChanged = true;
+        }
+    }
+
+  for (size_t i = 0; i < state->functionsSize; ++i)
+    if (state->functions[i].isPure) ++state->pure;
+}
+
+static bool isPureBlock(EvaluatorState *state, const db::Token block)
+{
+  assert(state);
+
+  size_t slotsSize = state->slotsSize;
+
+  for (db::Token command = block; command; command = command->right)
+    if (!isPureStatement(state, command->left)) return false;
+
+  state->slotsSize = slotsSize;
+
+  return true;
+}
+
+static bool isPureBody(EvaluatorState *state, const db::Token body)
+{
+  assert(state);
+
+  if (IS_COMP(body)) return isPureBlock(state, body);
+
+  size_t slotsSize = state->slotsSize;
+
+  bool isPure = isPureStatement(state, body);
+
+  state->slotsSize = slotsSize;
+
+  return isPure;
+}
+
+static bool isPureStatement(EvaluatorState *state, const db::Token statement)
+{
+  assert(state);
+
+  if (!statement) return true;
+
+  if (IS_VAR(statement) || IS_VAL(statement))
+    return isPureExpression(state, statement->right) &&
+           pushSlot(state, NAME(statement->left), 0);
+
+  if (IS_ASSIGN(statement))
+    return searchSlot(state, NAME(statement->left)) &&
+           isPureExpression(state, statement->right);
+
+  if (IS_IF(statement))
+    {
+      if (!isPureExpression(state, statement->left)) return false;
+
+      if (IS_ELSE(statement->right))
+        return isPureBody(state, statement->right->left) &&
+               isPureBody(state, statement->right->right);
+
+      return isPureBody(state, statement->right);
+    }
+
+  if (IS_WHILE(statement))
+    return isPureExpression(state, statement->left) &&
+           isPureBody(state, statement->right);
+
+  if (IS_RETURN(statement)) return isPureExpression(state, statement->left);
+
+  if (IS_COMP(statement)) return isPureBlock(state, statement);
+
+  if (IS_IN(statement) || IS_OUT(statement)) return false;
+
+  return isPureExpression(state, statement);
+}
+
+static bool isPureExpression(EvaluatorState *state, const db::Token token)
+{
+  assert(state);
+
+  if (!token) return true;
+
+  if (IS_NUM(token)) return true;
+
+  // Globals may be changed by other functions
+  if (IS_NAME(token)) return searchSlot(state, NAME(token));
+
+  if (IS_CALL(token))
+    {
+      if (!token->left) return false;
+
+      const PureFunction *callee = searchPureFunction(state, NAME(token->left));
+      if (!callee || !callee->isPure) return false;
+
+      for (db::Token argument = token->left->left; argument; argument = argument->right)
+        if (!isPureExpression(state, argument->left)) return false;
+
+      return true;
+    }
+
+  if (!IS_STATEMENT(token)) return false;
+
+  switch (STATEMENT(token))
+    {
+    case db::STATEMENT_ADD:  case db::STATEMENT_SUB:
+    case db::STATEMENT_MUL:  case db::STATEMENT_DIV:
+    case db::STATEMENT_POW:  case db::STATEMENT_INT:
+    case db::STATEMENT_SIN:  case db::STATEMENT_COS:
+    case db::STATEMENT_TAN:  case db::STATEMENT_SQRT:
+    case db::STATEMENT_LESS: case db::STATEMENT_GREATER:
+    case db::STATEMENT_EQUAL: case db::STATEMENT_NOT_EQUAL:
+    case db::STATEMENT_AND:  case db::STATEMENT_OR:
+      return isPureExpression(state, token->left) &&
+             isPureExpression(state, token->right);
+    default: return false;
+    }
+}
+
+static PureFunction *searchPureFunction(EvaluatorState *state, const char *name)
+{
+  assert(state);
+  assert(name);
+
+  for (size_t i = 0; i < state->functionsSize; ++i)
+    if (db::compareStrings(state->functions[i].name, name))
+      return state->functions + i;
+
+  return nullptr;
+}
+
+static void foldCalls(EvaluatorState *state, db::Token token)
+{
+  assert(state);
+
+  if (!token || state->isBroken) return;
+
+  foldCalls(state, token->left );
+  foldCalls(state, token->right);
+
+  // Value of call as command is not used
+  if (!IS_CALL(token) || !token->left || IS_COMP(token->parent)) return;
+
+  const PureFunction *callee = searchPureFunction(state, NAME(token->left));
+  if (!callee || !callee->isPure || !hasNumericArguments(token)) return;
+
+  state->slotsSize = 0;
+  state->frame     = 0;
+  state->steps     = 0;
+  state->depth     = 0;
+
+  db::number_t value = 0;
+  if (!evaluateCall(state, token, &value) || !isfinite(value)) return;
+
+  db::removeNode(token->left);
+
+  token->type  = db::type_t::NUMBER;
+  token->value = {.number = value};
+  db::setChildren(token, nullptr, nullptr);
+
+  ++state->evaluated;
+}
+
+static bool hasNumericArguments(const db::Token call)
+{
+  assert(call);
+
+  for (db::Token argument = call->left->left; argument; argument = argument->right)
+    if (!argument->left || !IS_NUM(argument->left)) return false;
+
+  return true;
+}
+
+static bool evaluateCall(EvaluatorState *state, const db::Token call, db::number_t *result)
+{
+  assert(state);
+  assert(call);
+  assert(result);
+
+  const PureFunction *callee = searchPureFunction(state, NAME(call->left));
+  if (!callee || !callee->isPure || state->depth == MAX_DEPTH) return false;
+
+  // Void function has no value
+  if (!IS_TYPE(callee->function->left->right)) return false;
+
+  size_t slotsSize = state->slotsSize;
+  size_t frame     = state->frame;
+
+  // Arguments are evaluated in frame of caller, so they are bound after all
+  db::Token parameter = callee->function->left->left;
+  db::Token argument  = call->left->left;
+
+  for ( ; parameter && argument; parameter = parameter->right, argument = argument->right)
+    {
+      db::number_t value = 0;
+      if (!evaluateExpression(state, argument->left, &value) ||
+          !pushSlot(state, nullptr, value))
+        return false;
+    }
+
+  if (parameter || argument) return false;
+
+  size_t index = slotsSize;
+  for (parameter = callee->function->left->left; parameter; parameter = parameter->right)
+    state->slots[index++].name = NAME(parameter->left->left);
+
+  state->frame = slotsSize;
+  ++state->depth;
+
+  bool isReturned = false;
+  bool isOk =
+    executeBlock(state, callee->function->right, &isReturned, result) && isReturned;
+
+  --state->depth;
+  state->frame     = frame;
+  state->slotsSize = slotsSize;
+
+  return isOk;
+}
+
+static bool executeBlock(EvaluatorState *state, const db::Token block, bool *isReturned, db::number_t *result)
+{
+  assert(state);
+  assert(isReturned);
+  assert(result);
+
+  size_t slotsSize = state->slotsSize;
+
+  bool isOk = true;
+  for (db::Token command = block; command && isOk && !*isReturned; command = command->right)
+    isOk = executeStatement(state, command->left, isReturned, result);
+
+  state->slotsSize = slotsSize;
+
+  return isOk;
+}
+
+static bool executeBody(EvaluatorState *state, const db::Token body, bool *isReturned, db::number_t *result)
+{
+  assert(state);
+  assert(isReturned);
+  assert(result);
+
+  if (IS_COMP(body)) return executeBlock(state, body, isReturned, result);
+
+  size_t slotsSize = state->slotsSize;
+
+  bool isOk = executeStatement(state, body, isReturned, result);
+
+  state->slotsSize = slotsSize;
+
+  return isOk;
+}
+
+static bool executeStatement(
+                             EvaluatorState *state,
+                             const db::Token statement,
+                             bool *isReturned,
+                             db::number_t *result
+                            )
+{
+  assert(state);
+  assert(isReturned);
+  assert(result);
+
+  if (!statement) return true;
+
+  if (++state->steps > MAX_STEPS) return false;
+
+  db::number_t value = 0;
+
+  if (IS_VAR(statement) || IS_VAL(statement))
+    return evaluateExpression(state, statement->right, &value) &&
+           pushSlot(state, NAME(statement->left), value);
+
+  if (IS_ASSIGN(statement))
+    {
+      if (!evaluateExpression(state, statement->right, &value)) return false;
+
+      // Slots may be moved by evaluation of calls
+      Slot *slot = searchSlot(state, NAME(statement->left));
+      if (!slot) return false;
+
+      slot->value = value;
+      return true;
+    }
+
+  if (IS_IF(statement))
+    {
+      if (!evaluateExpression(state, statement->left, &value)) return false;
+
+      bool hasElse = IS_ELSE(statement->right);
+
+      if (isTrue(value))
+        return executeBody(state, hasElse ? statement->right->left : statement->right,
+                           isReturned, result);
+
+      return !hasElse || executeBody(state, statement->right->right, isReturned, result);
+    }
+
+  if (IS_WHILE(statement))
+    {
+      while (!*isReturned)
+        {
+          if (++state->steps > MAX_STEPS) return false;
+
+          if (!evaluateExpression(state, statement->left, &value)) return false;
+          if (!isTrue(value)) break;
+
+          if (!executeBody(state, statement->right, isReturned, result)) return false;
+        }
+
+      return true;
+    }
+
+  if (IS_RETURN(statement))
+    {
+      if (!statement->left || !evaluateExpression(state, statement->left, result)) return false;
+
+      *isReturned = true;
+      return true;
+    }
+
+  if (IS_COMP(statement)) return executeBlock(state, statement, isReturned, result);
+
+  return evaluateExpression(state, statement, &value);
+}
+
+static bool evaluateExpression(EvaluatorState *state, const db::Token token, db::number_t *value)
+{
+  assert(state);
+  assert(value);
+
+  if (!token || ++state->steps > MAX_STEPS) return false;
+
+  if (IS_NUM(token))
+    {
+      *value = NUMBER(token);
+      return true;
+    }
+
+  if (IS_NAME(token))
+    {
+      const Slot *slot = searchSlot(state, NAME(token));
+      if (!slot) return false;
+
+      *value = slot->value;
+      return true;
+    }
+
+  if (IS_CALL(token)) return evaluateCall(state, token, value);
+
+  if (!IS_STATEMENT(token)) return false;
+
+  db::number_t left  = 0;
+  db::number_t right = 0;
+
+  if (token->left  && !evaluateExpression(state, token->left , &left )) return false;
+  if (token->right && !evaluateExpression(state, token->right, &right)) return false;
+
+  return db::calculateStatement(STATEMENT(token), left, token->right ? &right : nullptr, value) &&
+         isfinite(*value);
+}
+
+static bool isTrue(db::number_t value)
+{
+  return !db::compareNumber(value, 0);
+}
+
+static bool pushSlot(EvaluatorState *state, const char *name, db::number_t value)
+{
+  assert(state);
+
+  if (state->slotsSize == state->slotsCapacity)
+    {
+      size_t capacity = GROWTH_FACTOR*state->slotsCapacity + 1;
+      Slot *temp = (Slot *)recalloc(state->slots, capacity, sizeof(Slot));
+      if (!temp)
+        {
+          state->isBroken = true;
+          return false;
+        }
+
+      state->slots         = temp;
+      state->slotsCapacity = capacity;
+    }
+
+  state->slots[state->slotsSize++] = { .name = name, .value = value };
+
+  return true;
+}
+
+static Slot *searchSlot(EvaluatorState *state, const char *name)
+{
+  assert(state);
+  assert(name);
+
+  for (size_t i = state->slotsSize; i > state->frame; --i)
+    {
+      Slot *slot = state->slots + i - 1;
+      if (slot->name && db::compareStrings(slot->name, name)) return slot;
+    }
+
+  return nullptr;
+}
@@ -0,0 +1,621 @@
+#include "ExpressionDag.h"
+
+#include <malloc.h>
+#include <string.h>
+#include "SystemLike.h"
+#include "ErrorHandler.h"
+#include "Error.h"
+#include "Assert.h"
+#include "DSL.h"
+
+#pragma GCC diagnostic ignored "-Wswitch-enum"
+
+#define DERIVE(RESULT, NODE)                                     \
+  size_t RESULT = db::differentiate(dag, NODE, variable, error); \
+  if (RESULT == db::DAG_NIL) return db::DAG_NIL
+
+const int GROWTH_FACTOR = 2;
+
+const size_t START_TABLE_CAPACITY = 64;
+
+const db::hash_t DAG_SEED = 0xcbf29ce484222325ull;
+
+static db::hash_t hashDagNode(const db::DagNode *node);
+
+static bool isSameNode(const db::DagNode *first, const db::DagNode *second);
+
+static bool growTable(db::ExpressionDag *dag);
+
+static bool growDerivatives(db::ExpressionDag *dag);
+
+static size_t searchDerivative(const db::ExpressionDag *dag, size_t node, const char *variable);
+
+static size_t addNode(
+                      db::ExpressionDag *dag,
+                      db::type_t type,
+                      db::treeValue_t value,
+                      size_t left,
+                      size_t right
+                     );
+
+static size_t addNumber(db::ExpressionDag *dag, db::number_t number);
+
+/// Add statement with folding of constants and identities (x*1, x+0, ...)
+static size_t addStatement(db::ExpressionDag *dag, db::statement_t statement, size_t left, size_t right);
+
+static size_t addUnary (db::ExpressionDag *dag, db::statement_t statement, size_t operand);
+static size_t addBinary(db::ExpressionDag *dag, db::statement_t statement, size_t left, size_t right);
+
+static bool isNumber(const db::ExpressionDag *dag, size_t node, db::number_t number);
+
+static const char *findVariable(const db::TreeNode *token);
+
+static size_t deriveNode(db::ExpressionDag *dag, size_t node, const char *variable, int *error);
+
+static db::TreeNode *createOperand(const db::ExpressionDag *dag, size_t node, char *const *names, int *error);
+
+void db::initExpressionDag(db::ExpressionDag *dag, int *error)
+{
+  if (!dag) ERROR();
+
+  dag->nodes    = nullptr;
+  dag->size     = 0;
+  dag->capacity = 0;
+
+  dag->table         = nullptr;
+  dag->tableCapacity = 0;
+
+  dag->derivatives         = nullptr;
+  dag->derivativesSize     = 0;
+  dag->derivativesCapacity = 0;
+}
+
+void db::destroyExpressionDag(db::ExpressionDag *dag, int *error)
+{
+  if (!dag) ERROR();
+
+  free(dag->nodes);
+  free(dag->table);
+  free(dag->derivatives);
+
+  db::initExpressionDag(dag);
+}
+
+size_t db::addExpression(db::ExpressionDag *dag, const db::TreeNode *token, int *error)
+{
+  if (!dag || !token) ERROR(db::DAG_NIL);
+
+  switch (token->type)
+    {
+    case db::type_t::NUMBER: return addNumber(dag, NUMBER(token));
+    case db::type_t::NAME:
+      {
+        if (token->left || token->right) break;
+
+        return addNode(dag, db::type_t::NAME, token->value, db::DAG_NIL, db::DAG_NIL);
+      }
+    case db::type_t::STATEMENT:
+      {
+        switch (STATEMENT(token))
+          {
+          case db::STATEMENT_ADD:
+          case db::STATEMENT_SUB:
+          case db::STATEMENT_MUL:
+          case db::STATEMENT_DIV:
+          case db::STATEMENT_POW:
+          case db::STATEMENT_SIN:
+          case db::STATEMENT_COS:
+          case db::STATEMENT_TAN:
+          case db::STATEMENT_SQRT:
+          case db::STATEMENT_INT:
+            {
+              if (!token->left) break;
+
+              size_t left = db::addExpression(dag, token->left, error);
+              if (left == db::DAG_NIL) return db::DAG_NIL;
+
+              if (!token->right)
+                return addUnary(dag, STATEMENT(token), left);
+
+              size_t right = db::addExpression(dag, token->right, error);
+              if (right == db::DAG_NIL) return db::DAG_NIL;
+
+              return addBinary(dag, STATEMENT(token), left, right);
+            }
+          case db::STATEMENT_DIFF:
+            {
+              if (!token->left) break;
+
+              size_t operand = db::addExpression(dag, token->left, error);
+              if (operand == db::DAG_NIL) return db::DAG_NIL;
+
+              const char *variable = findVariable(token->left);
+              if (!variable) return addNumber(dag, 0);
+
+              return db::differentiate(dag, operand, variable, error);
+            }
+          default:
+            {
+              handleError("Can`t differentiate expression with '%s'",
+                          db::STATEMENT_NAMES[STATEMENT(token)]);
+              ERROR(db::DAG_NIL);
+            }
+          }
+        break;
+      }
+    default: break;
+    }
+
+  handleError("Can`t differentiate expression");
+  ERROR(db::DAG_NIL);
+}
+
+size_t db::differentiate(db::ExpressionDag *dag, size_t node, const char *variable, int *error)
+{
+  if (!dag || node >= dag->size || !variable) ERROR(db::DAG_NIL);
+
+  size_t slot = searchDerivative(dag, node, variable);
+  if (slot != db::DAG_NIL && dag->derivatives[slot].node != db::DAG_NIL)
+    return dag->derivatives[slot].derivative;
+
+  size_t derivative = deriveNode(dag, node, variable, error);
+  if (derivative == db::DAG_NIL) ERROR(db::DAG_NIL);
+
+  if (2*(dag->derivativesSize + 1) > dag->derivativesCapacity && !growDerivatives(dag))
+    ERROR(db::DAG_NIL);
+
+  slot = searchDerivative(dag, node, variable);
+
+  dag->derivatives[slot] = {
+    .node       = node,
+    .variable   = variable,
+    .derivative = derivative,
+  };
+  ++dag->derivativesSize;
+
+  return derivative;
+}
+
+void db::countReferences(const db::ExpressionDag *dag, size_t node, size_t *references, int *error)
+{
+  if (!dag || node >= dag->size || !references) ERROR();
+
+  const size_t operands[] = {dag->nodes[node].left, dag->nodes[node].right};
+
+  for (size_t i = 0; i < sizeof(operands)/sizeof(operands[0]); ++i)
+    if (operands[i] != db::DAG_NIL && !references[operands[i]]++)
+      db::countReferences(dag, operands[i], references, error);
+}
+
+db::TreeNode *db::createTree(
+                             const db::ExpressionDag *dag,
+                             size_t node,
+                             char *const *names,
+                             int *error
+                            )
+{
+  if (!dag || node >= dag->size) ERROR(nullptr);
+
+  const db::DagNode *dagNode = dag->nodes + node;
+
+  db::TreeNode *left  = nullptr;
+  db::TreeNode *right = nullptr;
+
+  if (dagNode->left != db::DAG_NIL)
+    {
+      left = createOperand(dag, dagNode->left, names, error);
+      if (!left) ERROR(nullptr);
+    }
+
+  if (dagNode->right != db::DAG_NIL)
+    {
+      right = createOperand(dag, dagNode->right, names, error);
+      if (!right)
+        {
+          if (left) db::removeNode(left);
+          ERROR(nullptr);
+        }
+    }
+
+  int errorCode = 0;
+  db::TreeNode *token = db::createNode(dagNode->value, dagNode->type, left, right, &errorCode);
+  if (errorCode)
+    {
+      if (left ) db::removeNode(left );
+      if (right) db::removeNode(right);
+      ERROR(nullptr);
+    }
+
+  return token;
+}
+
+static db::TreeNode *createOperand(const db::ExpressionDag *dag, size_t node, char *const *names, int *error)
+{
+  assert(dag);
+
+  if (names && names[node])
+    return db::createNode({.name = names[node]}, db::type_t::NAME, error);
+
+  return db::createTree(dag, node, names, error);
+}
+
+static size_t deriveNode(db::ExpressionDag *dag, size_t node, const char *variable, int *error)
+{
+  assert(dag);
+  assert(variable);
+
+  db::DagNode token = dag->nodes[node];
+
+  if (token.type == db::type_t::NUMBER)
+    return addNumber(dag, 0);
+
+  if (token.type == db::type_t::NAME)
+    return addNumber(dag, strcmp(token.value.name, variable) ? 0 : 1);
+
+  size_t u = token.left;
+  size_t v = token.right;
+
+  switch (token.value.statement)
+    {
+    case db::STATEMENT_ADD:
+    case db::STATEMENT_SUB:
+      {
+        DERIVE(du, u);
+
+        if (v == db::DAG_NIL) return addUnary(dag, token.value.statement, du);
+
+        DERIVE(dv, v);
+
+        return addBinary(dag, token.value.statement, du, dv);
+      }
+    case db::STATEMENT_MUL:
+      {
+        DERIVE(du, u);
+        DERIVE(dv, v);
+
+        return addBinary(dag, db::STATEMENT_ADD,
+                         addBinary(dag, db::STATEMENT_MUL, du, v),
+                         addBinary(dag, db::STATEMENT_MUL, u, dv));
+      }
+    case db::STATEMENT_DIV:
+      {
+        DERIVE(du, u);
+        DERIVE(dv, v);
+
+        return addBinary(dag, db::STATEMENT_DIV,
+                         addBinary(dag, db::STATEMENT_SUB,
+                                   addBinary(dag, db::STATEMENT_MUL, du, v),
+                                   addBinary(dag, db::STATEMENT_MUL, u, dv)),
+                         addBinary(dag, db::STATEMENT_MUL, v, v));
+      }
+    case db::STATEMENT_POW:
+      {
+        if (dag->nodes[v].type != db::type_t::NUMBER)
+          {
+            handleError("Can`t differentiate power with not constant exponent");
+            ERROR(db::DAG_NIL);
+          }
+
+        DERIVE(du, u);
+
+        db::number_t exponent = dag->nodes[v].value.number;
+
+        return addBinary(dag, db::STATEMENT_MUL,
+                         addBinary(dag, db::STATEMENT_MUL,
+                                   addNumber(dag, exponent),
+                                   addBinary(dag, db::STATEMENT_POW, u,
+                                             addNumber(dag, exponent - 1))),
+                         du);
+      }
+    case db::STATEMENT_SIN:
+      {
+        DERIVE(du, u);
+
+        return addBinary(dag, db::STATEMENT_MUL,
+                         addUnary(dag, db::STATEMENT_COS, u), du);
+      }
+    case db::STATEMENT_COS:
+      {
+        DERIVE(du, u);
+
+        return addUnary(dag, db::STATEMENT_SUB,
+                        addBinary(dag, db::STATEMENT_MUL,
+                                  addUnary(dag, db::STATEMENT_SIN, u), du));
+      }
+    case db::STATEMENT_TAN:
+      {
+        DERIVE(du, u);
+
+        size_t cosine = addUnary(dag, db::STATEMENT_COS, u);
+
+        return addBinary(dag, db::STATEMENT_DIV, du,
+                         addBinary(dag, db::STATEMENT_MUL, cosine, cosine));
+      }
+    case db::STATEMENT_SQRT:
+      {
+        DERIVE(du, u);
+
+        return addBinary(dag, db::STATEMENT_DIV, du,
+                         addBinary(dag, db::STATEMENT_MUL, addNumber(dag, 2), node));
+      }
+    case db::STATEMENT_INT: return addNumber(dag, 0);
+    default: ERROR(db::DAG_NIL);
+    }
+}
+
+static const char *findVariable(const db::TreeNode *token)
+{
+  if (!token) return nullptr;
+
+  if (IS_NAME(token) && !token->left && !token->right) return NAME(token);
+
+  const char *variable = findVariable(token->left);
+
+  return variable ? variable : findVariable(token->right);
+}
+
+static size_t addNumber(db::ExpressionDag *dag, db::number_t number)
+{
+  return addNode(dag, db::type_t::NUMBER, {.number = number}, db::DAG_NIL, db::DAG_NIL);
+}
+
+static size_t addUnary(db::ExpressionDag *dag, db::statement_t statement, size_t operand)
+{
+  if (operand == db::DAG_NIL) return db::DAG_NIL;
+
+  return addStatement(dag, statement, operand, db::DAG_NIL);
+}
+
+static size_t addBinary(db::ExpressionDag *dag, db::statement_t statement, size_t left, size_t right)
+{
+  if (left == db::DAG_NIL || right == db::DAG_NIL) return db::DAG_NIL;
+
+  return addStatement(dag, statement, left, right);
+}
+
+static bool isNumber(const db::ExpressionDag *dag, size_t node, db::number_t number)
+{
+  assert(dag);
+
+  return node != db::DAG_NIL &&
+    dag->nodes[node].type == db::type_t::NUMBER &&
+    db::compareNumber(dag->nodes[node].value.number, number);
+}
+
+static size_t addStatement(db::ExpressionDag *dag, db::statement_t statement, size_t left, size_t right)
+{
+  assert(dag);
+  assert(left != db::DAG_NIL);
+
+  bool isConstant =
+    dag->nodes[left].type == db::type_t::NUMBER &&
+    (right == db::DAG_NIL || dag->nodes[right].type == db::type_t::NUMBER);
+
+  db::number_t a = dag->nodes[left].value.number;
+  db::number_t b = (right == db::DAG_NIL ? 0 : dag->nodes[right].value.number);
+
+  switch (statement)
+    {
+    case db::STATEMENT_ADD:
+      {
+        if (right == db::DAG_NIL)    return left;
+        if (isConstant)              return addNumber(dag, a + b);
+        if (isNumber(dag, left , 0)) return right;
+        if (isNumber(dag, right, 0)) return left;
+        break;
+      }
+    case db::STATEMENT_SUB:
+      {
+        if (right == db::DAG_NIL)
+          {
+            if (isConstant) return addNumber(dag, -a);
+
+            const db::DagNode *operand = dag->nodes + left;
+            if (operand->type == db::type_t::STATEMENT &&
+                operand->value.statement == db::STATEMENT_SUB &&
+                operand->right == db::DAG_NIL) return operand->left;
+            break;
+          }
+        if (isConstant)              return addNumber(dag, a - b);
+        if (left == right)           return addNumber(dag, 0);
+        if (isNumber(dag, right, 0)) return left;
+        if (isNumber(dag, left , 0)) return addStatement(dag, db::STATEMENT_SUB, right, db::DAG_NIL);
+        break;
+      }
+    case db::STATEMENT_MUL:
+      {
+        if (isConstant)              return addNumber(dag, a * b);
+        if (isNumber(dag, left , 0) ||
+            isNumber(dag, right, 0)) return addNumber(dag, 0);
+        if (isNumber(dag, left , 1)) return right;
+        if (isNumber(dag, right, 1)) return left;
+        break;
+      }
+    case db::STATEMENT_DIV:
+      {
+        if (isConstant && !db::compareNumber(b, 0)) return addNumber(dag, a / b);
+        if (isNumber(dag, left , 0)) return addNumber(dag, 0);
+        if (isNumber(dag, right, 1)) return left;
+        break;
+      }
+    case db::STATEMENT_POW:
+      {
+        if (isNumber(dag, right, 0)) return addNumber(dag, 1);
+        if (isNumber(dag, right, 1)) return left;
+        break;
+      }
+    default: break;
+    }
+
+  return addNode(dag, db::type_t::STATEMENT, {.statement = statement}, left, right);
+}
+
+static size_t addNode(
+                      db::ExpressionDag *dag,
+                      db::type_t type,
+                      db::treeValue_t value,
+                      size_t left,
+                      size_t right
+                     )
+{
+  assert(dag);
+
+  db::DagNode node = {
+    .type  = type,
+    .value = value,
+    .left  = left,
+    .right = right,
+    .hash  = 0,
+  };
+  node.hash = hashDagNode(&node);
+
+  if (2*(dag->size + 1) > dag->tableCapacity && !growTable(dag))
+    return db::DAG_NIL;
+
+  size_t mask = dag->tableCapacity - 1;
+  size_t slot = node.hash & mask;
+  for ( ; dag->table[slot] != db::DAG_NIL; slot = (slot + 1) & mask)
+    if (isSameNode(dag->nodes + dag->table[slot], &node))
+      return dag->table[slot];
+
+  if (dag->size == dag->capacity)
+    {
+      dag->capacity = GROWTH_FACTOR*dag->capacity + 1;
+      db::DagNode *temp =
+        (db::DagNode *)recalloc(dag->nodes, dag->capacity, sizeof(db::DagNode));
+      if (!temp) return db::DAG_NIL;
+
+      dag->nodes = temp;
+    }
+
+  dag->nodes[dag->size] = node;
+  dag->table[slot] = dag->size;
+
+  return dag->size++;
+}
+
+static db::hash_t hashDagNode(const db::DagNode *node)
+{
+  assert(node);
+
+  db::hash_t hash = db::combineHash(DAG_SEED, &node->type, sizeof(node->type));
+
+  switch (node->type)
+    {
+    case db::type_t::STATEMENT:
+      hash = db::combineHash(hash, &node->value.statement, sizeof(node->value.statement));
+      break;
+    case db::type_t::NUMBER:
+      hash = db::combineHash(hash, &node->value.number, sizeof(node->value.number));
+      break;
+    case db::type_t::NAME:
+    case db::type_t::STRING:
+      hash = db::combineHash(hash, node->value.name, strlen(node->value.name) + 1);
+      break;
+    default: break;
+    }
+
+  hash = db::combineHash(hash, &node->left , sizeof(node->left ));
+  hash = db::combineHash(hash, &node->right, sizeof(node->right));
+
+  return hash;
+}
+
+static bool isSameNode(const db::DagNode *first, const db::DagNode *second)
+{
+  assert(first);
+  assert(second);
+
+  if (first->hash  != second->hash  ||
+      first->type  != second->type  ||
+      first->left  != second->left  ||
+      first->right != second->right) return false;
+
+  switch (first->type)
+    {
+    case db::type_t::STATEMENT:
+      return first->value.statement == second->value.statement;
+    case db::type_t::NUMBER:
+      return !memcmp(&first->value.number, &second->value.number, sizeof(db::number_t));
+    case db::type_t::NAME:
+    case db::type_t::STRING:
+      return !strcmp(first->value.name, second->value.name);
+    default: return false;
+    }
+}
+
+static bool growTable(db::ExpressionDag *dag)
+{
+  assert(dag);
+
+  size_t capacity = dag->tableCapacity ? GROWTH_FACTOR*dag->tableCapacity : START_TABLE_CAPACITY;
+
+  size_t *table = (size_t *)calloc(capacity, sizeof(size_t));
+  if (!table) return false;
+
+  memset(table, 0xff, capacity*sizeof(size_t));
+
+  size_t mask = capacity - 1;
+  for (size_t i = 0; i < dag->size; ++i)
+    {
+      size_t slot = dag->nodes[i].hash & mask;
+      while (table[slot] != db::DAG_NIL) slot = (slot + 1) & mask;
+
+      table[slot] = i;
+    }
+
+  free(dag->table);
+  dag->table         = table;
+  dag->tableCapacity = capacity;
+
+  return true;
+}
+
+static size_t searchDerivative(const db::ExpressionDag *dag, size_t node, const char *variable)
+{
+  assert(dag);
+  assert(variable);
+
+  if (!dag->derivativesCapacity) return db::DAG_NIL;
+
+  db::hash_t hash = db::combineHash(DAG_SEED, &node, sizeof(node));
+  hash = db::combineHash(hash, variable, strlen(variable));
+
+  size_t mask = dag->derivativesCapacity - 1;
+  size_t slot = hash & mask;
+  for ( ; dag->derivatives[slot].node != db::DAG_NIL; slot = (slot + 1) & mask)
+    if (dag->derivatives[slot].node == node &&
+        !strcmp(dag->derivatives[slot].variable, variable)) break;
+
+  return slot;
+}
+
+static bool growDerivatives(db::ExpressionDag *dag)
+{
+  assert(dag);
+
+  db::DagDerivative *old = dag->derivatives;
+  size_t oldCapacity = dag->derivativesCapacity;
+
+  size_t capacity = oldCapacity ? GROWTH_FACTOR*oldCapacity : START_TABLE_CAPACITY;
+
+  dag->derivatives = (db::DagDerivative *)calloc(capacity, sizeof(db::DagDerivative));
+  if (!dag->derivatives)
+    {
+      dag->derivatives = old;
+      return false;
+    }
+
+  for (size_t i = 0; i < capacity; ++i)
+    dag->derivatives[i].node = db::DAG_NIL;
+
+  dag->derivativesCapacity = capacity;
+
+  for (size_t i = 0; i < oldCapacity; ++i)
+    if (old[i].node != db::DAG_NIL)
+      dag->derivatives[searchDerivative(dag, old[i].node, old[i].variable)] = old[i];
+
+  free(old);
+
+  return true;
+}
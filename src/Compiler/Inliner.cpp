@@ -0,0 +1,978 @@
+#include "Translator.h"
+
+#include <stdio.h>
+#include <malloc.h>
+#include "DSL.h"
+#include "Assert.h"
+#include "SystemLike.h"
+#include "Logging.h"
+#include "Error.h"
+
+const int GROWTH_FACTOR = 2;
+
+/// Functions up to this count of nodes are inlined at every call
+const size_t SMALL_FUNCTION_SIZE = 64;
+
+/// Functions with one call are inlined up to this count of nodes
+const size_t SINGLE_CALL_FUNCTION_SIZE = 1024;
+
+/// Inlining may add at most this count of program sizes
+const size_t MAX_GROWTH = 2;
+
+struct Callee {
+  const char *name;
+  db::Token   function;
+  size_t      size;
+  size_t      calls;
+  bool        hasType;
+  bool        isRecursive;
+  bool        isQuiet; ///< Without in, out, calls and writes of globals, so it may be reordered
+};
+
+/// Name visible in block and its replacement in copy of callee
+struct Renaming {
+  const char *name;
+  char       *newName; ///< nullptr if name is replaced by value
+  db::Token   value;
+};
+
+struct InlinerState {
+  db::Translator *translator;
+
+  Callee *callees;
+  size_t  calleesSize;
+
+  /// Locals of caller, then renamings of callee
+  Renaming *scope;
+  size_t    scopeSize;
+  size_t    scopeCapacity;
+  size_t    calleeScope; ///< First renaming of callee
+
+  bool isRejected; ///< Copy of callee can not be inlined
+
+  size_t budget;
+  size_t inlined;
+  size_t added;
+  size_t countOfNames;
+};
+
+static bool collectCallees(InlinerState *state);
+
+static void countCalls(InlinerState *state, const db::Token token);
+
+static bool isReaching(InlinerState *state, const db::Token token, const Callee *target, bool *visited);
+
+static Callee *searchCallee(InlinerState *state, const char *name);
+
+static bool isQuiet(InlinerState *state, const db::Token function);
+
+static bool isQuietBlock(InlinerState *state, const db::Token block);
+
+static bool isQuietStatement(InlinerState *state, const db::Token token);
+
+static bool inlineInFunction(InlinerState *state, db::Token function);
+
+static bool inlineInBlock(InlinerState *state, db::Token block);
+
+/// Inline call of statement, command may be replaced by inlined commands
+/// @return First command which holds code of statement or nullptr if was error
+static db::Token inlineInCommand(InlinerState *state, db::Token command);
+
+/// Expression of statement which is evaluated once before its effect
+static db::Token *getHoistable(db::Token statement);
+
+/// Innermost call of expression which may be inlined
+static db::Token findCall(InlinerState *state, db::Token token);
+
+static bool areCallsQuiet(InlinerState *state, const db::Token token);
+
+static bool canInline(InlinerState *state, const db::Token call, bool isStatement);
+
+/// Build commands with code of callee
+/// @param [out] result Name of local with returned value or nullptr
+/// @return First command or nullptr if callee was rejected or was error
+static db::Token expandCall(InlinerState *state, db::Token call, char **result);
+
+static bool bindParameters(InlinerState *state, const Callee *callee, db::Token call, db::Token *declarations);
+
+static bool isAssigned(const db::Token token, const char *name);
+
+/// Name is declared in caller, so callee can not change it
+static bool isCallerLocal(const InlinerState *state, const char *name);
+
+static bool renameBlock(InlinerState *state, db::Token block);
+
+static bool renameStatement(InlinerState *state, db::Token token);
+
+static bool renameExpression(InlinerState *state, db::Token token);
+
+static void renameTarget(InlinerState *state, db::Token token);
+
+static const Renaming *searchRenaming(const InlinerState *state, const char *name, size_t start);
+
+static bool pushRenaming(InlinerState *state, const char *name, char *newName, db::Token value);
+
+static char *createName(InlinerState *state);
+
+/// Replace return by assignment of result, commands after if with return are moved into its branches
+static bool convertReturns(InlinerState *state, db::Token *block, char *result);
+
+static bool alwaysReturns(const db::Token block);
+
+static bool hasReturn(const db::Token token);
+
+static size_t countAssignments(const db::Token token, const char *name);
+
+static db::Token createCommand(db::Token statement);
+
+static db::Token lastCommand(db::Token block);
+
+void db::inlineFunctions(db::Translator *translator, int *error)
+{
+  if (!translator || !translator->grammar.root) ERROR();
+
+  InlinerState state{};
+  state.translator = translator;
+  state.budget     = MAX_GROWTH*db::countNodes(translator->grammar.root);
+
+  bool isOk = collectCallees(&state);
+
+  for (db::Token token = translator->grammar.root; token && isOk; token = token->right)
+    if (IS_FUN(token->left))
+      isOk = inlineInFunction(&state, token->left);
+
+  free(state.callees);
+  free(state.scope);
+
+  if (!isOk) ERROR();
+
+  // Arguments substituted into callees may be folded
+  if (state.inlined) db::simplyGrammar(translator, error);
+
+  FILE *log = getLogFile();
+  if (!log) return;
+
+  fprintf(log, "<pre>Inliner: %zu calls inlined, %zu nodes added</pre>\n",
+          state.inlined, state.added);
+}
+
+static bool collectCallees(InlinerState *state)
+{
+  assert(state);
+
+  db::Token root = state->translator->grammar.root;
+
+  size_t size = 0;
+  for (db::Token token = root; token; token = token->right)
+    if (IS_FUN(token->left)) ++size;
+
+  state->callees = (Callee *)calloc(size, sizeof(Callee));
+  if (!state->callees) return !size;
+
+  for (db::Token token = root; token; token = token->right)
+    {
+      db::Token function = token->left;
+      if (!IS_FUN(function)) continue;
+
+      state->callees[state->calleesSize++] = {
+        .name        = NAME(function->left),
+        .function    = function,
+        .size        = db::countNodes(function->right),
+        .calls       = 0,
+        .hasType     = IS_TYPE(function->left->right),
+        .isRecursive = false,
+        .isQuiet     = false,
+      };
+    }
+
+  countCalls(state, root);
+
+  bool *visited = (bool *)calloc(state->calleesSize, sizeof(bool));
+  if (!visited) return false;
+
+  for (size_t i = 0; i < state->calleesSize; ++i)
+    {
+      Callee *callee = state->callees + i;
+
+      for (size_t j = 0; j < state->calleesSize; ++j)
+        visited[j] = false;
+
+      callee->isRecursive = isReaching(state, callee->function->right, callee, visited);
+      callee->isQuiet     = isQuiet(state, callee->function);
+    }
+
+  free(visited);
+
+  return true;
+}
+
+static void countCalls(InlinerState *state, const db::Token token)
+{
+  assert(state);
+
+  if (!token) return;
+
+  if (IS_CALL(token) && token->left)
+    {
+      Callee *callee = searchCallee(state, NAME(token->left));
+      if (callee) ++callee->calls;
+    }
+
+  countCalls(state, token->left );
+  countCalls(state, token->right);
+}
+
+static bool isReaching(InlinerState *state, const db::Token token, const Callee *target, bool *visited)
+{
+  assert(state);
+  assert(target);
+  assert(visited);
+
+  if (!token) return false;
+
+  if (IS_CALL(token) && token->left)
+    {
+      Callee *callee = searchCallee(state, NAME(token->left));
+
+      if (callee == target) return true;
+
+      if (callee && !visited[callee - state->callees])
+        {
+          visited[callee - state->callees] = true;
+          if (isReaching(state, callee->function->right, target, visited)) return true;
+        }
+    }
+
+  return isReaching(state, token->left , target, visited) ||
+         isReaching(state, token->right, target, visited);
+}
+
+static Callee *searchCallee(InlinerState *state, const char *name)
+{
+  assert(state);
+  assert(name);
+
+  for (size_t i = 0; i < state->calleesSize; ++i)
+    if (db::compareStrings(state->callees[i].name, name))
+      return state->callees + i;
+
+  return nullptr;
+}
+
+static bool isQuiet(InlinerState *state, const db::Token function)
+{
+  assert(state);
+  assert(function);
+
+  state->scopeSize = 0;
+
+  for (db::Token parameter = function->left->left; parameter; parameter = parameter->right)
+    if (!pushRenaming(state, NAME(parameter->left->left), nullptr, nullptr))
+      return false;
+
+  bool isQuietFunction = isQuietBlock(state, function->right);
+
+  state->scopeSize = 0;
+
+  return isQuietFunction;
+}
+
+static bool isQuietBlock(InlinerState *state, const db::Token block)
+{
+  assert(state);
+
+  size_t scopeSize = state->scopeSize;
+
+  bool isQuietCode = true;
+  for (db::Token command = block; command && isQuietCode; command = command->right)
+    isQuietCode = isQuietStatement(state, command->left);
+
+  state->scopeSize = scopeSize;
+
+  return isQuietCode;
+}
+
+static bool isQuietStatement(InlinerState *state, const db::Token token)
+{
+  assert(state);
+
+  if (!token) return true;
+
+  if (IS_CALL(token) || IS_IN(token) || IS_OUT(token)) return false;
+
+  if (IS_VAR(token) || IS_VAL(token))
+    return isQuietStatement(state, token->right) &&
+           pushRenaming(state, NAME(token->left), nullptr, nullptr);
+
+  if (IS_ASSIGN(token))
+    return searchRenaming(state, NAME(token->left), 0) &&
+           isQuietStatement(state, token->right);
+
+  if (IS_IF(token) && IS_ELSE(token->right))
+    return isQuietStatement(state, token->left) &&
+           isQuietBlock(state, token->right->left) &&
+           isQuietBlock(state, token->right->right);
+
+  if (IS_IF(token) || IS_WHILE(token))
+    return isQuietStatement(state, token->left) &&
+           isQuietBlock(state, token->right);
+
+  if (IS_COMP(token)) return isQuietBlock(state, token);
+
+  return isQuietStatement(state, token->left) &&
+         isQuietStatement(state, token->right);
+}
+
+static bool inlineInFunction(InlinerState *state, db::Token function)
+{
+  assert(state);
+  assert(function);
+
+  state->scopeSize = 0;
+
+  for (db::Token parameter = function->left->left; parameter; parameter = parameter->right)
+    {
+      char *name = NAME(parameter->left->left);
+      if (!pushRenaming(state, name, name, nullptr)) return false;
+    }
+
+  return inlineInBlock(state, function->right);
+}
+
+static bool inlineInBlock(InlinerState *state, db::Token block)
+{
+  assert(state);
+
+  size_t scopeSize = state->scopeSize;
+
+  for (db::Token command = block; command; command = command->right)
+    {
+      command = inlineInCommand(state, command);
+      if (!command) return false;
+
+      db::Token statement = command->left;
+      bool isOk = true;
+
+      if (IS_IF(statement) && IS_ELSE(statement->right))
+        isOk = inlineInBlock(state, statement->right->left ) &&
+               inlineInBlock(state, statement->right->right);
+      else if (IS_IF(statement) || IS_WHILE(statement))
+        isOk = inlineInBlock(state, statement->right);
+      else if (IS_COMP(statement))
+        isOk = inlineInBlock(state, statement);
+      else if (IS_VAR(statement) || IS_VAL(statement))
+        isOk = pushRenaming(state, NAME(statement->left), NAME(statement->left), nullptr);
+
+      if (!isOk) return false;
+    }
+
+  state->scopeSize = scopeSize;
+
+  return true;
+}
+
+static db::Token inlineInCommand(InlinerState *state, db::Token command)
+{
+  assert(state);
+  assert(command);
+
+  db::Token statement = command->left;
+
+  bool isStatement = IS_CALL(statement);
+
+  db::Token *hoistable = getHoistable(statement);
+  db::Token  call      = nullptr;
+
+  if (isStatement)
+    call = (canInline(state, statement, true) ? statement : nullptr);
+  else if (hoistable && areCallsQuiet(state, *hoistable))
+    call = findCall(state, *hoistable);
+
+  if (!call) return command;
+
+  char *result = nullptr;
+  db::Token code = expandCall(state, call, &result);
+
+  if (!code)
+    {
+      if (!state->isRejected) return nullptr;
+
+      state->isRejected = false;
+      return command;
+    }
+
+  db::Token last = lastCommand(code);
+
+  if (isStatement)
+    {
+      last->right = command->right;
+      db::removeNode(statement);
+    }
+  else
+    {
+      db::Token next = createCommand(statement);
+      if (!next) { db::removeNode(code); return nullptr; }
+
+      next->right = command->right;
+      last->right = next;
+
+      db::removeNode(call->left);
+      call->type  = db::type_t::NAME;
+      call->value = {.name = result};
+      db::setChildren(call, nullptr, nullptr);
+    }
+
+  // Command becomes first command of inlined code, which is visited again for nested calls
+  db::setChildren(command, code->left, code->right);
+  code->left = code->right = nullptr;
+  db::removeNode(code);
+
+  return inlineInCommand(state, command);
+}
+
+static db::Token *getHoistable(db::Token statement)
+{
+  if (IS_ASSIGN(statement) || IS_VAR(statement) || IS_VAL(statement))
+    return &statement->right;
+
+  if (IS_IF(statement) || IS_RETURN(statement) || IS_OUT(statement))
+    return &statement->left;
+
+  return nullptr;
+}
+
+static db::Token findCall(InlinerState *state, db::Token token)
+{
+  assert(state);
+
+  if (!token) return nullptr;
+
+  db::Token call = findCall(state, token->left);
+  if (!call) call = findCall(state, token->right);
+  if (call) return call;
+
+  return IS_CALL(token) && canInline(state, token, false) ? token : nullptr;
+}
+
+static bool areCallsQuiet(InlinerState *state, const db::Token token)
+{
+  assert(state);
+
+  if (!token) return true;
+
+  if (IS_IN(token)) return false;
+
+  if (IS_CALL(token))
+    {
+      Callee *callee = (token->left ? searchCallee(state, NAME(token->left)) : nullptr);
+      if (!callee || !callee->isQuiet) return false;
+    }
+
+  return areCallsQuiet(state, token->left) && areCallsQuiet(state, token->right);
+}
+
+static bool canInline(InlinerState *state, const db::Token call, bool isStatement)
+{
+  assert(state);
+  assert(call);
+
+  if (!call->left) return false;
+
+  Callee *callee = searchCallee(state, NAME(call->left));
+  if (!callee || callee->isRecursive) return false;
+
+  if (!isStatement && (!callee->isQuiet || !callee->hasType)) return false;
+
+  if (callee->size > state->budget) return false;
+
+  if (callee->size > SMALL_FUNCTION_SIZE &&
+      (callee->calls != 1 || callee->size > SINGLE_CALL_FUNCTION_SIZE))
+    return false;
+
+  db::Token parameter = callee->function->left->left;
+  db::Token argument  = call->left->left;
+
+  for ( ; parameter && argument; parameter = parameter->right, argument = argument->right)
+    continue;
+
+  return !parameter && !argument;
+}
+
+static db::Token expandCall(InlinerState *state, db::Token call, char **result)
+{
+  assert(state);
+  assert(call);
+  assert(result);
+
+  Callee *callee = searchCallee(state, NAME(call->left));
+  assert(callee);
+
+  db::Token body = db::createNode(callee->function->right);
+  if (!body) return nullptr;
+
+  db::Token declarations = nullptr;
+
+  size_t scopeSize = state->scopeSize;
+  state->calleeScope = scopeSize;
+
+  bool isOk =
+    bindParameters(state, callee, call, &declarations) &&
+    renameBlock(state, body);
+
+  state->scopeSize = scopeSize;
+
+  // Return at the end of procedure is not needed
+  db::Token last = lastCommand(body);
+  if (isOk && !callee->hasType && body->right &&
+      IS_RETURN(last->left) && !last->left->left)
+    {
+      db::Token previous = body;
+      for ( ; previous->right != last; previous = previous->right) continue;
+
+      db::removeNode(last);
+      previous->right = nullptr;
+    }
+
+  char *name = (isOk ? createName(state) : nullptr);
+  isOk = isOk && name && convertReturns(state, &body, name);
+
+  size_t assignments = (isOk ? countAssignments(body, name) : 0);
+
+  last = lastCommand(body);
+  if (isOk && !state->isRejected && (assignments || callee->hasType))
+    {
+      db::Token variable = db::createNode({.name = name}, db::type_t::NAME);
+      isOk = variable;
+
+      if (isOk && assignments == 1 &&
+          IS_ASSIGN(last->left) && NAME(last->left->left) == name)
+        {
+          // Single return at the end initializes result
+          STATEMENT(last->left) = db::STATEMENT_VAR;
+          db::removeNode(variable);
+        }
+      else if (isOk)
+        {
+          db::Token zero        = db::createNode({.number = 0}, db::type_t::NUMBER);
+          db::Token declaration = (zero ? CREATE_STATEMENT(VAR, variable, zero) : nullptr);
+          db::Token command     = (declaration ? createCommand(declaration) : nullptr);
+
+          isOk = command;
+          if (!isOk)
+            {
+              if (declaration) db::removeNode(declaration);
+              else
+                {
+                  db::removeNode(variable);
+                  if (zero) db::removeNode(zero);
+                }
+            }
+          else
+            {
+              command->right = body;
+              body = command;
+            }
+        }
+
+      *result = name;
+    }
+
+  if (!isOk || state->isRejected)
+    {
+      if (body) db::removeNode(body);
+      if (declarations) db::removeNode(declarations);
+
+      if (isOk) state->isRejected = true;
+      return nullptr;
+    }
+
+  if (declarations)
+    {
+      lastCommand(declarations)->right = body;
+      body = declarations;
+    }
+
+  size_t size = db::countNodes(body);
+  state->budget  = (size < state->budget ? state->budget - size : 0);
+  state->added  += size;
+  ++state->inlined;
+
+  return body;
+}
+
+static bool bindParameters(InlinerState *state, const Callee *callee, db::Token call, db::Token *declarations)
+{
+  assert(state);
+  assert(callee);
+  assert(call);
+  assert(declarations);
+
+  db::Token parameter = callee->function->left->left;
+  db::Token argument  = call->left->left;
+
+  for ( ; parameter && argument; parameter = parameter->right, argument = argument->right)
+    {
+      const char *name  = NAME(parameter->left->left);
+      db::Token   value = argument->left;
+
+      bool isSubstituted =
+        !isAssigned(callee->function->right, name) &&
+        (IS_NUM(value) ||
+         (IS_NAME(value) && (callee->isQuiet || isCallerLocal(state, NAME(value)))));
+
+      if (isSubstituted)
+        {
+          if (!pushRenaming(state, name, nullptr, value)) return false;
+          continue;
+        }
+
+      char *newName = createName(state);
+      if (!newName || !pushRenaming(state, name, newName, nullptr)) return false;
+
+      // Arguments are evaluated from the last one, so declarations are in reverse order
+      db::Token copy        = db::createNode(value);
+      db::Token variable    = (copy     ? db::createNode({.name = newName}, db::type_t::NAME) : nullptr);
+      db::Token declaration = (variable ? CREATE_STATEMENT(VAR, variable, copy) : nullptr);
+      db::Token command     = (declaration ? createCommand(declaration) : nullptr);
+
+      if (!command)
+        {
+          if (declaration) db::removeNode(declaration);
+          else
+            {
+              if (variable) db::removeNode(variable);
+              if (copy)     db::removeNode(copy);
+            }
+
+          return false;
+        }
+
+      command->right = *declarations;
+      *declarations = command;
+    }
+
+  return true;
+}
+
+static bool isAssigned(const db::Token token, const char *name)
+{
+  assert(name);
+
+  if (!token) return false;
+
+  if (IS_ASSIGN(token) && db::compareStrings(NAME(token->left), name)) return true;
+
+  if (IS_IN(token))
+    for (db::Token parameter = token->left; parameter; parameter = parameter->right)
+      if (parameter->left && IS_NAME(parameter->left) &&
+          db::compareStrings(NAME(parameter->left), name))
+        return true;
+
+  return isAssigned(token->left, name) || isAssigned(token->right, name);
+}
+
+static bool isCallerLocal(const InlinerState *state, const char *name)
+{
+  assert(state);
+  assert(name);
+
+  for (size_t i = 0; i < state->calleeScope; ++i)
+    if (db::compareStrings(state->scope[i].name, name)) return true;
+
+  return false;
+}
+
+static bool renameBlock(InlinerState *state, db::Token block)
+{
+  assert(state);
+
+  size_t scopeSize = state->scopeSize;
+
+  for (db::Token command = block; command; command = command->right)
+    if (!renameStatement(state, command->left)) return false;
+
+  state->scopeSize = scopeSize;
+
+  return true;
+}
+
+static bool renameStatement(InlinerState *state, db::Token token)
+{
+  assert(state);
+
+  if (!token) return true;
+
+  if (IS_VAR(token) || IS_VAL(token))
+    {
+      if (!renameExpression(state, token->right)) return false;
+
+      char *newName = createName(state);
+      if (!newName || !pushRenaming(state, NAME(token->left), newName, nullptr)) return false;
+
+      NAME(token->left) = newName;
+      return true;
+    }
+
+  if (IS_ASSIGN(token))
+    {
+      renameTarget(state, token->left);
+      return renameExpression(state, token->right);
+    }
+
+  if (IS_IN(token))
+    {
+      for (db::Token parameter = token->left; parameter; parameter = parameter->right)
+        if (parameter->left && IS_NAME(parameter->left))
+          renameTarget(state, parameter->left);
+
+      return true;
+    }
+
+  if (IS_IF(token) && IS_ELSE(token->right))
+    return renameExpression(state, token->left) &&
+           renameBlock(state, token->right->left) &&
+           renameBlock(state, token->right->right);
+
+  if (IS_IF(token) || IS_WHILE(token))
+    return renameExpression(state, token->left) &&
+           renameBlock(state, token->right);
+
+  if (IS_COMP(token)) return renameBlock(state, token);
+
+  return renameExpression(state, token);
+}
+
+static bool renameExpression(InlinerState *state, db::Token token)
+{
+  assert(state);
+
+  if (!token) return true;
+
+  if (IS_CALL(token))
+    return !token->left || renameExpression(state, token->left->left);
+
+  if (!IS_NAME(token))
+    return renameExpression(state, token->left) &&
+           renameExpression(state, token->right);
+
+  const Renaming *renaming = searchRenaming(state, NAME(token), state->calleeScope);
+
+  if (!renaming)
+    {
+      // Global of callee is hidden by local of caller
+      if (searchRenaming(state, NAME(token), 0)) state->isRejected = true;
+      return true;
+    }
+
+  if (renaming->newName)
+    {
+      NAME(token) = renaming->newName;
+      return true;
+    }
+
+  db::Token value = db::createNode(renaming->value);
+  if (!value) return false;
+
+  token->type  = value->type;
+  token->value = value->value;
+  db::setChildren(token, value->left, value->right);
+
+  value->left = value->right = nullptr;
+  db::removeNode(value);
+
+  return true;
+}
+
+static void renameTarget(InlinerState *state, db::Token token)
+{
+  assert(state);
+  assert(token);
+
+  const Renaming *renaming = searchRenaming(state, NAME(token), state->calleeScope);
+
+  if (renaming && renaming->newName)
+    NAME(token) = renaming->newName;
+  else if (renaming || searchRenaming(state, NAME(token), 0))
+    state->isRejected = true;
+}
+
+static const Renaming *searchRenaming(const InlinerState *state, const char *name, size_t start)
+{
+  assert(state);
+  assert(name);
+
+  for (size_t i = state->scopeSize; i > start; --i)
+    if (db::compareStrings(state->scope[i - 1].name, name))
+      return state->scope + i - 1;
+
+  return nullptr;
+}
+
+static bool pushRenaming(InlinerState *state, const char *name, char *newName, db::Token value)
+{
+  assert(state);
+  assert(name);
+
+  if (state->scopeSize == state->scopeCapacity)
+    {
+      state->scopeCapacity = GROWTH_FACTOR*state->scopeCapacity + 1;
+      Renaming *temp =
+        (Renaming *)recalloc(state->scope, state->scopeCapacity, sizeof(Renaming));
+      if (!temp) return false;
+
+      state->scope = temp;
+    }
+
+  state->scope[state->scopeSize++] = {
+    .name    = name,
+    .newName = newName,
+    .value   = value,
+  };
+
+  return true;
+}
+
+static char *createName(InlinerState *state)
+{
+  assert(state);
+
+  char name[db::MAX_NAME_SIZE] = "";
+  sprintf(name, "$inline_%zu", state->countOfNames++);
+
+  return db::addString(&state->translator->stringPool, name);
+}
+
+static bool convertReturns(InlinerState *state, db::Token *block, char *result)
+{
+  assert(state);
+  assert(block);
+  assert(result);
+
+  for (db::Token command = *block; command; command = command->right)
+    {
+      db::Token statement = command->left;
+
+      if (IS_RETURN(statement))
+        {
+          if (command->right)
+            {
+              db::removeNode(command->right);
+              command->right = nullptr;
+            }
+
+          db::Token value = statement->left;
+          if (!value) value = db::createNode({.number = 0}, db::type_t::NUMBER);
+
+          db::Token variable = (value ? db::createNode({.name = result}, db::type_t::NAME) : nullptr);
+          if (!variable)
+            {
+              if (value && value != statement->left) db::removeNode(value);
+              return false;
+            }
+
+          STATEMENT(statement) = db::STATEMENT_ASSIGNMENT;
+          db::setChildren(statement, variable, value);
+
+          return true;
+        }
+
+      if (!hasReturn(statement)) continue;
+
+      if (!IS_IF(statement))
+        {
+          state->isRejected = true;
+          return true;
+        }
+
+      bool hasElse = IS_ELSE(statement->right);
+
+      db::Token *thenBlock = (hasElse ? &statement->right->left  : &statement->right);
+      db::Token *elseBlock = (hasElse ? &statement->right->right : nullptr);
+
+      bool isThenReturning = alwaysReturns(*thenBlock);
+      bool isElseReturning = hasElse && alwaysReturns(*elseBlock);
+
+      db::Token rest = command->right;
+      command->right = nullptr;
+
+      if (rest && isThenReturning && isElseReturning)
+        db::removeNode(rest);
+      else if (rest && isThenReturning && hasElse)
+        lastCommand(*elseBlock)->right = rest;
+      else if (rest && isThenReturning)
+        {
+          db::Token elseNode = CREATE_STATEMENT(ELSE, *thenBlock, rest);
+          if (!elseNode) { command->right = rest; return false; }
+
+          db::setChildren(statement, statement->left, elseNode);
+
+          thenBlock = &elseNode->left;
+          elseBlock = &elseNode->right;
+        }
+      else if (rest && isElseReturning)
+        lastCommand(*thenBlock)->right = rest;
+      else if (rest)
+        {
+          command->right    = rest;
+          state->isRejected = true;
+          return true;
+        }
+
+      return convertReturns(state, thenBlock, result) &&
+             (!elseBlock || convertReturns(state, elseBlock, result));
+    }
+
+  return true;
+}
+
+static bool alwaysReturns(const db::Token block)
+{
+  db::Token last = block;
+  for ( ; last && last->right; last = last->right) continue;
+
+  if (!last) return false;
+
+  db::Token statement = last->left;
+
+  if (IS_RETURN(statement)) return true;
+
+  return IS_IF(statement) && IS_ELSE(statement->right) &&
+         alwaysReturns(statement->right->left) &&
+         alwaysReturns(statement->right->right);
+}
+
+static bool hasReturn(const db::Token token)
+{
+  if (!token) return false;
+
+  if (IS_RETURN(token)) return true;
+
+  return hasReturn(token->left) || hasReturn(token->right);
+}
+
+static size_t countAssignments(const db::Token token, const char *name)
+{
+  assert(name);
+
+  if (!token) return 0;
+
+  size_t count = (IS_ASSIGN(token) && NAME(token->left) == name);
+
+  return count + countAssignments(token->left, name) + countAssignments(token->right, name);
+}
+
+static db::Token createCommand(db::Token statement)
+{
+  assert(statement);
+
+  return CREATE_STATEMENT(COMPOUND, statement, nullptr);
+}
+
+static db::Token lastCommand(db::Token block)
+{
+  assert(block);
+
+  for ( ; block->right; block = block->right) continue;
+
+  return block;
+}
@@ -0,0 +1,267 @@
+#include "Translator.h"
+
+#include <stdio.h>
+#include <limits.h>
+#include <malloc.h>
+#include "DSL.h"
+#include "SystemLike.h"
+#include "StringPool.h"
+#include "Assert.h"
+#include "Error.h"
+
+#pragma GCC diagnostic ignored "-Wswitch-enum"
+
+const int GROWTH_FACTOR = 2;
+
+struct Declaration {
+  db::Token token;
+  bool isIntegral;
+};
+
+/// Declarations are assumed integral and are marked by assignments until nothing changes
+struct InferenceState {
+  Declaration *declarations;
+  size_t size;
+  size_t capacity;
+
+  size_t *visible; ///< Indexes of declarations of current scopes
+  size_t visibleSize;
+  size_t visibleCapacity;
+
+  bool isChanged;
+  bool isFailed;
+};
+
+static void inferBlock(InferenceState *state, const db::Token token);
+
+/// Declarations of body are visible only in it
+static void inferScope(InferenceState *state, const db::Token token);
+
+static void declare(InferenceState *state, const db::Token declaration);
+
+static Declaration *search(InferenceState *state, const char *name);
+
+/// Assignment of not integral value to variable
+static void markAssignment(InferenceState *state, const char *name, const db::Token value);
+
+static bool isIntegral(InferenceState *state, const db::Token token);
+
+void db::inferIntegers(const db::Function *function, db::IntegerTypes *types, int *error)
+{
+  if (!function || !function->token || !types) ERROR();
+
+  InferenceState state{};
+
+  do
+    {
+      state.isChanged   = false;
+      state.visibleSize = 0;
+
+      inferBlock(&state, function->token->right);
+    } while (state.isChanged && !state.isFailed);
+
+  for (size_t i = 0; i < state.size && !state.isFailed; ++i)
+    {
+      if (!state.declarations[i].isIntegral) continue;
+
+      if (types->size == types->capacity)
+        {
+          types->capacity = GROWTH_FACTOR*types->capacity + 1;
+          db::Token *temp =
+            (db::Token *)recalloc(types->declarations, types->capacity, sizeof(db::Token));
+          if (!temp)
+            {
+              state.isFailed = true;
+              break;
+            }
+
+          types->declarations = temp;
+        }
+
+      types->declarations[types->size++] = state.declarations[i].token;
+    }
+
+  free(state.declarations);
+  free(state.visible);
+
+  if (state.isFailed) ERROR();
+}
+
+bool db::isIntegerDeclaration(const db::IntegerTypes *types, const db::Token declaration)
+{
+  if (!types || !declaration) return false;
+
+  for (size_t i = 0; i < types->size; ++i)
+    if (types->declarations[i] == declaration) return true;
+
+  return false;
+}
+
+void db::destroyIntegerTypes(db::IntegerTypes *types, int *error)
+{
+  if (!types) ERROR();
+
+  free(types->declarations);
+
+  types->declarations = nullptr;
+  types->size = types->capacity = 0;
+}
+
+static void inferBlock(InferenceState *state, const db::Token token)
+{
+  assert(state);
+
+  if (!token || !IS_STATEMENT(token)) return;
+
+  switch (STATEMENT(token))
+    {
+    case db::STATEMENT_COMPOUND:
+      inferBlock(state, token->left );
+      inferBlock(state, token->right);
+      break;
+    case db::STATEMENT_VAR:
+    case db::STATEMENT_VAL:
+      declare(state, token);
+      if (IS_NAME(token->left)) markAssignment(state, NAME(token->left), token->right);
+      break;
+    case db::STATEMENT_ASSIGNMENT:
+      if (IS_NAME(token->left)) markAssignment(state, NAME(token->left), token->right);
+      break;
+    case db::STATEMENT_IN:
+      for (db::Token temp = token->left; temp; temp = temp->right)
+        if (IS_NAME(temp->left)) markAssignment(state, NAME(temp->left), nullptr);
+      break;
+    case db::STATEMENT_IF:
+      if (IS_ELSE(token->right))
+        {
+          inferScope(state, token->right->left );
+          inferScope(state, token->right->right);
+        }
+      else
+        inferScope(state, token->right);
+      break;
+    case db::STATEMENT_WHILE:
+      inferScope(state, token->right);
+      break;
+    default: break;
+    }
+}
+
+static void inferScope(InferenceState *state, const db::Token token)
+{
+  assert(state);
+
+  size_t visibleSize = state->visibleSize;
+
+  inferBlock(state, token);
+
+  state->visibleSize = visibleSize;
+}
+
+static void declare(InferenceState *state, const db::Token declaration)
+{
+  assert(state);
+  assert(declaration);
+
+  size_t index = 0;
+  while (index < state->size && state->declarations[index].token != declaration) ++index;
+
+  if (index == state->size)
+    {
+      if (state->size == state->capacity)
+        {
+          state->capacity = GROWTH_FACTOR*state->capacity + 1;
+          Declaration *temp =
+            (Declaration *)recalloc(state->declarations, state->capacity, sizeof(Declaration));
+          if (!temp)
+            {
+              state->isFailed = true;
+              return;
+            }
+
+          state->declarations = temp;
+        }
+
+      state->declarations[state->size++] = { .token = declaration, .isIntegral = true };
+    }
+
+  if (state->visibleSize == state->visibleCapacity)
+    {
+      state->visibleCapacity = GROWTH_FACTOR*state->visibleCapacity + 1;
+      size_t *temp = (size_t *)recalloc(state->visible, state->visibleCapacity, sizeof(size_t));
+      if (!temp)
+        {
+          state->isFailed = true;
+          return;
+        }
+
+      state->visible = temp;
+    }
+
+  state->visible[state->visibleSize++] = index;
+}
+
+static Declaration *search(InferenceState *state, const char *name)
+{
+  assert(state);
+  assert(name);
+
+  for (size_t i = state->visibleSize; i > 0; --i)
+    {
+      Declaration *declaration = state->declarations + state->visible[i - 1];
+
+      if (IS_NAME(declaration->token->left) &&
+          db::compareStrings(NAME(declaration->token->left), name))
+        return declaration;
+    }
+
+  return nullptr;
+}
+
+static void markAssignment(InferenceState *state, const char *name, const db::Token value)
+{
+  assert(state);
+  assert(name);
+
+  Declaration *declaration = search(state, name);
+  if (!declaration || !declaration->isIntegral) return;
+
+  if (value && isIntegral(state, value)) return;
+
+  declaration->isIntegral = false;
+  state->isChanged = true;
+}
+
+static bool isIntegral(InferenceState *state, const db::Token token)
+{
+  assert(state);
+
+  if (!token) return false;
+
+  if (IS_NUM(token))
+    return INT_MIN < NUMBER(token) && NUMBER(token) < INT_MAX &&
+           db::compareNumber(NUMBER(token), (int)NUMBER(token));
+
+  // Parameters and globals aren`t declared in function, so they aren`t integral
+  if (IS_NAME(token))
+    {
+      Declaration *declaration = search(state, NAME(token));
+
+      return declaration && declaration->isIntegral;
+    }
+
+  if (!IS_STATEMENT(token)) return false;
+
+  switch (STATEMENT(token))
+    {
+    case db::STATEMENT_ADD:
+    case db::STATEMENT_SUB:
+      return isIntegral(state, token->left) && (!token->right || isIntegral(state, token->right));
+    case db::STATEMENT_MUL:
+      return isIntegral(state, token->left) && isIntegral(state, token->right);
+    case db::STATEMENT_INT:
+      return token->left != nullptr;
+    default:
+      return false;
+    }
+}
@@ -0,0 +1,472 @@
+#include "Translator.h"
+
+#include <stdio.h>
+#include <malloc.h>
+#include "DSL.h"
+#include "Assert.h"
+#include "SystemLike.h"
+#include "Logging.h"
+#include "Error.h"
+
+#pragma GCC diagnostic ignored "-Wswitch-enum"
+
+const int GROWTH_FACTOR = 2;
+
+/// Expression of loop which is computed once before it
+struct Invariant {
+  db::Token expression; ///< First occurrence, it is moved to declaration
+  char     *name;
+};
+
+struct LicmState {
+  db::Translator *translator;
+
+  const char **globals;
+  size_t       globalsSize;
+
+  const char **variants; ///< Names assigned or declared in current loop
+  size_t       variantsSize;
+  size_t       variantsCapacity;
+  bool         hasCall;  ///< Globals may be changed in current loop
+
+  /// Current code is calculated on every run of loop, before loop may be left,
+  /// so partial operations of it may be calculated before loop
+  bool isUnconditional;
+
+  Invariant *invariants;
+  size_t     invariantsSize;
+  size_t     invariantsCapacity;
+
+  size_t loops;
+  size_t hoisted;
+  size_t countOfNames;
+};
+
+static bool collectGlobals(LicmState *state);
+
+/// Hoist invariants of loops of block, outer loops are processed first, so invariants leave all loops
+static bool hoistInBlock(LicmState *state, db::Token block);
+
+/// @param [in] command Command with loop, declarations of invariants are inserted before loop
+/// @param [out] loop Command with loop after insertion
+static bool hoistLoop(LicmState *state, db::Token command, db::Token *loop);
+
+static bool collectVariants(LicmState *state, const db::Token token);
+
+static bool pushVariant(LicmState *state, const char *name);
+
+static bool replaceInBlock(LicmState *state, db::Token block);
+
+static bool replaceInStatement(LicmState *state, db::Token statement);
+
+/// Replace maximal invariant subexpressions by names of their values
+static bool replaceInvariants(LicmState *state, db::Token *slot);
+
+static bool isInvariant(const LicmState *state, const db::Token token);
+
+/// Condition is number which isn`t zero, so body is run at least once
+static bool isAlwaysEntered(const db::Token condition);
+
+static bool hasReturn(const db::Token token);
+
+static bool isVariant(const LicmState *state, const char *name);
+
+static char *createName(LicmState *state);
+
+/// Insert declarations of invariants before command
+static bool declareInvariants(LicmState *state, db::Token command, db::Token *loop);
+
+void db::hoistLoopInvariants(db::Translator *translator, int *error)
+{
+  if (!translator || !translator->grammar.root) ERROR();
+
+  LicmState state{};
+  state.translator = translator;
+
+  bool isOk = collectGlobals(&state);
+
+  for (db::Token token = translator->grammar.root; token && isOk; token = token->right)
+    if (IS_FUN(token->left))
+      isOk = hoistInBlock(&state, token->left->right);
+
+  free(state.globals);
+  free(state.variants);
+  free(state.invariants);
+
+  if (!isOk) ERROR();
+
+  FILE *log = getLogFile();
+  if (!log) return;
+
+  fprintf(log, "<pre>Loop invariants: %zu expressions hoisted from %zu loops</pre>\n",
+          state.hoisted, state.loops);
+}
+
+static bool collectGlobals(LicmState *state)
+{
+  assert(state);
+
+  db::Token root = state->translator->grammar.root;
+
+  size_t size = 0;
+  for (db::Token token = root; token; token = token->right)
+    if (IS_VAR(token->left) || IS_VAL(token->left)) ++size;
+
+  state->globals = (const char **)calloc(size, sizeof(const char *));
+  if (!state->globals) return !size;
+
+  for (db::Token token = root; token; token = token->right)
+    if (IS_VAR(token->left) || IS_VAL(token->left))
+      state->globals[state->globalsSize++] = NAME(token->left->left);
+
+  return true;
+}
+
+static bool hoistInBlock(LicmState *state, db::Token block)
+{
+  assert(state);
+
+  for (db::Token command = block; command; command = command->right)
+    {
+      db::Token statement = command->left;
+      bool isOk = true;
+
+      if (IS_WHILE(statement))
+        isOk = hoistLoop(state, command, &command) &&
+               hoistInBlock(state, command->left->right);
+      else if (IS_IF(statement) && IS_ELSE(statement->right))
+        isOk = hoistInBlock(state, statement->right->left ) &&
+               hoistInBlock(state, statement->right->right);
+      else if (IS_IF(statement))
+        isOk = hoistInBlock(state, statement->right);
+      else if (IS_COMP(statement))
+        isOk = hoistInBlock(state, statement);
+
+      if (!isOk) return false;
+    }
+
+  return true;
+}
+
+static bool hoistLoop(LicmState *state, db::Token command, db::Token *loop)
+{
+  assert(state);
+  assert(command);
+  assert(loop);
+
+  db::Token statement = command->left;
+
+  state->variantsSize   = 0;
+  state->invariantsSize = 0;
+  state->hasCall        = false;
+
+  if (!collectVariants(state, statement)) return false;
+
+  // Condition is calculated even if loop isn`t run
+  state->isUnconditional = true;
+  if (!replaceInvariants(state, &statement->left)) return false;
+
+  state->isUnconditional = isAlwaysEntered(statement->left);
+  if (!replaceInBlock(state, statement->right)) return false;
+
+  if (!state->invariantsSize) return true;
+
+  ++state->loops;
+  state->hoisted += state->invariantsSize;
+
+  return declareInvariants(state, command, loop);
+}
+
+static bool collectVariants(LicmState *state, const db::Token token)
+{
+  assert(state);
+
+  if (!token) return true;
+
+  if (IS_CALL(token)) state->hasCall = true;
+
+  if ((IS_ASSIGN(token) || IS_VAR(token) || IS_VAL(token)) &&
+      !pushVariant(state, NAME(token->left)))
+    return false;
+
+  if (IS_IN(token))
+    for (db::Token parameter = token->left; parameter; parameter = parameter->right)
+      if (parameter->left && IS_NAME(parameter->left) &&
+          !pushVariant(state, NAME(parameter->left)))
+        return false;
+
+  return collectVariants(state, token->left) &&
+         collectVariants(state, token->right);
+}
+
+static bool pushVariant(LicmState *state, const char *name)
+{
+  assert(state);
+  assert(name);
+
+  if (state->variantsSize == state->variantsCapacity)
+    {
+      state->variantsCapacity = GROWTH_FACTOR*state->variantsCapacity + 1;
+      const char **temp =
+        (const char **)recalloc(state->variants, state->variantsCapacity, sizeof(const char *));
+      if (!temp) return false;
+
+      state->variants = temp;
+    }
+
+  state->variants[state->variantsSize++] = name;
+
+  return true;
+}
+
+static bool replaceInBlock(LicmState *state, db::Token block)
+{
+  assert(state);
+
+  for (db::Token command = block; command; command = command->right)
+    {
+      if (!replaceInStatement(state, command->left)) return false;
+
+      // Loop may be left before the next commands
+      if (hasReturn(command->left)) state->isUnconditional = false;
+    }
+
+  return true;
+}
+
+static bool replaceInStatement(LicmState *state, db::Token statement)
+{
+  assert(state);
+
+  if (!statement) return true;
+
+  if (IS_ASSIGN(statement) || IS_VAR(statement) || IS_VAL(statement))
+    return replaceInvariants(state, &statement->right);
+
+  bool isUnconditional = state->isUnconditional;
+
+  if (IS_IF(statement))
+    {
+      if (!replaceInvariants(state, &statement->left)) return false;
+
+      state->isUnconditional = false;
+
+      bool isOk = (IS_ELSE(statement->right) ?
+                   replaceInBlock(state, statement->right->left) &&
+                   replaceInBlock(state, statement->right->right) :
+                   replaceInBlock(state, statement->right));
+
+      state->isUnconditional = isUnconditional;
+
+      return isOk;
+    }
+
+  if (IS_WHILE(statement))
+    {
+      if (!replaceInvariants(state, &statement->left)) return false;
+
+      state->isUnconditional = false;
+
+      bool isOk = replaceInBlock(state, statement->right);
+
+      state->isUnconditional = isUnconditional;
+
+      return isOk;
+    }
+
+  if (IS_IN(statement)) return true;
+
+  if (IS_COMP(statement)) return replaceInBlock(state, statement);
+
+  return replaceInvariants(state, &statement->left) &&
+         replaceInvariants(state, &statement->right);
+}
+
+static bool replaceInvariants(LicmState *state, db::Token *slot)
+{
+  assert(state);
+  assert(slot);
+
+  db::Token token = *slot;
+  if (!token) return true;
+
+  if (!IS_STATEMENT(token) || !isInvariant(state, token))
+    return replaceInvariants(state, &token->left) &&
+           replaceInvariants(state, &token->right);
+
+  size_t index = 0;
+  while (index < state->invariantsSize &&
+         !db::isSameNode(state->invariants[index].expression, token))
+    ++index;
+
+  if (index == state->invariantsSize)
+    {
+      if (state->invariantsSize == state->invariantsCapacity)
+        {
+          state->invariantsCapacity = GROWTH_FACTOR*state->invariantsCapacity + 1;
+          Invariant *temp =
+            (Invariant *)recalloc(state->invariants, state->invariantsCapacity, sizeof(Invariant));
+          if (!temp) return false;
+
+          state->invariants = temp;
+        }
+
+      char *name = createName(state);
+      if (!name) return false;
+
+      state->invariants[state->invariantsSize++] = { .expression = nullptr, .name = name };
+    }
+
+  Invariant *invariant = state->invariants + index;
+
+  db::Token value = db::createNode({.name = invariant->name}, db::type_t::NAME);
+  if (!value) return false;
+
+  value->parent = token->parent;
+  *slot = value;
+
+  token->parent = nullptr;
+  if (invariant->expression) db::removeNode(token);
+  else                       invariant->expression = token;
+
+  return true;
+}
+
+static bool isInvariant(const LicmState *state, const db::Token token)
+{
+  assert(state);
+
+  if (!token) return true;
+
+  if (IS_NUM(token)) return true;
+
+  if (IS_NAME(token)) return !isVariant(state, NAME(token));
+
+  if (!IS_STATEMENT(token)) return false;
+
+  switch (STATEMENT(token))
+    {
+    case db::STATEMENT_DIV:
+      // Division by number, which isn`t zero, can not fail
+      if (token->right && IS_NUM(token->right) && !db::compareNumber(NUMBER(token->right), 0))
+        break;
+      [[fallthrough]];
+    case db::STATEMENT_POW:
+    case db::STATEMENT_TAN:  case db::STATEMENT_SQRT:
+      // Partial operation is not calculated before loop, if loop may skip it
+      if (!state->isUnconditional) return false;
+      break;
+    case db::STATEMENT_ADD:  case db::STATEMENT_SUB:
+    case db::STATEMENT_MUL:
+    case db::STATEMENT_SIN:  case db::STATEMENT_COS:
+    case db::STATEMENT_INT:
+    case db::STATEMENT_LESS: case db::STATEMENT_GREATER:
+    case db::STATEMENT_EQUAL: case db::STATEMENT_NOT_EQUAL:
+    case db::STATEMENT_AND:  case db::STATEMENT_OR:
+      break;
+    default: return false;
+    }
+
+  return isInvariant(state, token->left) &&
+         isInvariant(state, token->right);
+}
+
+static bool isAlwaysEntered(const db::Token condition)
+{
+  return condition && IS_NUM(condition) && !db::compareNumber(NUMBER(condition), 0);
+}
+
+static bool hasReturn(const db::Token token)
+{
+  if (!token) return false;
+
+  if (IS_RETURN(token)) return true;
+
+  return hasReturn(token->left) || hasReturn(token->right);
+}
+
+static bool isVariant(const LicmState *state, const char *name)
+{
+  assert(state);
+  assert(name);
+
+  for (size_t i = 0; i < state->variantsSize; ++i)
+    if (db::compareStrings(state->variants[i], name)) return true;
+
+  // Called functions may change globals
+  if (state->hasCall)
+    for (size_t i = 0; i < state->globalsSize; ++i)
+      if (db::compareStrings(state->globals[i], name)) return true;
+
+  return false;
+}
+
+static char *createName(LicmState *state)
+{
+  assert(state);
+
+  char name[db::MAX_NAME_SIZE] = "";
+  sprintf(name, "$licm_%zu", state->countOfNames++);
+
+  return db::addString(&state->translator->stringPool, name);
+}
+
+static bool declareInvariants(LicmState *state, db::Token command, db::Token *loop)
+{
+  assert(state);
+  assert(command);
+  assert(loop);
+
+  db::Token first = nullptr;
+  db::Token last  = nullptr;
+
+  for (size_t i = 0; i < state->invariantsSize; ++i)
+    {
+      Invariant *invariant = state->invariants + i;
+
+      db::Token variable    = db::createNode({.name = invariant->name}, db::type_t::NAME);
+      db::Token declaration =
+        (variable ? CREATE_STATEMENT(VAR, variable, invariant->expression) : nullptr);
+      db::Token next        = (declaration ? CREATE_STATEMENT(COMPOUND, declaration, nullptr) : nullptr);
+
+      if (!next)
+        {
+          if (declaration) db::removeNode(declaration);
+          else
+            {
+              if (variable) db::removeNode(variable);
+              db::removeNode(invariant->expression);
+            }
+
+          for (size_t j = i + 1; j < state->invariantsSize; ++j)
+            db::removeNode(state->invariants[j].expression);
+
+          if (first) db::removeNode(first);
+
+          return false;
+        }
+
+      if (last) db::setChildren(last, last->left, next);
+      else      first = next;
+
+      last = next;
+    }
+
+  db::Token loopCommand = CREATE_STATEMENT(COMPOUND, command->left, command->right);
+  if (!loopCommand)
+    {
+      db::removeNode(first);
+      return false;
+    }
+
+  // Command becomes the first declaration
+  db::setChildren(last, last->left, loopCommand);
+  db::setChildren(command, first->left, first->right);
+
+  first->left = first->right = nullptr;
+  db::removeNode(first);
+
+  *loop = loopCommand;
+
+  return true;
+}
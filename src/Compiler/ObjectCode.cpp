@@ -0,0 +1,314 @@
+#include "StackIr.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <malloc.h>
+#include "SystemLike.h"
+#include "ErrorHandler.h"
+#include "Assert.h"
+#include "Error.h"
+
+#pragma GCC diagnostic ignored "-Wswitch-enum"
+
+const int GROWTH_FACTOR = 2;
+
+const int OPERAND_TYPE_SHIFT = 8;
+const int     REGISTER_SHIFT = 16;
+
+/// Address of instruction, which isn`t written, like label or comment
+const size_t NO_ADDRESS = (size_t)-1;
+
+struct ObjectCode {
+  int   *words;
+  size_t size;
+  size_t capacity;
+
+  /// Definitions of labels
+  const db::IrOperand **labels;
+  size_t *labelAddresses;
+  size_t labelsSize;
+  size_t labelsCapacity;
+
+  /// Positions of words of labels, which are defined later
+  size_t *fixups;
+  const db::IrOperand **fixupLabels;
+  size_t fixupsSize;
+  size_t fixupsCapacity;
+
+  bool isFailed;
+};
+
+static void destroyObject(ObjectCode *object);
+
+static void pushWord(ObjectCode *object, int word);
+
+static void addLabel(ObjectCode *object, const db::IrOperand *label);
+
+static void addFixup(ObjectCode *object, const db::IrOperand *label);
+
+/// @return Address of label or NO_ADDRESS if label isn`t defined yet
+static size_t searchLabel(const ObjectCode *object, const db::IrOperand *label);
+
+static bool resolveFixups(ObjectCode *object);
+
+/// ObjectHeader with count of words of code
+/// @note Header is in heap, char array of it disables stack protector of caller
+static bool writeHeader(size_t size, FILE *target);
+
+/// @param [in] addresses Address of every instruction of code
+static void printListing(
+                         const db::IrCode *code,
+                         const ObjectCode *object,
+                         const size_t *addresses,
+                         FILE *listing
+                        );
+
+void db::assembleIr(const db::IrCode *code, FILE *target, FILE *listing, int *error)
+{
+  if (!code || !target) ERROR();
+
+  ObjectCode object{};
+
+  size_t *addresses = (size_t *)calloc(code->size + 1, sizeof(size_t));
+  if (!addresses) ERROR();
+
+  for (size_t i = 0; i < code->size && !object.isFailed; ++i)
+    {
+      const db::IrInstruction *instruction = code->instructions + i;
+
+      addresses[i] = NO_ADDRESS;
+
+      if (instruction->opcode == db::Opcode::COMMENT) continue;
+
+      if (instruction->opcode == db::Opcode::LABEL)
+        {
+          addLabel(&object, &instruction->operand);
+          continue;
+        }
+
+      addresses[i] = object.size;
+
+      const db::IrOperand *operand = &instruction->operand;
+      pushWord(&object,
+               (int)instruction->opcode |
+               (int)operand->type << OPERAND_TYPE_SHIFT |
+               (int)operand->base << REGISTER_SHIFT);
+
+      switch (operand->type)
+        {
+        case db::OperandType::None:
+        case db::OperandType::Register:
+          break;
+        case db::OperandType::Immediate:
+        case db::OperandType::Memory:
+          pushWord(&object, operand->value);
+          break;
+        case db::OperandType::Label:
+          {
+            size_t address = searchLabel(&object, operand);
+            if (address == NO_ADDRESS) addFixup(&object, operand);
+
+            pushWord(&object, (int)address);
+            break;
+          }
+        default:
+          object.isFailed = true;
+          break;
+        }
+    }
+
+  if (!object.isFailed && resolveFixups(&object) && writeHeader(object.size, target))
+    {
+      fwrite(object.words, sizeof(int), object.size, target);
+
+      if (listing) printListing(code, &object, addresses, listing);
+    }
+  else
+    object.isFailed = true;
+
+  bool isFailed = object.isFailed || ferror(target);
+
+  free(addresses);
+  destroyObject(&object);
+
+  if (isFailed) ERROR();
+}
+
+static void destroyObject(ObjectCode *object)
+{
+  assert(object);
+
+  free(object->words);
+  free(object->labels);
+  free(object->labelAddresses);
+  free(object->fixups);
+  free(object->fixupLabels);
+
+  *object = {};
+}
+
+static void pushWord(ObjectCode *object, int word)
+{
+  assert(object);
+
+  if (object->size == object->capacity)
+    {
+      object->capacity = GROWTH_FACTOR*object->capacity + 1;
+      int *temp = (int *)recalloc(object->words, object->capacity, sizeof(int));
+      if (!temp)
+        {
+          object->isFailed = true;
+          return;
+        }
+
+      object->words = temp;
+    }
+
+  object->words[object->size++] = word;
+}
+
+static void addLabel(ObjectCode *object, const db::IrOperand *label)
+{
+  assert(object);
+  assert(label);
+
+  if (searchLabel(object, label) != NO_ADDRESS)
+    {
+      handleError("Redefinition of label %s_%s", label->prefix, label->name);
+      object->isFailed = true;
+      return;
+    }
+
+  if (object->labelsSize == object->labelsCapacity)
+    {
+      object->labelsCapacity = GROWTH_FACTOR*object->labelsCapacity + 1;
+
+      const db::IrOperand **labels =
+        (const db::IrOperand **)recalloc(object->labels, object->labelsCapacity,
+                                         sizeof(const db::IrOperand *));
+      if (labels) object->labels = labels;
+
+      size_t *addresses =
+        (size_t *)recalloc(object->labelAddresses, object->labelsCapacity, sizeof(size_t));
+      if (addresses) object->labelAddresses = addresses;
+
+      if (!labels || !addresses)
+        {
+          object->isFailed = true;
+          return;
+        }
+    }
+
+  object->labels        [object->labelsSize  ] = label;
+  object->labelAddresses[object->labelsSize++] = object->size;
+}
+
+static void addFixup(ObjectCode *object, const db::IrOperand *label)
+{
+  assert(object);
+  assert(label);
+
+  if (object->fixupsSize == object->fixupsCapacity)
+    {
+      object->fixupsCapacity = GROWTH_FACTOR*object->fixupsCapacity + 1;
+
+      size_t *fixups =
+        (size_t *)recalloc(object->fixups, object->fixupsCapacity, sizeof(size_t));
+      if (fixups) object->fixups = fixups;
+
+      const db::IrOperand **labels =
+        (const db::IrOperand **)recalloc(object->fixupLabels, object->fixupsCapacity,
+                                         sizeof(const db::IrOperand *));
+      if (labels) object->fixupLabels = labels;
+
+      if (!fixups || !labels)
+        {
+          object->isFailed = true;
+          return;
+        }
+    }
+
+  // Word of label is the next one after word of opcode
+  object->fixups     [object->fixupsSize  ] = object->size;
+  object->fixupLabels[object->fixupsSize++] = label;
+}
+
+static size_t searchLabel(const ObjectCode *object, const db::IrOperand *label)
+{
+  assert(object);
+  assert(label);
+
+  for (size_t i = 0; i < object->labelsSize; ++i)
+    if (db::isSameOperand(object->labels[i], label))
+      return object->labelAddresses[i];
+
+  return NO_ADDRESS;
+}
+
+static bool resolveFixups(ObjectCode *object)
+{
+  assert(object);
+
+  for (size_t i = 0; i < object->fixupsSize; ++i)
+    {
+      size_t address = searchLabel(object, object->fixupLabels[i]);
+      if (address == NO_ADDRESS)
+        {
+          handleError("Undefined label %s_%s",
+                      object->fixupLabels[i]->prefix, object->fixupLabels[i]->name);
+          return false;
+        }
+
+      object->words[object->fixups[i]] = (int)address;
+    }
+
+  return true;
+}
+
+static bool writeHeader(size_t size, FILE *target)
+{
+  assert(target);
+
+  db::ObjectHeader *header = (db::ObjectHeader *)calloc(1, sizeof(db::ObjectHeader));
+  if (!header) return false;
+
+  memcpy(header->signature, db::OBJECT_SIGNATURE, sizeof(header->signature));
+  header->version = db::OBJECT_VERSION;
+  header->size    = (int)size;
+
+  fwrite(header, sizeof(db::ObjectHeader), 1, target);
+
+  free(header);
+
+  return true;
+}
+
+static void printListing(
+                         const db::IrCode *code,
+                         const ObjectCode *object,
+                         const size_t *addresses,
+                         FILE *listing
+                        )
+{
+  assert(code);
+  assert(object);
+  assert(addresses);
+  assert(listing);
+
+  for (size_t i = 0; i < code->size; ++i)
+    {
+      const db::IrInstruction *instruction = code->instructions + i;
+
+      if (addresses[i] == NO_ADDRESS)
+        fprintf(listing, "%6s | %-17s | ", "", "");
+      else if (instruction->operand.type == db::OperandType::None ||
+               instruction->operand.type == db::OperandType::Register)
+        fprintf(listing, "%06zu | %08X %8s | ", addresses[i],
+                (unsigned)object->words[addresses[i]], "");
+      else
+        fprintf(listing, "%06zu | %08X %08X | ", addresses[i],
+                (unsigned)object->words[addresses[i]], (unsigned)object->words[addresses[i] + 1]);
+
+      db::printInstruction(instruction, listing);
+    }
+}
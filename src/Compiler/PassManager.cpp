@@ -0,0 +1,323 @@
+#include "PassManager.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include <malloc.h>
+#include "Assert.h"
+#include "SystemLike.h"
+#include "ErrorHandler.h"
+#include "Logging.h"
+#include "Error.h"
+
+const int GROWTH_FACTOR = 2;
+
+/// Registry of passes of MiddleEnd, names are used in -passes
+static const db::Pass PASSES[] = {
+  { "fold"    , "rule-based folding and simplification"     , db::simplyGrammar                  },
+  { "tail"    , "self tail calls to loops"                  , db::eliminateTailCalls             },
+  { "inline"  , "inlining of small and single-call functions", db::inlineFunctions               },
+  { "const"   , "constant propagation"                      , db::propagateConstants             },
+  { "pure"    , "evaluation of pure calls with constants"   , db::evaluatePureCalls              },
+  { "dce"     , "dead code elimination"                     , db::eliminateDeadCode              },
+  { "licm"    , "loop invariant code motion"                , db::hoistLoopInvariants            },
+  { "cse"     , "common subexpression elimination"          , db::eliminateCommonSubexpressions  },
+  { "strength", "strength reduction"                        , db::reduceStrength                 },
+};
+
+const size_t COUNT_OF_PASSES = sizeof(PASSES)/sizeof(PASSES[0]);
+
+/// @param [in, out] cursor Position in pipeline, it is moved after sequence
+/// @param [in] isGroup Sequence is closed by ]
+static bool parseSequence(db::PassManager *manager, const char **cursor, bool isGroup);
+
+static const db::Pass *searchPass(const char *name, size_t length);
+
+static bool pushStep(db::PassManager *manager, const db::Pass *pass);
+
+/// Run steps [begin, end)
+/// @param [out] isChanged Some pass changed tree, may be nullptr
+static bool runSteps(
+                     db::PassManager *manager,
+                     db::Translator *translator,
+                     size_t begin,
+                     size_t end,
+                     bool *isChanged
+                    );
+
+static bool runPass(
+                    db::PassManager *manager,
+                    db::Translator *translator,
+                    const db::Pass *pass,
+                    bool *isChanged
+                   );
+
+/// Wall time in seconds
+static double getTime();
+
+void db::initPassManager(db::PassManager *manager, const char *pipeline, int *error)
+{
+  if (!manager) ERROR();
+
+  manager->steps       = nullptr;
+  manager->size        = 0;
+  manager->capacity    = 0;
+  manager->groupRuns   = 0;
+  manager->groupLimits = 0;
+
+  manager->statistics =
+    (db::PassStatistics *)calloc(COUNT_OF_PASSES, sizeof(db::PassStatistics));
+  if (!manager->statistics) ERROR();
+
+  if (!pipeline) pipeline = db::DEFAULT_PIPELINE;
+
+  const char *cursor = pipeline;
+
+  if (!parseSequence(manager, &cursor, false))
+    {
+      handleError("Incorrect pipeline of passes [%s]", pipeline);
+      db::dumpPasses(stderr);
+
+      db::destroyPassManager(manager);
+      ERROR();
+    }
+}
+
+void db::destroyPassManager(db::PassManager *manager, int *error)
+{
+  if (!manager) ERROR();
+
+  free(manager->steps);
+  free(manager->statistics);
+
+  manager->steps      = nullptr;
+  manager->statistics = nullptr;
+  manager->size = manager->capacity = 0;
+}
+
+void db::runPasses(db::PassManager *manager, db::Translator *translator, int *error)
+{
+  if (!manager || !translator || !translator->grammar.root) ERROR();
+
+  if (!runSteps(manager, translator, 0, manager->size, nullptr)) ERROR();
+}
+
+void db::dumpPassReport(const db::PassManager *manager, FILE *target, int *error)
+{
+  if (!manager || !target) ERROR();
+
+  size_t    runs    = 0;
+  double    seconds = 0;
+  long long delta   = 0;
+
+  fprintf(target, "<pre>Passes: %zu fixpoint group runs, %zu stopped by limit\n",
+          manager->groupRuns, manager->groupLimits);
+  fprintf(target, "%-10s %6s %8s %12s %8s\n", "pass", "runs", "changes", "time, ms", "nodes");
+
+  for (size_t i = 0; i < COUNT_OF_PASSES; ++i)
+    {
+      const db::PassStatistics *statistics = manager->statistics + i;
+      if (!statistics->runs) continue;
+
+      fprintf(target, "%-10s %6zu %8zu %12.3f %+8lld\n",
+              PASSES[i].name, statistics->runs, statistics->changes,
+              statistics->seconds*1000, statistics->nodesDelta);
+
+      runs    += statistics->runs;
+      seconds += statistics->seconds;
+      delta   += statistics->nodesDelta;
+    }
+
+  fprintf(target, "%-10s %6zu %8s %12.3f %+8lld</pre>\n", "total", runs, "", seconds*1000, delta);
+}
+
+void db::dumpPasses(FILE *target, int *error)
+{
+  if (!target) ERROR();
+
+  fprintf(target, "Passes of pipeline, [a,b] repeats a and b while they change tree:\n");
+
+  for (size_t i = 0; i < COUNT_OF_PASSES; ++i)
+    fprintf(target, "  %-10s %s\n", PASSES[i].name, PASSES[i].description);
+
+  fprintf(target, "Default: %s\n", db::DEFAULT_PIPELINE);
+}
+
+static bool parseSequence(db::PassManager *manager, const char **cursor, bool isGroup)
+{
+  assert(manager);
+  assert(cursor);
+  assert(*cursor);
+
+  const char *string = *cursor;
+  bool isEmpty = true;
+
+  while (true)
+    {
+      while (isspace(*string)) ++string;
+
+      if (*string == '[')
+        {
+          size_t group = manager->size;
+          if (!pushStep(manager, nullptr)) return false;
+
+          ++string;
+          if (!parseSequence(manager, &string, true)) return false;
+
+          manager->steps[group].groupSize = manager->size - group - 1;
+        }
+      else
+        {
+          const char *name = string;
+          while (isalnum(*string) || *string == '_' || *string == '-') ++string;
+
+          const db::Pass *pass = searchPass(name, (size_t)(string - name));
+          if (!pass || !pushStep(manager, pass)) return false;
+        }
+
+      isEmpty = false;
+
+      while (isspace(*string)) ++string;
+
+      if (*string != ',') break;
+      ++string;
+    }
+
+  if (isGroup)
+    {
+      if (*string != ']') return false;
+      ++string;
+    }
+  else if (*string) return false;
+
+  *cursor = string;
+
+  return !isEmpty;
+}
+
+static const db::Pass *searchPass(const char *name, size_t length)
+{
+  assert(name);
+
+  if (!length) return nullptr;
+
+  for (size_t i = 0; i < COUNT_OF_PASSES; ++i)
+    if (strlen(PASSES[i].name) == length && !strncmp(PASSES[i].name, name, length))
+      return PASSES + i;
+
+  return nullptr;
+}
+
+static bool pushStep(db::PassManager *manager, const db::Pass *pass)
+{
+  assert(manager);
+
+  if (manager->size == manager->capacity)
+    {
+      manager->capacity = GROWTH_FACTOR*manager->capacity + 1;
+      db::PipelineStep *temp =
+        (db::PipelineStep *)recalloc(manager->steps, manager->capacity, sizeof(db::PipelineStep));
+      if (!temp) return false;
+
+      manager->steps = temp;
+    }
+
+  manager->steps[manager->size++] = { .pass = pass, .groupSize = 0 };
+
+  return true;
+}
+
+static bool runSteps(
+                     db::PassManager *manager,
+                     db::Translator *translator,
+                     size_t begin,
+                     size_t end,
+                     bool *isChanged
+                    )
+{
+  assert(manager);
+  assert(translator);
+
+  for (size_t i = begin; i < end; )
+    {
+      db::PipelineStep *step = manager->steps + i;
+
+      if (step->pass)
+        {
+          if (!runPass(manager, translator, step->pass, isChanged)) return false;
+
+          ++i;
+          continue;
+        }
+
+      size_t first = i + 1;
+      size_t last  = first + step->groupSize;
+
+      ++manager->groupRuns;
+
+      bool isGroupChanged = true;
+      size_t iteration = 0;
+
+      for ( ; isGroupChanged && iteration < db::MAX_FIXPOINT_ITERATIONS; ++iteration)
+        {
+          isGroupChanged = false;
+          if (!runSteps(manager, translator, first, last, &isGroupChanged)) return false;
+
+          if (isGroupChanged && isChanged) *isChanged = true;
+        }
+
+      if (isGroupChanged) ++manager->groupLimits;
+
+      i = last;
+    }
+
+  return true;
+}
+
+static bool runPass(
+                    db::PassManager *manager,
+                    db::Translator *translator,
+                    const db::Pass *pass,
+                    bool *isChanged
+                   )
+{
+  assert(manager);
+  assert(translator);
+  assert(pass);
+
+  db::PassStatistics *statistics = manager->statistics + (pass - PASSES);
+
+  size_t     nodes = db::countNodes(translator->grammar.root);
+  db::hash_t hash  = db::hashNode(translator->grammar.root);
+
+  double start = getTime();
+
+  int error = 0;
+  pass->run(translator, &error);
+
+  statistics->seconds += getTime() - start;
+  ++statistics->runs;
+
+  if (error) return false;
+
+  size_t newNodes = db::countNodes(translator->grammar.root);
+
+  statistics->nodesDelta += (long long)newNodes - (long long)nodes;
+
+  if (newNodes != nodes || db::hashNode(translator->grammar.root) != hash)
+    {
+      ++statistics->changes;
+      if (isChanged) *isChanged = true;
+    }
+
+  return true;
+}
+
+static double getTime()
+{
+  timespec time{};
+  clock_gettime(CLOCK_MONOTONIC, &time);
+
+  return (double)time.tv_sec + (double)time.tv_nsec/1e9;
+}
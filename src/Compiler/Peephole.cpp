@@ -0,0 +1,228 @@
+#include "StackIr.h"
+
+#include <stdio.h>
+#include "Assert.h"
+#include "Error.h"
+
+#pragma GCC diagnostic ignored "-Wswitch-enum"
+
+const size_t MAX_WINDOW_SIZE = 4;
+
+/// Any instruction, rule checks it by condition
+const db::Opcode ANY = db::Opcode::COMMENT;
+
+/// Rewrite rule: window of instructions -> kept instructions of window
+/// @note Comments are skipped by window and are never removed
+struct PeepholeRule {
+  const char *name;
+  size_t      size;
+  db::Opcode  pattern[MAX_WINDOW_SIZE];
+  bool      (*isMatched)(const db::IrInstruction *const *window);
+  size_t      keptSize;
+  size_t      kept[MAX_WINDOW_SIZE]; ///< Indexes in window
+  size_t      hits;
+};
+
+/// PUSH x, POP x
+static bool isSelfMove(const db::IrInstruction *const *window);
+
+/// PUSH a, POP r, PUSH b, POP r, where b doesn`t read r
+static bool isDeadRegisterStore(const db::IrInstruction *const *window);
+
+/// JMP l, l:
+static bool isJumpToNext(const db::IrInstruction *const *window);
+
+/// JMP l, m:, l:
+static bool isJumpOverLabel(const db::IrInstruction *const *window);
+
+/// RET, JMP or HLT followed by instruction which isn`t label
+static bool isUnreachable(const db::IrInstruction *const *window);
+
+using enum db::Opcode;
+
+static PeepholeRule RULES[] = {
+  // name                 size  pattern                     condition            kept
+  { "push x; pop x"     , 2, { PUSH, POP            }, isSelfMove         , 0, {    }, 0 },
+  { "dead store to reg" , 4, { PUSH, POP, PUSH, POP }, isDeadRegisterStore, 2, {2, 3}, 0 },
+  { "jmp to next"       , 2, { JMP , LABEL          }, isJumpToNext       , 1, {1   }, 0 },
+  { "jmp over label"    , 3, { JMP , LABEL, LABEL   }, isJumpOverLabel    , 2, {1, 2}, 0 },
+  { "unreachable"       , 2, { ANY , ANY            }, isUnreachable      , 1, {0   }, 0 },
+};
+
+const size_t RULES_COUNT = sizeof(RULES)/sizeof(RULES[0]);
+
+/// Positions of next instructions which aren`t comments and aren`t removed
+/// @return Count of found instructions, it is less than size at the end of code
+static size_t fillWindow(
+                         const db::IrCode *code,
+                         const bool *isRemoved,
+                         size_t start,
+                         size_t *positions,
+                         size_t size
+                        );
+
+static bool applyRules(db::IrCode *code, bool *isRemoved);
+
+static bool isMatched(const PeepholeRule *rule, const db::IrInstruction *const *window);
+
+static bool isJump(db::Opcode opcode);
+
+static bool readsRegister(const db::IrOperand *operand, db::Register reg);
+
+void db::optimizePeephole(db::IrCode *code, int *error)
+{
+  if (!code) ERROR();
+
+  size_t capacity = code->size;
+  bool *isRemoved = (bool *)calloc(capacity + 1, sizeof(bool));
+  if (!isRemoved) ERROR();
+
+  // Replacement of rule may create new window for another one
+  while (applyRules(code, isRemoved))
+    {
+      size_t size = 0;
+      for (size_t i = 0; i < code->size; ++i)
+        if (!isRemoved[i])
+          code->instructions[size++] = code->instructions[i];
+
+      for (size_t i = 0; i < code->size; ++i) isRemoved[i] = false;
+
+      code->size = size;
+    }
+
+  free(isRemoved);
+}
+
+void db::dumpPeepholeStatistics(FILE *target, int *error)
+{
+  if (!target) ERROR();
+
+  fprintf(target, "<pre>Peephole rules:\n");
+  for (size_t i = 0; i < RULES_COUNT; ++i)
+    if (RULES[i].hits)
+      fprintf(target, "  %-20s %zu\n", RULES[i].name, RULES[i].hits);
+  fprintf(target, "</pre>\n");
+}
+
+static bool applyRules(db::IrCode *code, bool *isRemoved)
+{
+  assert(code);
+  assert(isRemoved);
+
+  bool isChanged = false;
+
+  size_t positions[MAX_WINDOW_SIZE] = {};
+  const db::IrInstruction *window[MAX_WINDOW_SIZE] = {};
+
+  for (size_t i = 0; i < code->size; )
+    {
+      size_t size = fillWindow(code, isRemoved, i, positions, MAX_WINDOW_SIZE);
+      if (!size) break;
+
+      for (size_t j = 0; j < size; ++j) window[j] = code->instructions + positions[j];
+
+      PeepholeRule *rule = nullptr;
+      for (size_t j = 0; j < RULES_COUNT && !rule; ++j)
+        if (RULES[j].size <= size && isMatched(RULES + j, window))
+          rule = RULES + j;
+
+      if (!rule)
+        {
+          i = positions[0] + 1;
+          continue;
+        }
+
+      // Functions may be optimized by several threads
+      __atomic_add_fetch(&rule->hits, 1, __ATOMIC_RELAXED);
+      isChanged = true;
+
+      for (size_t j = 0; j < rule->size; ++j)
+        {
+          bool isKept = false;
+          for (size_t k = 0; k < rule->keptSize; ++k)
+            isKept |= (rule->kept[k] == j);
+
+          if (!isKept) isRemoved[positions[j]] = true;
+        }
+
+      // Kept instructions may start next window, e.g. RET with the next unreachable one,
+      // windows before them are checked by the next pass
+      i = (rule->keptSize ? positions[rule->kept[0]] : positions[rule->size - 1] + 1);
+    }
+
+  return isChanged;
+}
+
+static size_t fillWindow(
+                         const db::IrCode *code,
+                         const bool *isRemoved,
+                         size_t start,
+                         size_t *positions,
+                         size_t size
+                        )
+{
+  assert(code);
+  assert(isRemoved);
+  assert(positions);
+
+  size_t count = 0;
+  for (size_t i = start; i < code->size && count < size; ++i)
+    if (code->instructions[i].opcode != db::Opcode::COMMENT && !isRemoved[i])
+      positions[count++] = i;
+
+  return count;
+}
+
+static bool isMatched(const PeepholeRule *rule, const db::IrInstruction *const *window)
+{
+  assert(rule);
+  assert(window);
+
+  for (size_t i = 0; i < rule->size; ++i)
+    if (rule->pattern[i] != ANY && window[i]->opcode != rule->pattern[i])
+      return false;
+
+  return rule->isMatched(window);
+}
+
+static bool isSelfMove(const db::IrInstruction *const *window)
+{
+  return db::isSameOperand(&window[0]->operand, &window[1]->operand);
+}
+
+static bool isDeadRegisterStore(const db::IrInstruction *const *window)
+{
+  const db::IrOperand *reg = &window[1]->operand;
+
+  return reg->type == db::OperandType::Register &&
+         db::isSameOperand(reg, &window[3]->operand) &&
+         !readsRegister(&window[2]->operand, reg->base);
+}
+
+static bool isJumpToNext(const db::IrInstruction *const *window)
+{
+  return db::isSameOperand(&window[0]->operand, &window[1]->operand);
+}
+
+static bool isJumpOverLabel(const db::IrInstruction *const *window)
+{
+  return db::isSameOperand(&window[0]->operand, &window[2]->operand);
+}
+
+static bool isUnreachable(const db::IrInstruction *const *window)
+{
+  return isJump(window[0]->opcode) && window[1]->opcode != db::Opcode::LABEL;
+}
+
+static bool isJump(db::Opcode opcode)
+{
+  return opcode == db::Opcode::JMP || opcode == db::Opcode::RET || opcode == db::Opcode::HLT;
+}
+
+static bool readsRegister(const db::IrOperand *operand, db::Register reg)
+{
+  assert(operand);
+
+  return (operand->type == db::OperandType::Register ||
+          operand->type == db::OperandType::Memory) && operand->base == reg;
+}
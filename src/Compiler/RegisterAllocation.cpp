@@ -0,0 +1,579 @@
+#include "StackIr.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#include "SystemLike.h"
+#include "Assert.h"
+#include "Error.h"
+
+#pragma GCC diagnostic ignored "-Wswitch-enum"
+
+const int GROWTH_FACTOR = 2;
+
+/// Registers which aren`t used by generated code between calls, in order of preference
+/// @note rfx is never used by Translator. rax and rbx hold return value of callee, so they are
+///       clobbered from CALL up to PUSH rbx, PUSH rax after it, every slot living across
+///       CALL is spilled before it and reloaded only after these pushes, see findReload.
+///       In callee they are written only by return, frame isn`t read after it
+const db::Register FREE_REGISTERS[] = {
+  db::Register::RFX,
+  db::Register::RAX,
+  db::Register::RBX,
+};
+
+const size_t FREE_REGISTERS_COUNT = sizeof(FREE_REGISTERS)/sizeof(FREE_REGISTERS[0]);
+
+/// Frame base of locals, slots with other bases aren`t allocated
+const db::Register FRAME_REGISTER = db::Register::RDX;
+/// Frame base of prologue and epilogue, it is equal to frame base there
+const db::Register STACK_REGISTER = db::Register::RCX;
+
+/// Use in loop is weighted as LOOP_WEIGHT uses out of it
+const double LOOP_WEIGHT     = 8;
+const int    MAX_LOOP_DEPTH  = 6;
+/// Load or store is two instructions and one memory access, access by register saves only it
+const double MOVE_COST       = 2;
+
+const int NO_TARGET = -1;
+
+/// Range of instructions connected with one by jumps, including itself
+struct Reach {
+  size_t low;
+  size_t high;
+};
+
+/// Word of frame, it is int or fract part of local variable
+struct Slot {
+  int address;
+
+  size_t start;
+  size_t end;
+
+  double benefit; ///< Weighted count of memory accesses replaced by register
+  double cost;    ///< Weighted count of loads and stores added at bounds and calls
+
+  bool isWritten;
+  bool isLiveIn;  ///< Value of memory may be read, so it is loaded at start and stored at end
+  bool isRejected;
+
+  db::Register reg;
+};
+
+struct SlotTable {
+  Slot  *slots;
+  size_t size;
+  size_t capacity;
+};
+
+/// Instruction index of label of every jump
+static int *findTargets(const db::IrCode *code);
+
+static int compareLabels(const void *first, const void *second);
+
+/// strcmp where nullptr is less than any string
+static int compareNames(const char *first, const char *second);
+
+/// Count of loops around every instruction, loop is region of backward jump
+static int *findLoopDepths(const db::IrCode *code, const int *targets);
+
+static Reach *findReaches(const db::IrCode *code, const int *targets);
+
+static bool collectSlots(const db::IrCode *code, SlotTable *table);
+
+static Slot *findSlot(SlotTable *table, int address);
+
+/// Extend slot until no jump enters or leaves it, so it is entered only at start
+/// @note Every instruction is checked once, interval only grows
+static void closeInterval(const Reach *reaches, Slot *slot);
+
+static void estimateSlot(const db::IrCode *code, const int *depths, Slot *slot);
+
+/// Linear scan in order of starts, the cheapest active slot is spilled
+static void scanSlots(SlotTable *table);
+
+static int compareStarts(const void *first, const void *second);
+
+static double getProfit(const Slot *slot);
+
+/// Instruction after return value of call is pushed, rdx is restored there
+static size_t findReload(const db::IrCode *code, size_t call);
+
+static bool rewriteCode(db::IrCode *code, const SlotTable *table);
+
+static bool isFrameAccess(const db::IrInstruction *instruction, db::Register base);
+
+static bool isConditionalJump(db::Opcode opcode);
+
+static bool isBranch(db::Opcode opcode);
+
+static double getWeight(int depth);
+
+void db::allocateRegisters(db::IrCode *code, int *error)
+{
+  if (!code) ERROR();
+
+  int *targets = findTargets(code);
+  if (!targets) ERROR();
+
+  int   *depths  = findLoopDepths(code, targets);
+  Reach *reaches = findReaches   (code, targets);
+  if (!depths || !reaches)
+    {
+      free(reaches);
+      free(depths);
+      free(targets);
+      ERROR();
+    }
+
+  SlotTable table{};
+  bool isCorrect = collectSlots(code, &table);
+
+  if (isCorrect)
+    {
+      for (size_t i = 0; i < table.size; ++i)
+        {
+          closeInterval(reaches, table.slots + i);
+          estimateSlot (code, depths , table.slots + i);
+        }
+
+      scanSlots(&table);
+
+      isCorrect = rewriteCode(code, &table);
+    }
+
+  free(table.slots);
+  free(reaches);
+  free(depths);
+  free(targets);
+
+  if (!isCorrect) ERROR();
+}
+
+static int *findTargets(const db::IrCode *code)
+{
+  assert(code);
+
+  int *targets = (int *)calloc(code->size + 1, sizeof(int));
+  if (!targets) return nullptr;
+
+  const db::IrInstruction **labels =
+    (const db::IrInstruction **)calloc(code->size + 1, sizeof(const db::IrInstruction *));
+  if (!labels)
+    {
+      free(targets);
+      return nullptr;
+    }
+
+  size_t labelCount = 0;
+  for (size_t i = 0; i < code->size; ++i)
+    if (code->instructions[i].opcode == db::Opcode::LABEL)
+      labels[labelCount++] = code->instructions + i;
+
+  qsort(labels, labelCount, sizeof(const db::IrInstruction *), compareLabels);
+
+  for (size_t i = 0; i < code->size; ++i)
+    {
+      targets[i] = NO_TARGET;
+
+      if (!isBranch(code->instructions[i].opcode)) continue;
+
+      const db::IrInstruction *jump = code->instructions + i;
+      const db::IrInstruction **label = (const db::IrInstruction **)
+        bsearch(&jump, labels, labelCount, sizeof(const db::IrInstruction *), compareLabels);
+
+      if (label) targets[i] = (int)(*label - code->instructions);
+    }
+
+  free(labels);
+
+  return targets;
+}
+
+static int compareLabels(const void *first, const void *second)
+{
+  const db::IrOperand *firstLabel  = &(*(const db::IrInstruction *const *)first )->operand;
+  const db::IrOperand *secondLabel = &(*(const db::IrInstruction *const *)second)->operand;
+
+  int difference = compareNames(firstLabel->prefix, secondLabel->prefix);
+  if (!difference) difference = compareNames(firstLabel->name, secondLabel->name);
+  if (difference) return difference;
+
+  return (firstLabel->value > secondLabel->value) - (firstLabel->value < secondLabel->value);
+}
+
+static int compareNames(const char *first, const char *second)
+{
+  if (!first || !second) return (first != nullptr) - (second != nullptr);
+
+  return strcmp(first, second);
+}
+
+static int *findLoopDepths(const db::IrCode *code, const int *targets)
+{
+  assert(code);
+  assert(targets);
+
+  int *depths = (int *)calloc(code->size + 1, sizeof(int));
+  if (!depths) return nullptr;
+
+  // Loop adds one from its label up to its jump, prefix sums of bounds give depths
+  for (size_t i = 0; i < code->size; ++i)
+    if (targets[i] != NO_TARGET && (size_t)targets[i] < i)
+      {
+        ++depths[targets[i]];
+        --depths[i + 1];
+      }
+
+  for (size_t i = 1; i < code->size; ++i)
+    depths[i] += depths[i - 1];
+
+  return depths;
+}
+
+static Reach *findReaches(const db::IrCode *code, const int *targets)
+{
+  assert(code);
+  assert(targets);
+
+  Reach *reaches = (Reach *)calloc(code->size + 1, sizeof(Reach));
+  if (!reaches) return nullptr;
+
+  for (size_t i = 0; i < code->size; ++i)
+    reaches[i] = { .low = i, .high = i };
+
+  for (size_t i = 0; i < code->size; ++i)
+    {
+      if (targets[i] == NO_TARGET) continue;
+
+      size_t target = (size_t)targets[i];
+
+      if (target < reaches[i].low ) reaches[i].low  = target;
+      if (target > reaches[i].high) reaches[i].high = target;
+
+      if (i < reaches[target].low ) reaches[target].low  = i;
+      if (i > reaches[target].high) reaches[target].high = i;
+    }
+
+  return reaches;
+}
+
+static bool collectSlots(const db::IrCode *code, SlotTable *table)
+{
+  assert(code);
+  assert(table);
+
+  for (size_t i = 0; i < code->size; ++i)
+    {
+      const db::IrInstruction *instruction = code->instructions + i;
+      if (!isFrameAccess(instruction, FRAME_REGISTER)) continue;
+
+      Slot *slot = findSlot(table, instruction->operand.value);
+      if (!slot)
+        {
+          if (table->size == table->capacity)
+            {
+              table->capacity = GROWTH_FACTOR*table->capacity + 1;
+              Slot *temp = (Slot *)recalloc(table->slots, table->capacity, sizeof(Slot));
+              if (!temp) return false;
+
+              table->slots = temp;
+            }
+
+          slot = table->slots + table->size++;
+          *slot = { .address = instruction->operand.value, .start = i, .reg = db::Register::NONE };
+        }
+
+      slot->end = i;
+      slot->isWritten |= (instruction->opcode == db::Opcode::POP);
+    }
+
+  return true;
+}
+
+static Slot *findSlot(SlotTable *table, int address)
+{
+  assert(table);
+
+  for (size_t i = 0; i < table->size; ++i)
+    if (table->slots[i].address == address)
+      return table->slots + i;
+
+  return nullptr;
+}
+
+static void closeInterval(const Reach *reaches, Slot *slot)
+{
+  assert(reaches);
+  assert(slot);
+
+  // Instructions from first up to last are checked, jump of each of them is inside
+  size_t first = slot->start;
+  size_t last  = slot->start;
+
+  const Reach *reach = reaches + first;
+  while (true)
+    {
+      if (reach->low  < slot->start) slot->start = reach->low ;
+      if (reach->high > slot->end  ) slot->end   = reach->high;
+
+      if      (last  < slot->end  ) reach = reaches + ++last ;
+      else if (first > slot->start) reach = reaches + --first;
+      else break;
+    }
+}
+
+static void estimateSlot(const db::IrCode *code, const int *depths, Slot *slot)
+{
+  assert(code);
+  assert(depths);
+  assert(slot);
+
+  // Value isn`t live at start if it is written before any jump or label
+  slot->isLiveIn = true;
+  for (size_t i = slot->start; i <= slot->end; ++i)
+    {
+      const db::IrInstruction *instruction = code->instructions + i;
+
+      if (isFrameAccess(instruction, FRAME_REGISTER) &&
+          instruction->operand.value == slot->address)
+        {
+          slot->isLiveIn = (instruction->opcode != db::Opcode::POP);
+          break;
+        }
+
+      if (isBranch(instruction->opcode) || instruction->opcode == db::Opcode::LABEL) break;
+    }
+
+  if (slot->isLiveIn)
+    {
+      slot->cost += MOVE_COST*getWeight(depths[slot->start]);
+      if (slot->isWritten) slot->cost += MOVE_COST*getWeight(depths[slot->end]);
+    }
+
+  for (size_t i = slot->start; i <= slot->end; ++i)
+    {
+      const db::IrInstruction *instruction = code->instructions + i;
+
+      if (instruction->opcode == db::Opcode::CALL)
+        slot->cost += (slot->isWritten ? 2 : 1)*MOVE_COST*getWeight(depths[i]);
+
+      // Prologue and epilogue address frame by stack pointer
+      if (isFrameAccess(instruction, STACK_REGISTER) &&
+          instruction->operand.value == slot->address)
+        slot->isRejected = true;
+
+      if (isFrameAccess(instruction, FRAME_REGISTER) &&
+          instruction->operand.value == slot->address)
+        slot->benefit += getWeight(depths[i]);
+    }
+
+  if (slot->benefit <= slot->cost) slot->isRejected = true;
+}
+
+static void scanSlots(SlotTable *table)
+{
+  assert(table);
+
+  qsort(table->slots, table->size, sizeof(Slot), compareStarts);
+
+  Slot *active[FREE_REGISTERS_COUNT] = {};
+
+  for (size_t i = 0; i < table->size; ++i)
+    {
+      Slot *slot = table->slots + i;
+      if (slot->isRejected) continue;
+
+      for (size_t j = 0; j < FREE_REGISTERS_COUNT; ++j)
+        if (active[j] && active[j]->end < slot->start)
+          active[j] = nullptr;
+
+      size_t index = 0;
+      while (index < FREE_REGISTERS_COUNT && active[index]) ++index;
+
+      if (index == FREE_REGISTERS_COUNT)
+        {
+          index = 0;
+          for (size_t j = 1; j < FREE_REGISTERS_COUNT; ++j)
+            if (getProfit(active[j]) < getProfit(active[index]))
+              index = j;
+
+          if (getProfit(active[index]) >= getProfit(slot)) continue;
+
+          active[index]->reg = db::Register::NONE;
+        }
+
+      slot->reg = FREE_REGISTERS[index];
+      active[index] = slot;
+    }
+}
+
+static int compareStarts(const void *first, const void *second)
+{
+  const Slot *firstSlot  = (const Slot *)first;
+  const Slot *secondSlot = (const Slot *)second;
+
+  if (firstSlot->start != secondSlot->start) return (firstSlot->start < secondSlot->start ? -1 : 1);
+
+  return firstSlot->address - secondSlot->address;
+}
+
+static size_t findReload(const db::IrCode *code, size_t call)
+{
+  assert(code);
+
+  const db::Opcode expected[] = { db::Opcode::POP, db::Opcode::PUSH, db::Opcode::PUSH };
+  const db::Register registers[] = {
+    db::Register::RDX,
+    db::Register::RBX,
+    db::Register::RAX,
+  };
+
+  size_t position = call + 1;
+  for (size_t i = 0; i < sizeof(expected)/sizeof(expected[0]); ++i)
+    {
+      while (position < code->size && code->instructions[position].opcode == db::Opcode::COMMENT)
+        ++position;
+
+      const db::IrInstruction *instruction = code->instructions + position;
+      if (position >= code->size || instruction->opcode != expected[i] ||
+          instruction->operand.type != db::OperandType::Register ||
+          instruction->operand.base != registers[i])
+        break;
+
+      ++position;
+    }
+
+  return position;
+}
+
+static bool rewriteCode(db::IrCode *code, const SlotTable *table)
+{
+  assert(code);
+  assert(table);
+
+  db::IrCode result{};
+  db::initIr(&result);
+
+  // Reloads after calls wait for restoring of frame base and return value
+  size_t call   = code->size;
+  size_t reload = code->size;
+
+  for (size_t i = 0; i < code->size; ++i)
+    {
+      db::IrInstruction instruction = code->instructions[i];
+
+      for (size_t j = 0; j < table->size; ++j)
+        {
+          const Slot *slot = table->slots + j;
+          if (slot->reg == db::Register::NONE) continue;
+
+          db::IrOperand memory = db::memoryOperand(slot->address, FRAME_REGISTER);
+
+          if (i == reload && slot->start < call && call < slot->end)
+            {
+              db::emitIr(&result, db::Opcode::PUSH, memory, "Reload register");
+              db::emitIr(&result, db::Opcode::POP , db::registerOperand(slot->reg));
+            }
+
+          if (i == slot->start && slot->isLiveIn)
+            {
+              db::emitIr(&result, db::Opcode::PUSH, memory, "Load register");
+              db::emitIr(&result, db::Opcode::POP , db::registerOperand(slot->reg));
+            }
+
+          if (instruction.opcode == db::Opcode::CALL && slot->start < i && i < slot->end &&
+              slot->isWritten)
+            {
+              db::emitIr(&result, db::Opcode::PUSH, db::registerOperand(slot->reg), "Spill register");
+              db::emitIr(&result, db::Opcode::POP , memory);
+            }
+
+          if (isFrameAccess(&instruction, FRAME_REGISTER) &&
+              instruction.operand.value == slot->address)
+            instruction.operand = db::registerOperand(slot->reg);
+        }
+
+      if (i == reload) reload = code->size;
+
+      db::emitIr(&result, instruction.opcode, instruction.operand, instruction.comment);
+
+      if (instruction.opcode == db::Opcode::CALL)
+        {
+          call   = i;
+          reload = findReload(code, i);
+        }
+
+      for (size_t j = 0; j < table->size; ++j)
+        {
+          const Slot *slot = table->slots + j;
+          if (slot->reg == db::Register::NONE || i != slot->end) continue;
+
+          if (slot->isLiveIn && slot->isWritten)
+            {
+              db::emitIr(&result, db::Opcode::PUSH, db::registerOperand(slot->reg), "Store register");
+              db::emitIr(&result, db::Opcode::POP , db::memoryOperand(slot->address, FRAME_REGISTER));
+            }
+        }
+    }
+
+  if (result.isFailed)
+    {
+      db::destroyIr(&result);
+      return false;
+    }
+
+  free(code->instructions);
+
+  code->instructions = result.instructions;
+  code->size         = result.size;
+  code->capacity     = result.capacity;
+
+  return true;
+}
+
+static bool isFrameAccess(const db::IrInstruction *instruction, db::Register base)
+{
+  assert(instruction);
+
+  return (instruction->opcode == db::Opcode::PUSH || instruction->opcode == db::Opcode::POP) &&
+         instruction->operand.type == db::OperandType::Memory &&
+         instruction->operand.base == base;
+}
+
+static bool isConditionalJump(db::Opcode opcode)
+{
+  switch (opcode)
+    {
+    case db::Opcode::JE:
+    case db::Opcode::JNE:
+    case db::Opcode::JB:
+    case db::Opcode::JA:
+    case db::Opcode::JBE:
+    case db::Opcode::JAE:
+      return true;
+    default:
+      return false;
+    }
+}
+
+static bool isBranch(db::Opcode opcode)
+{
+  return opcode == db::Opcode::JMP || isConditionalJump(opcode);
+}
+
+static double getProfit(const Slot *slot)
+{
+  assert(slot);
+
+  return slot->benefit - slot->cost;
+}
+
+static double getWeight(int depth)
+{
+  double weight = 1;
+  for (int i = 0; i < depth && i < MAX_LOOP_DEPTH; ++i) weight *= LOOP_WEIGHT;
+
+  return weight;
+}
@@ -1,262 +1,601 @@
 #include "Translator.h"
+#include "ExpressionDag.h"
 
 #include <math.h>
 #include "DSL.h"
 #include "Assert.h"
 #include "ErrorHandler.h"
 #include "Error.h"
+#include "SystemLike.h"
+#include "Logging.h"
+#include <malloc.h>
 
 #pragma GCC diagnostic ignored "-Wswitch-enum"
 
-#undef Left
-#undef Right
-
-#define Left  token->left
-#define Right token->right
-
-#define dLeft  diff(copyLeft )
-#define dRight diff(copyRight)
-
-#define copyLeft  db::createNode(token->left )
-#define copyRight db::createNode(token->right)
-
-#define HANDLE_ERROR(MESSAGE, ...)                    \
-  do                                                  \
-    {                                                 \
-      handleError(MESSAGE __VA_OPT__(,) __VA_ARGS__); \
-      ERROR();                                        \
-    } while (0)
-
-#define SIMPLY_UNARY(NAME, OP)                    \
-  do                                              \
-    {                                             \
-      if (!token->left)                           \
-        HANDLE_ERROR("Expected that " #NAME       \
-                     " has one argument");        \
-                                                  \
-      simplyToken(token->left, error);            \
-      if (*error) ERROR();                        \
-                                                  \
-      if (!IS_NUM(token->left ))                  \
-        break;                                    \
-                                                  \
-      token->type = db::type_t::NUMBER;           \
-      NUMBER(token) = OP(NUMBER(token->left));    \
-                                                  \
-      db::Token left  = token->left;              \
-      token->left = nullptr;                      \
-                                                  \
-      db::removeNode(left );                      \
-    } while (0)
-
-#define SIMPLY_BINARY(NAME, OP)                       \
-  do                                                  \
-    {                                                 \
-      if (!token->left || !token->right)              \
-        HANDLE_ERROR("Expected that " #NAME           \
-                     " has two arguments");           \
-                                                      \
-      simplyToken(token->left, error);                \
-      if (*error) ERROR();                            \
-      simplyToken(token->right, error);               \
-      if (*error) ERROR();                            \
-                                                      \
-      if (!IS_NUM(token->left ) ||                    \
-          !IS_NUM(token->right))                      \
-        break;                                        \
-                                                      \
-      token->type = db::type_t::NUMBER;               \
-      NUMBER(token) =                                 \
-        NUMBER(token->left) OP NUMBER(token->right);  \
-                                                      \
-      db::Token left  = token->left ;                 \
-      token->left  = nullptr;                         \
-      db::Token right = token->right;                 \
-      token->right = nullptr;                         \
-                                                      \
-      db::removeNode(left );                          \
-      db::removeNode(right);                          \
-    } while (0)
-
-#define SIMPLY_LINARY(NAME, OP)                           \
-  do                                                      \
-    {                                                     \
-      if (!token->left)                                   \
-        HANDLE_ERROR("Expected that " #NAME               \
-                     " has at least one argument");       \
-                                                          \
-      simplyToken(token->left, error);                    \
-      if (*error) ERROR();                                \
-                                                          \
-      if (token->right)                                   \
-        {                                                 \
-          simplyToken(token->right, error);               \
-          if (*error) ERROR();                            \
-                                                          \
-          if (!IS_NUM(token->left ) ||                    \
-              !IS_NUM(token->right))                      \
-            break;                                        \
-                                                          \
-          token->type = db::type_t::NUMBER;               \
-          NUMBER(token) =                                 \
-            NUMBER(token->left) OP NUMBER(token->right);  \
-                                                          \
-          db::Token left  = token->left ;                 \
-          token->left  = nullptr;                         \
-          db::Token right = token->right;                 \
-          token->right = nullptr;                         \
-                                                          \
-          db::removeNode(left );                          \
-          db::removeNode(right);                          \
-        }                                                 \
-      else if (IS_NUM(token->left))                       \
-        {                                                 \
-          token->type = db::type_t::NUMBER;               \
-          NUMBER(token) = OP NUMBER(token->left);         \
-                                                          \
-          db::Token left = token->left;                   \
-          token->left = nullptr;                          \
-                                                          \
-          db::removeNode(left);                           \
-        }                                                 \
-    } while (0)
-
-static db::Token createNumber(db::number_t value)
+/// Operand of rule pattern
+enum class Operand {
+  Any,      ///< Any expression
+  Pure,     ///< Expression without side effects, rule may remove it
+  Zero,
+  One,
+  Number,
+  Negation, ///< Unary minus
+  None,     ///< Operand is absent (unary form of statement)
+};
+
+/// Replacement of matched node
+enum class Result {
+  KeepLeft,
+  KeepRight,
+  Zero,
+  Fold,        ///< Calculate value of constant operands
+  NegateRight, ///< -Right
+  KeepOperand, ///< Operand of unary Left
+};
+
+/// Rewrite rule: statement(left, right) -> result
+struct SimplifyRule {
+  const char     *name;
+  db::statement_t statement;
+  Operand         left;
+  Operand         right;
+  bool            isSame; ///< Operands must be equal expressions
+  Result          result;
+};
+
+#define RULE(NAME, STATEMENT, LEFT, RIGHT, IS_SAME, RESULT)    \
+  {                                                            \
+    NAME,                                                      \
+    db::STATEMENT_ ## STATEMENT,                               \
+    Operand::LEFT,                                             \
+    Operand::RIGHT,                                            \
+    IS_SAME,                                                   \
+    Result::RESULT,                                            \
+  }
+
+static const SimplifyRule RULES[] = {
+  RULE("a + b"  , ADD , Number  , Number, false, Fold         ),
+  RULE("a - b"  , SUB , Number  , Number, false, Fold         ),
+  RULE("a * b"  , MUL , Number  , Number, false, Fold         ),
+  RULE("a / b"  , DIV , Number  , Number, false, Fold         ),
+  RULE("a ^ b"  , POW , Number  , Number, false, Fold         ),
+  RULE("+a"     , ADD , Number  , None  , false, Fold         ),
+  RULE("-a"     , SUB , Number  , None  , false, Fold         ),
+  RULE("sin a"  , SIN , Number  , None  , false, Fold         ),
+  RULE("cos a"  , COS , Number  , None  , false, Fold         ),
+  RULE("tan a"  , TAN , Number  , None  , false, Fold         ),
+  RULE("sqrt a" , SQRT, Number  , None  , false, Fold         ),
+  RULE("[a]"    , INT , Number  , None  , false, Fold         ),
+  RULE("a < b"  , LESS     , Number, Number, false, Fold),
+  RULE("a > b"  , GREATER  , Number, Number, false, Fold),
+  RULE("a == b" , EQUAL    , Number, Number, false, Fold),
+  RULE("a != b" , NOT_EQUAL, Number, Number, false, Fold),
+  RULE("a && b" , AND      , Number, Number, false, Fold),
+  RULE("a || b" , OR       , Number, Number, false, Fold),
+
+  RULE("x + 0"  , ADD , Any     , Zero  , false, KeepLeft     ),
+  RULE("0 + x"  , ADD , Zero    , Any   , false, KeepRight    ),
+  RULE("+x"     , ADD , Any     , None  , false, KeepLeft     ),
+  RULE("x - 0"  , SUB , Any     , Zero  , false, KeepLeft     ),
+  RULE("0 - x"  , SUB , Zero    , Any   , false, NegateRight  ),
+  RULE("x - x"  , SUB , Pure    , Pure  , true , Zero         ),
+  RULE("--x"    , SUB , Negation, None  , false, KeepOperand  ),
+  RULE("x * 0"  , MUL , Pure    , Zero  , false, Zero         ),
+  RULE("0 * x"  , MUL , Zero    , Pure  , false, Zero         ),
+  RULE("x * 1"  , MUL , Any     , One   , false, KeepLeft     ),
+  RULE("1 * x"  , MUL , One     , Any   , false, KeepRight    ),
+  RULE("x / 1"  , DIV , Any     , One   , false, KeepLeft     ),
+};
+
+#undef RULE
+
+const size_t RULES_COUNT = sizeof(RULES)/sizeof(RULES[0]);
+
+const int GROWTH_FACTOR = 2;
+
+/// Parent of nodes which were removed from tree while simplification
+static db::TreeNode DETACHED_NODE{};
+
+/// Stack of nodes waiting for simplification
+struct Worklist {
+  db::Token *nodes;
+  size_t size;
+  size_t capacity;
+
+  db::Token *garbage; ///< Detached subtrees, they are removed at the end
+  size_t garbageSize;
+  size_t garbageCapacity;
+
+  size_t hits[RULES_COUNT]; ///< Applications of rules in this run
+};
+
+static bool pushToken(db::Token **array, size_t *size, size_t *capacity, db::Token token);
+
+static bool fillWorklist(Worklist *worklist, db::Token token, db::Token parent);
+
+/// Replace DIFF statements by derivatives
+/// @param [in] command Pointer to compound statement whose left contains token,
+/// pointer to nullptr if values can`t be declared before statement of token
+/// @param [in, out] countOfValues Count of declared values, it numbers their names
+static bool expandDiffs(
+                        db::Translator *translator,
+                        db::Token token,
+                        db::Token *command,
+                        size_t *countOfValues
+                       );
+
+/// Replace DIFF statement by its derivative, subexpressions which are shared in
+/// derivative are bound to values declared before command
+static bool replaceDiff(
+                        db::Translator *translator,
+                        db::Token token,
+                        db::Token *command,
+                        size_t *countOfValues
+                       );
+
+/// Check that values for statement may be calculated before it
+static bool isHoistable(const db::Token statement);
+
+static bool declareValue(db::Token *command, char *name, db::Token value);
+
+static bool simplyNode(Worklist *worklist, db::Token token);
+
+static bool matchOperand(Operand operand, const db::Token token);
+
+static bool matchRule(const SimplifyRule *rule, const db::Token token);
+
+static bool applyRule(Worklist *worklist, const SimplifyRule *rule, db::Token token);
+
+static bool replaceByChild(Worklist *worklist, db::Token token, db::Token child);
+
+static bool detachToken(Worklist *worklist, db::Token token);
+
+static void markDetached(db::Token token);
+
+void db::simplyGrammar(db::Translator *translator, int *error)
 {
-  return db::createNode({.number = value}, db::type_t::NUMBER);
+  if (!translator || !translator->grammar.root) ERROR();
+
+  Worklist worklist{};
+
+  db::Token command = nullptr;
+  size_t countOfValues = 0;
+
+  bool isOk =
+    expandDiffs(translator, translator->grammar.root, &command, &countOfValues) &&
+    fillWorklist(&worklist, translator->grammar.root, nullptr);
+
+  while (isOk && worklist.size)
+    {
+      db::Token token = worklist.nodes[--worklist.size];
+
+      if (token->parent == &DETACHED_NODE) continue;
+
+      isOk = simplyNode(&worklist, token);
+    }
+
+  for (size_t i = 0; i < worklist.garbageSize; ++i)
+    db::removeNode(worklist.garbage[i]);
+
+  free(worklist.nodes);
+  free(worklist.garbage);
+
+  if (!isOk) ERROR();
+
+  FILE *log = getLogFile();
+  if (!log) return;
+
+  fprintf(log, "<pre>Simplifier rules:\n");
+  for (size_t i = 0; i < RULES_COUNT; ++i)
+    if (worklist.hits[i])
+      fprintf(log, "  %-8s %zu\n", RULES[i].name, worklist.hits[i]);
+  fprintf(log, "</pre>\n");
 }
 
-static db::Token diff(db::Token token);
+static bool pushToken(db::Token **array, size_t *size, size_t *capacity, db::Token token)
+{
+  assert(array);
+  assert(size);
+  assert(capacity);
 
-void simplyToken(db::Token token, int *error);
+  if (*size == *capacity)
+    {
+      *capacity = GROWTH_FACTOR*(*capacity) + 1;
+      db::Token *temp = (db::Token *)recalloc(*array, *capacity, sizeof(db::Token));
+      if (!temp) return false;
 
-bool isConst(const db::Token token);
+      *array = temp;
+    }
 
-void db::simplyGrammar(db::Translator *translator, int *error)
+  (*array)[(*size)++] = token;
+
+  return true;
+}
+
+static bool fillWorklist(Worklist *worklist, db::Token token, db::Token parent)
 {
-  if (!translator || !translator->grammar.root) ERROR();
+  assert(worklist);
+
+  for ( ; token; parent = token, token = token->right)
+    {
+      token->parent = parent;
+
+      if (!pushToken(&worklist->nodes, &worklist->size, &worklist->capacity, token))
+        return false;
+
+      if (!fillWorklist(worklist, token->left, token)) return false;
+    }
+
+  return true;
+}
+
+static bool expandDiffs(
+                        db::Translator *translator,
+                        db::Token token,
+                        db::Token *command,
+                        size_t *countOfValues
+                       )
+{
+  assert(translator);
+  assert(command);
+  assert(countOfValues);
+
+  for ( ; token; token = token->right)
+    {
+      if (IS_DIFF(token)) return replaceDiff(translator, token, command, countOfValues);
+
+      db::Token  none = nullptr;
+      db::Token *leftCommand = command;
+
+      if (IS_COMP(token))
+        leftCommand = &token;
+      else if (IS_FUN(token) || IS_WHILE(token))
+        leftCommand = &none;
+
+      if (!expandDiffs(translator, token->left, leftCommand, countOfValues)) return false;
+    }
+
+  return true;
+}
+
+static bool replaceDiff(
+                        db::Translator *translator,
+                        db::Token token,
+                        db::Token *command,
+                        size_t *countOfValues
+                       )
+{
+  assert(translator);
+  assert(token);
+  assert(command);
+  assert(countOfValues);
+
+  db::ExpressionDag dag{};
+  db::initExpressionDag(&dag);
 
   int errorCode = 0;
-  simplyToken(translator->grammar.root, &errorCode);
-  if (errorCode) ERROR();
+  size_t node = db::addExpression(&dag, token, &errorCode);
+
+  bool isOk = !errorCode;
+
+  size_t *references = nullptr;
+  char  **names      = nullptr;
+  size_t  values     = 0;
+
+  if (isOk && *command && isHoistable((*command)->left))
+    {
+      references = (size_t *)calloc(dag.size, sizeof(size_t));
+      names      = (char  **)calloc(dag.size, sizeof(char *));
+
+      isOk = references && names;
+      if (isOk) db::countReferences(&dag, node, references);
+
+      for (size_t i = 0; i < dag.size && isOk; ++i)
+        {
+          if (references[i] < 2 || dag.nodes[i].type != db::type_t::STATEMENT) continue;
+
+          char name[db::MAX_NAME_SIZE] = "";
+          sprintf(name, "$diff_%zu", (*countOfValues)++);
+
+          names[i] = db::addString(&translator->stringPool, name);
+
+          db::Token value = (names[i] ? db::createTree(&dag, i, names) : nullptr);
 
+          isOk = value && declareValue(command, names[i], value);
+          ++values;
+        }
+    }
+
+  db::Token derivative = (isOk ? db::createTree(&dag, node, names, &errorCode) : nullptr);
+
+  FILE *log = getLogFile();
+  if (log && derivative)
+    fprintf(log, "<pre>Derivative: %zu DAG nodes, %zu values, %zu tree nodes</pre>\n",
+            dag.size, values, db::countNodes(derivative));
+
+  free(references);
+  free(names);
+  db::destroyExpressionDag(&dag);
+
+  if (!derivative) return false;
+
+  db::removeNode(token->left);
+
+  token->type  = derivative->type;
+  token->value = derivative->value;
+
+  db::setChildren(token, derivative->left, derivative->right);
+  free(derivative);
+
+  return true;
 }
 
-bool isConst(const db::Token token)
+static bool isHoistable(const db::Token statement)
 {
+  assert(statement);
+
+  if (IS_ASSIGN(statement) || IS_VAR(statement) || IS_VAL(statement))
+    return db::isPureNode(statement->right);
+
+  if (IS_IF(statement) || IS_OUT(statement) || IS_RETURN(statement))
+    return db::isPureNode(statement->left);
+
+  return false;
+}
+
+static bool declareValue(db::Token *command, char *name, db::Token value)
+{
+  assert(command);
+  assert(*command);
+  assert(name);
+  assert(value);
+
+  db::Token variable = db::createNode({.name = name}, db::type_t::NAME);
+  db::Token declaration = (variable ? CREATE_STATEMENT(VAL, variable, value) : nullptr);
+  db::Token next = (declaration ? CREATE_STATEMENT(COMPOUND, (*command)->left, (*command)->right) : nullptr);
+
+  if (!next)
+    {
+      if (declaration) db::removeNode(declaration);
+      else
+        {
+          if (variable) db::removeNode(variable);
+          db::removeNode(value);
+        }
+
+      return false;
+    }
+
+  db::setChildren(*command, declaration, next);
+  *command = next;
+
+  return true;
+}
+
+static bool simplyNode(Worklist *worklist, db::Token token)
+{
+  assert(worklist);
   assert(token);
 
-  if (token->left  && !isConst(token->left )) return false;
-  if (token->right && !isConst(token->right)) return false;
+  bool isChanged = false;
+
+  for (size_t i = 0; i < RULES_COUNT; ++i)
+    {
+      if (!matchRule(RULES + i, token)) continue;
 
-  if (!token->left  &&
-      !token->right &&
-      IS_NUM(token)) return true;
+      if (!applyRule(worklist, RULES + i, token)) return false;
+
+      ++worklist->hits[i];
+      isChanged = true;
+
+      i = (size_t)-1;
+    }
+
+  if (isChanged && token->parent)
+    return pushToken(&worklist->nodes, &worklist->size, &worklist->capacity, token->parent);
 
   return true;
 }
 
-void simplyToken(db::Token token, int *error)
+static bool matchOperand(Operand operand, const db::Token token)
+{
+  switch (operand)
+    {
+    case Operand::Any:      return token;
+    case Operand::Pure:     return token && db::isPureNode(token);
+    case Operand::Zero:     return token && IS_NUM(token) && db::compareNumber(NUMBER(token), 0);
+    case Operand::One:      return token && IS_NUM(token) && db::compareNumber(NUMBER(token), 1);
+    case Operand::Number:   return token && IS_NUM(token);
+    case Operand::Negation: return IS_SUB(token) && token->left && !token->right;
+    case Operand::None:     return !token;
+    default: return false;
+    }
+}
+
+static bool matchRule(const SimplifyRule *rule, const db::Token token)
 {
-  if (!token || !error) ERROR();
+  assert(rule);
+  assert(token);
+
+  if (!IS_STATEMENT(token) || STATEMENT(token) != rule->statement) return false;
 
-  if (!IS_STATEMENT(token) &&
-      !(IS_NAME(token) && token->left)) return;
+  if (!matchOperand(rule->left , token->left ) ||
+      !matchOperand(rule->right, token->right)) return false;
 
-  switch (STATEMENT(token))
+  if (rule->isSame && !db::isSameNode(token->left, token->right)) return false;
+
+  if (rule->result == Result::Fold)
     {
+      db::number_t result = 0;
+      return db::calculateStatement(
+                                    rule->statement,
+                                    NUMBER(token->left),
+                                    token->right ? &NUMBER(token->right) : nullptr,
+                                    &result
+                                   );
+    }
+
+  return true;
+}
 
-    case db::STATEMENT_ADD: SIMPLY_LINARY(ADD , +    ); break;
-    case db::STATEMENT_SUB: SIMPLY_LINARY(SUB , -    ); break;
-    case db::STATEMENT_MUL: SIMPLY_BINARY(MUL , *    ); break;
-    case db::STATEMENT_DIV: SIMPLY_BINARY(DIV , /    ); break;
-    case db::STATEMENT_SIN:  SIMPLY_UNARY(SIN , sin  ); break;
-    case db::STATEMENT_COS:  SIMPLY_UNARY(COS , cos  ); break;
-    case db::STATEMENT_TAN:  SIMPLY_UNARY(TAN , tan  ); break;
-    case db::STATEMENT_INT:  SIMPLY_UNARY(INT , (int)); break;
-    case db::STATEMENT_SQRT: SIMPLY_UNARY(SQRT, sqrt ); break;
-    case db::STATEMENT_DIFF: diff(token); break;
-    default:
+static bool applyRule(Worklist *worklist, const SimplifyRule *rule, db::Token token)
+{
+  assert(worklist);
+  assert(rule);
+  assert(token);
+
+  switch (rule->result)
+    {
+    case Result::KeepLeft:  return replaceByChild(worklist, token, token->left );
+    case Result::KeepRight: return replaceByChild(worklist, token, token->right);
+    case Result::KeepOperand:
       {
-        if (token->left ) simplyToken(token->left , error);
-        if (*error) ERROR();
-        if (token->right) simplyToken(token->right, error);
-        if (*error) ERROR();
-        break;
+        db::Token negation = token->left;
+
+        if (!replaceByChild(worklist, token, negation)) return false;
+
+        return replaceByChild(worklist, token, token->left);
+      }
+    case Result::Zero:
+    case Result::Fold:
+      {
+        db::number_t result = 0;
+        if (rule->result == Result::Fold)
+          db::calculateStatement(
+                                 rule->statement,
+                                 NUMBER(token->left),
+                                 token->right ? &NUMBER(token->right) : nullptr,
+                                 &result
+                                );
+
+        if (!detachToken(worklist, token->left ) ||
+            !detachToken(worklist, token->right)) return false;
+
+        token->type = db::type_t::NUMBER;
+        NUMBER(token) = result;
+        token->left = token->right = nullptr;
+
+        return true;
       }
+    case Result::NegateRight:
+      {
+        if (!detachToken(worklist, token->left)) return false;
+
+        token->left  = token->right;
+        token->right = nullptr;
+
+        return true;
+      }
+    default: return false;
     }
 }
 
-static db::Token diff(db::Token token)
+bool db::calculateStatement(
+                            db::statement_t statement,
+                            db::number_t left,
+                            const db::number_t *right,
+                            db::number_t *result
+                           )
 {
-  assert(token);
+  assert(result);
+
+  if (!right)
+    switch (statement)
+      {
+      case db::STATEMENT_ADD: *result =  left; return true;
+      case db::STATEMENT_SUB: *result = -left; return true;
+      case db::STATEMENT_SIN:
+      case db::STATEMENT_COS:
+      case db::STATEMENT_TAN:
+      case db::STATEMENT_SQRT:
+      case db::STATEMENT_INT:
+        break;
+      default: return false;
+      }
+
+  db::number_t other = (right ? *right : 0);
 
-  switch (token->type)
+  switch (statement)
     {
-    case db::type_t::NUMBER:
+    case db::STATEMENT_ADD: *result = left + other; return true;
+    case db::STATEMENT_SUB: *result = left - other; return true;
+    case db::STATEMENT_MUL: *result = left * other; return true;
+    case db::STATEMENT_DIV:
       {
-        NUMBER(token) = 0;
-        return token;
+        if (db::compareNumber(other, 0)) return false;
+
+        *result = left / other;
+        return true;
       }
-    case db::type_t::NAME:
+    case db::STATEMENT_SIN: *result = sin(left); return true;
+    case db::STATEMENT_COS: *result = cos(left); return true;
+    case db::STATEMENT_TAN: *result = tan(left); return true;
+    case db::STATEMENT_SQRT:
       {
-        if (token->left)
-          return token;
-        NUMBER(token) = 1;
-        return token;
+        if (left < 0) return false;
+
+        *result = sqrt(left);
+        return true;
       }
-    case db::type_t::STATEMENT:
-      switch (STATEMENT(token))
-        {
-        case db::STATEMENT_ADD:
-        case db::STATEMENT_SUB:
-          {
-            if (token->left )
-              diff(token->left );
-            if (token->right)
-              diff(token->right);
-            return token;
-          }
-        case db::STATEMENT_MUL:
-          {
-            STATEMENT(token) = db::STATEMENT_ADD;
-
-            token->left  = MUL(dLeft , Left );
-            token->right = MUL(dRight, Right);
-
-            return token;
-          }
-        case db::STATEMENT_DIV:
-          {
-            token->left  = SUB(
-                               MUL(dLeft, Right),
-                               MUL(Left, dRight));
-            token->right = MUL(copyRight, copyRight);
-
-            return token;
-          }
-        case db::STATEMENT_SIN:
-          {
-            STATEMENT(token) = db::STATEMENT_MUL;
-
-            token->left  = COS(Left);
-            token->right = dLeft;
-
-            return token;
-          }
-        case db::STATEMENT_COS:
-          {
-            STATEMENT(token) = db::STATEMENT_MUL;
-
-            token->left  = NUM(-1);
-            token->right = MUL(SIN(Right), dRight);
-
-            return token;
-          }
-        case db::STATEMENT_SQRT:
-          //          return DIV(dRight, MUL(NUM(2), SQRT(CopyRight)));
-        default: return nullptr;
-        }
-    default: return nullptr;
+    case db::STATEMENT_INT: *result = (int)left; return true;
+    case db::STATEMENT_POW:
+      {
+        if (left < 0 && !db::compareNumber(other, (int)other)) return false;
+
+        *result = pow(left, other);
+        return true;
+      }
+
+    case db::STATEMENT_LESS:      *result = (left < other ? 1 : 0); return true;
+    case db::STATEMENT_GREATER:   *result = (left > other ? 1 : 0); return true;
+    case db::STATEMENT_EQUAL:     *result = ( db::compareNumber(left, other) ? 1 : 0); return true;
+    case db::STATEMENT_NOT_EQUAL: *result = (!db::compareNumber(left, other) ? 1 : 0); return true;
+    case db::STATEMENT_AND:
+      *result = (!db::compareNumber(left, 0) && !db::compareNumber(other, 0) ? 1 : 0);
+      return true;
+    case db::STATEMENT_OR:
+      *result = (!db::compareNumber(left, 0) || !db::compareNumber(other, 0) ? 1 : 0);
+      return true;
+    default: return false;
+    }
+}
+
+static bool replaceByChild(Worklist *worklist, db::Token token, db::Token child)
+{
+  assert(worklist);
+  assert(token);
+  assert(child);
+
+  db::Token other = (child == token->left ? token->right : token->left);
+  if (!detachToken(worklist, other)) return false;
+
+  token->type     = child->type;
+  token->value    = child->value;
+  token->position = child->position;
+
+  db::setChildren(token, child->left, child->right);
+
+  child->left = child->right = nullptr;
+
+  return detachToken(worklist, child);
+}
+
+static bool detachToken(Worklist *worklist, db::Token token)
+{
+  assert(worklist);
+
+  if (!token) return true;
+
+  markDetached(token);
+
+  return pushToken(&worklist->garbage, &worklist->garbageSize, &worklist->garbageCapacity, token);
+}
+
+static void markDetached(db::Token token)
+{
+  for ( ; token; token = token->right)
+    {
+      token->parent = &DETACHED_NODE;
+      markDetached(token->left);
     }
 }
@@ -0,0 +1,284 @@
+#include "StackIr.h"
+
+#include <stdio.h>
+#include <malloc.h>
+#include "StringPool.h"
+#include "SystemLike.h"
+#include "Assert.h"
+#include "Error.h"
+
+#pragma GCC diagnostic ignored "-Wswitch-enum"
+
+const int GROWTH_FACTOR = 2;
+
+static const char *const OPCODE_NAMES[] = {
+  "PUSH",
+  "POP",
+  "ADD",
+  "SUB",
+  "MUL",
+  "DIV",
+  "POW",
+  "SIN",
+  "COS",
+  "TAN",
+  "SQRT",
+  "AND",
+  "OR",
+  "NEQL",
+  "EQL",
+  "LESS",
+  "GREATER",
+  "SWAP",
+  "JMP",
+  "JE",
+  "JNE",
+  "JB",
+  "JA",
+  "JBE",
+  "JAE",
+  "CALL",
+  "RET",
+  "IN",
+  "OUT",
+  "SHOW",
+  "HLT",
+  "",
+  "",
+};
+
+static const char *const REGISTER_NAMES[] = {
+  "",
+  "rax",
+  "rbx",
+  "rcx",
+  "rdx",
+  "rex",
+  "rfx",
+};
+
+/// Assembler takes target of conditional jump after :
+static bool isConditionalJump(db::Opcode opcode);
+
+static void printLabel(const db::IrOperand *operand, FILE *target);
+
+void db::initIr(db::IrCode *code, int *error)
+{
+  if (!code) ERROR();
+
+  code->instructions = nullptr;
+  code->size         = 0;
+  code->capacity     = 0;
+  code->isFailed     = false;
+}
+
+void db::destroyIr(db::IrCode *code, int *error)
+{
+  if (!code) ERROR();
+
+  free(code->instructions);
+
+  code->instructions = nullptr;
+  code->size = code->capacity = 0;
+}
+
+bool db::emitIr(
+                db::IrCode *code,
+                db::Opcode opcode,
+                db::IrOperand operand,
+                const char *comment,
+                int *error
+               )
+{
+  if (!code) ERROR(false);
+
+  if (code->size == code->capacity)
+    {
+      code->capacity = GROWTH_FACTOR*code->capacity + 1;
+      db::IrInstruction *temp =
+        (db::IrInstruction *)recalloc(code->instructions, code->capacity, sizeof(db::IrInstruction));
+      if (!temp)
+        {
+          code->isFailed = true;
+          ERROR(false);
+        }
+
+      code->instructions = temp;
+    }
+
+  code->instructions[code->size++] =
+    { .opcode = opcode, .operand = operand, .comment = comment };
+
+  return true;
+}
+
+db::IrOperand db::immediateOperand(int value)
+{
+  return { .type = db::OperandType::Immediate, .value = value };
+}
+
+db::IrOperand db::registerOperand(db::Register reg)
+{
+  return { .type = db::OperandType::Register, .base = reg };
+}
+
+db::IrOperand db::memoryOperand(int address, db::Register base)
+{
+  return { .type = db::OperandType::Memory, .value = address, .base = base };
+}
+
+db::IrOperand db::labelOperand(const char *prefix, const char *name, int number)
+{
+  return { .type = db::OperandType::Label, .value = number, .prefix = prefix, .name = name };
+}
+
+bool db::isSameOperand(const db::IrOperand *first, const db::IrOperand *second)
+{
+  assert(first);
+  assert(second);
+
+  if (first->type != second->type) return false;
+
+  switch (first->type)
+    {
+    case db::OperandType::None:      return true;
+    case db::OperandType::Immediate: return first->value == second->value;
+    case db::OperandType::Register:  return first->base  == second->base;
+    case db::OperandType::Memory:
+      return first->value == second->value && first->base == second->base;
+    case db::OperandType::Label:
+      return first->value == second->value &&
+             db::compareStrings(first->prefix, second->prefix) &&
+             db::compareStrings(first->name  , second->name  );
+    default: return false;
+    }
+}
+
+const char *db::getOpcodeName(db::Opcode opcode)
+{
+  return OPCODE_NAMES[(int)opcode];
+}
+
+const char *db::getRegisterName(db::Register reg)
+{
+  return REGISTER_NAMES[(int)reg];
+}
+
+void db::appendIr(db::IrCode *code, const db::IrCode *source, int *error)
+{
+  if (!code || !source) ERROR();
+
+  for (size_t i = 0; i < source->size; ++i)
+    {
+      const db::IrInstruction *instruction = source->instructions + i;
+
+      if (!db::emitIr(code, instruction->opcode, instruction->operand, instruction->comment))
+        ERROR();
+    }
+}
+
+void db::printIr(const db::IrCode *code, FILE *target, int *error)
+{
+  if (!code || !target) ERROR();
+
+  for (size_t i = 0; i < code->size; ++i)
+    db::printInstruction(code->instructions + i, target);
+}
+
+void db::printInstruction(const db::IrInstruction *instruction, FILE *target, int *error)
+{
+  if (!instruction || !target) ERROR();
+
+  if (instruction->opcode == db::Opcode::COMMENT)
+    {
+      fprintf(target, ";%s", instruction->comment);
+
+      if (instruction->operand.type != db::OperandType::None)
+        {
+          fprintf(target, " ");
+          db::printOperand(&instruction->operand, target);
+        }
+
+      fprintf(target, "\n");
+
+      // Translation of statement ends by ;End
+      if (db::compareStrings(instruction->comment, "End")) fprintf(target, "\n");
+
+      return;
+    }
+
+  if (instruction->opcode == db::Opcode::LABEL)
+    {
+      printLabel(&instruction->operand, target);
+      fprintf(target, ":\n");
+
+      return;
+    }
+
+  fprintf(target, "%s", db::getOpcodeName(instruction->opcode));
+
+  if (instruction->operand.type != db::OperandType::None)
+    {
+      fprintf(target, " ");
+
+      if (isConditionalJump(instruction->opcode)) fprintf(target, ":");
+
+      db::printOperand(&instruction->operand, target);
+    }
+
+  if (instruction->comment) fprintf(target, "; %s", instruction->comment);
+
+  fprintf(target, "\n");
+}
+
+void db::printOperand(const db::IrOperand *operand, FILE *target, int *error)
+{
+  if (!operand || !target) ERROR();
+
+  switch (operand->type)
+    {
+    case db::OperandType::None: break;
+    case db::OperandType::Immediate:
+      fprintf(target, "%d", operand->value);
+      break;
+    case db::OperandType::Register:
+      fprintf(target, "%s", db::getRegisterName(operand->base));
+      break;
+    case db::OperandType::Memory:
+      if (operand->base == db::Register::NONE)
+        fprintf(target, "[%d]", operand->value);
+      else
+        fprintf(target, "[%d+%s]", operand->value, db::getRegisterName(operand->base));
+      break;
+    case db::OperandType::Label:
+      printLabel(operand, target);
+      break;
+    default: ERROR();
+    }
+}
+
+static bool isConditionalJump(db::Opcode opcode)
+{
+  switch (opcode)
+    {
+    case db::Opcode::JE:
+    case db::Opcode::JNE:
+    case db::Opcode::JB:
+    case db::Opcode::JA:
+    case db::Opcode::JBE:
+    case db::Opcode::JAE:
+      return true;
+    default:
+      return false;
+    }
+}
+
+static void printLabel(const db::IrOperand *operand, FILE *target)
+{
+  assert(operand);
+  assert(target);
+
+  fprintf(target, "%s_%s", operand->prefix, operand->name);
+
+  if (operand->value != db::NO_LABEL_NUMBER) fprintf(target, "_%6.6d", operand->value);
+}
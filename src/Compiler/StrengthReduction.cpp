@@ -0,0 +1,362 @@
+#include "Translator.h"
+
+#include <stdio.h>
+#include <math.h>
+#include "DSL.h"
+#include "Assert.h"
+#include "Logging.h"
+#include "Error.h"
+
+#pragma GCC diagnostic ignored "-Wswitch-enum"
+
+/// Estimated cycles of VM for PUSH or POP of number, it moves fractional and integer words
+const size_t LOAD_COST  = 2;
+const size_t STORE_COST = 2;
+
+/// Numbers of VM are fixed point with this count of fractional units
+const double FRACTION_SCALE = 10000;
+
+struct ReductionState {
+  db::Translator *translator;
+
+  size_t powers;
+  size_t doublings;
+  size_t divisions;
+  size_t saved; ///< Estimated cycles of one execution of all reduced expressions
+  size_t countOfValues;
+};
+
+static bool reduceInBlock(ReductionState *state, db::Token block);
+
+/// @param [in, out] command Command with statement, it is moved by declarations of values
+static bool reduceInStatement(ReductionState *state, db::Token *command);
+
+/// @param [in, out] command Command whose statement contains expression,
+/// nullptr if values can`t be declared before it
+static bool reduceExpression(ReductionState *state, db::Token token, db::Token *command);
+
+/// x^2 -> x*x, x^3 -> x*x*x, complex base is declared as value before command
+static bool expandPower(ReductionState *state, db::Token token, db::Token *command);
+
+/// x*2 -> x+x
+static void replaceDoubling(ReductionState *state, db::Token token);
+
+/// x/c -> x*(1/c), if 1/c is exact both in double and in fixed point of VM
+static void replaceDivision(ReductionState *state, db::Token token);
+
+/// Cycles of VM for operator with evaluated operands
+static size_t getOperatorCost(db::statement_t statement);
+
+/// Cycles of VM for evaluation of expression
+static size_t getCost(const db::Token token);
+
+/// Check that values for statement may be calculated before it
+static bool isHoistable(const db::Token statement);
+
+static bool isInteger(const db::Token token, int value);
+
+static bool declareValue(db::Token *command, char *name, db::Token value);
+
+static char *createName(ReductionState *state);
+
+void db::reduceStrength(db::Translator *translator, int *error)
+{
+  if (!translator || !translator->grammar.root) ERROR();
+
+  ReductionState state{};
+  state.translator = translator;
+
+  bool isOk = true;
+
+  for (db::Token token = translator->grammar.root; token && isOk; token = token->right)
+    {
+      db::Token declaration = token->left;
+
+      if (IS_FUN(declaration))
+        isOk = reduceInBlock(&state, declaration->right);
+      else if (IS_VAR(declaration) || IS_VAL(declaration))
+        isOk = reduceExpression(&state, declaration->right, nullptr);
+    }
+
+  if (!isOk) ERROR();
+
+  FILE *log = getLogFile();
+  if (!log) return;
+
+  fprintf(log, "<pre>Strength reduction: %zu powers, %zu doublings, %zu divisions, "
+          "%zu cycles saved</pre>\n",
+          state.powers, state.doublings, state.divisions, state.saved);
+}
+
+static bool reduceInBlock(ReductionState *state, db::Token block)
+{
+  assert(state);
+
+  for (db::Token command = block; command; command = command->right)
+    if (!reduceInStatement(state, &command)) return false;
+
+  return true;
+}
+
+static bool reduceInStatement(ReductionState *state, db::Token *command)
+{
+  assert(state);
+  assert(command);
+
+  db::Token statement = (*command)->left;
+  if (!statement) return true;
+
+  db::Token *values = (isHoistable(statement) ? command : nullptr);
+
+  if (IS_ASSIGN(statement) || IS_VAR(statement) || IS_VAL(statement))
+    return reduceExpression(state, statement->right, values);
+
+  if (IS_IF(statement))
+    {
+      if (!reduceExpression(state, statement->left, values)) return false;
+
+      if (IS_ELSE(statement->right))
+        return reduceInBlock(state, statement->right->left) &&
+               reduceInBlock(state, statement->right->right);
+
+      return reduceInBlock(state, statement->right);
+    }
+
+  // Condition is evaluated on every iteration
+  if (IS_WHILE(statement))
+    return reduceExpression(state, statement->left, nullptr) &&
+           reduceInBlock(state, statement->right);
+
+  if (IS_COMP(statement)) return reduceInBlock(state, statement);
+
+  if (IS_IN(statement)) return true;
+
+  return reduceExpression(state, statement, values);
+}
+
+static bool reduceExpression(ReductionState *state, db::Token token, db::Token *command)
+{
+  assert(state);
+
+  if (!token) return true;
+
+  if (!reduceExpression(state, token->left , command) ||
+      !reduceExpression(state, token->right, command))
+    return false;
+
+  if (IS_POW(token)) return expandPower(state, token, command);
+
+  if (IS_MUL(token)) replaceDoubling(state, token);
+  else if (IS_DIV(token)) replaceDivision(state, token);
+
+  return true;
+}
+
+static bool expandPower(ReductionState *state, db::Token token, db::Token *command)
+{
+  assert(state);
+  assert(token);
+
+  int power = (isInteger(token->right, 2) ? 2 : isInteger(token->right, 3) ? 3 : 0);
+  if (!power || !token->left) return true;
+
+  db::Token base = token->left;
+
+  bool isSimple = IS_NAME(base) || IS_NUM(base);
+  if (!isSimple && (!command || !db::isPureNode(base))) return true;
+
+  size_t cost   = getCost(token);
+  size_t reduced =
+    (size_t)power*LOAD_COST + (size_t)(power - 1)*getOperatorCost(db::STATEMENT_MUL) +
+    (isSimple ? 0 : getCost(base) + STORE_COST);
+
+  if (reduced >= cost) return true;
+
+  db::Token operand = base;
+
+  if (!isSimple)
+    {
+      char *name = createName(state);
+      operand = (name ? db::createNode({.name = name}, db::type_t::NAME) : nullptr);
+      if (!operand) return false;
+
+      token->left = nullptr;
+      if (!declareValue(command, name, base))
+        {
+          db::removeNode(operand);
+          return false;
+        }
+    }
+
+  db::Token second = db::createNode(operand);
+  db::Token third  = (power == 3 && second ? db::createNode(operand) : nullptr);
+  db::Token square = (second ? CREATE_STATEMENT(MUL, operand, second) : nullptr);
+
+  if (!square || (power == 3 && !third))
+    {
+      if (square) db::removeNode(square);
+      else if (second) db::removeNode(second);
+
+      if (third) db::removeNode(third);
+      if (!square && operand != base) db::removeNode(operand);
+
+      return false;
+    }
+
+  db::removeNode(token->right);
+  token->left = token->right = nullptr;
+
+  if (power == 2)
+    {
+      STATEMENT(token) = db::STATEMENT_MUL;
+      db::setChildren(token, square->left, square->right);
+
+      square->left = square->right = nullptr;
+      db::removeNode(square);
+    }
+  else
+    {
+      STATEMENT(token) = db::STATEMENT_MUL;
+      db::setChildren(token, square, third);
+    }
+
+  ++state->powers;
+  state->saved += cost - reduced;
+
+  return true;
+}
+
+static void replaceDoubling(ReductionState *state, db::Token token)
+{
+  assert(state);
+  assert(token);
+
+  if (getOperatorCost(db::STATEMENT_ADD) >= getOperatorCost(db::STATEMENT_MUL)) return;
+
+  db::Token two = (isInteger(token->right, 2) ? token->right :
+                   isInteger(token->left , 2) ? token->left  : nullptr);
+  if (!two) return;
+
+  db::Token operand = (two == token->right ? token->left : token->right);
+  if (!operand || !IS_NAME(operand)) return;
+
+  // Number is reused as the second load of name
+  two->type  = db::type_t::NAME;
+  two->value = {.name = NAME(operand)};
+
+  STATEMENT(token) = db::STATEMENT_ADD;
+
+  ++state->doublings;
+  state->saved += getOperatorCost(db::STATEMENT_MUL) - getOperatorCost(db::STATEMENT_ADD);
+}
+
+static void replaceDivision(ReductionState *state, db::Token token)
+{
+  assert(state);
+  assert(token);
+
+  if (getOperatorCost(db::STATEMENT_MUL) >= getOperatorCost(db::STATEMENT_DIV)) return;
+
+  if (!token->right || !IS_NUM(token->right) || db::compareNumber(NUMBER(token->right), 0))
+    return;
+
+  db::number_t reciprocal = 1/NUMBER(token->right);
+
+  int exponent = 0;
+  db::number_t mantissa = frexp(reciprocal, &exponent);
+  db::number_t scaled   = reciprocal*FRACTION_SCALE;
+
+  // Power of two is exact in double, fixed point keeps it if it has no more fractional digits
+  if (!db::compareNumber(fabs(mantissa), 0.5) || !db::compareNumber(scaled, floor(scaled))) return;
+
+  NUMBER(token->right) = reciprocal;
+  STATEMENT(token)     = db::STATEMENT_MUL;
+
+  ++state->divisions;
+  state->saved += getOperatorCost(db::STATEMENT_DIV) - getOperatorCost(db::STATEMENT_MUL);
+}
+
+static size_t getOperatorCost(db::statement_t statement)
+{
+  switch (statement)
+    {
+    case db::STATEMENT_ADD:
+    case db::STATEMENT_SUB:  return 2;
+    case db::STATEMENT_MUL:  return 6;
+    case db::STATEMENT_DIV:  return 12;
+    case db::STATEMENT_POW:  return 40;
+    case db::STATEMENT_SIN:
+    case db::STATEMENT_COS:
+    case db::STATEMENT_TAN:
+    case db::STATEMENT_SQRT: return 40;
+    default:                 return 2;
+    }
+}
+
+static size_t getCost(const db::Token token)
+{
+  if (!token) return 0;
+
+  if (IS_NUM(token) || IS_NAME(token)) return LOAD_COST;
+
+  if (!IS_STATEMENT(token)) return 0;
+
+  return getCost(token->left) + getCost(token->right) + getOperatorCost(STATEMENT(token));
+}
+
+static bool isHoistable(const db::Token statement)
+{
+  assert(statement);
+
+  if (IS_ASSIGN(statement) || IS_VAR(statement) || IS_VAL(statement))
+    return db::isPureNode(statement->right);
+
+  if (IS_IF(statement) || IS_OUT(statement) || IS_RETURN(statement))
+    return db::isPureNode(statement->left);
+
+  return false;
+}
+
+static bool isInteger(const db::Token token, int value)
+{
+  return token && IS_NUM(token) && db::compareNumber(NUMBER(token), value);
+}
+
+static bool declareValue(db::Token *command, char *name, db::Token value)
+{
+  assert(command);
+  assert(*command);
+  assert(name);
+  assert(value);
+
+  db::Token variable = db::createNode({.name = name}, db::type_t::NAME);
+  db::Token declaration = (variable ? CREATE_STATEMENT(VAL, variable, value) : nullptr);
+  db::Token next = (declaration ? CREATE_STATEMENT(COMPOUND, (*command)->left, (*command)->right) : nullptr);
+
+  if (!next)
+    {
+      if (declaration) db::removeNode(declaration);
+      else
+        {
+          if (variable) db::removeNode(variable);
+          db::removeNode(value);
+        }
+
+      return false;
+    }
+
+  db::setChildren(*command, declaration, next);
+  *command = next;
+
+  return true;
+}
+
+static char *createName(ReductionState *state)
+{
+  assert(state);
+
+  char name[db::MAX_NAME_SIZE] = "";
+  sprintf(name, "$pow_%zu", state->countOfValues++);
+
+  return db::addString(&state->translator->stringPool, name);
+}
@@ -131,14 +131,14 @@ static void showSourceLine(db::Translator *translator, db::PositionInfo info)
   if (!source) return;
 
   for (int i = 1; i < info.line; ++i) { fscanf(source, "%*[^\n]"); getc(source); };
-  printf("%4.4d | ", info.line);
+  fprintf(stderr, "%4.4d | ", info.line);
 
-  for (int i = 1; i < info.position; ++i) putchar(getc(source));
+  for (int i = 1; i < info.position; ++i) putc(getc(source), stderr);
 
-  printf(FG_YELLOW);
-  for (int ch = '\0'; ch != '\n' && ch != EOF; ) putchar(ch = getc(source));
+  fprintf(stderr, FG_YELLOW);
+  for (int ch = '\0'; ch != '\n' && ch != EOF; ) putc(ch = getc(source), stderr);
 
-  printf(RESET);
+  fprintf(stderr, RESET);
 
   fclose(source);
 
@@ -0,0 +1,874 @@
+#include "SyntaxBinary.h"
+
+#include <malloc.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include "SystemLike.h"
+#include "ErrorHandler.h"
+#include "Error.h"
+#include "Assert.h"
+
+/// Layout of stream:
+///   MAGIC, VERSION, flags and payload or blocks of payload if PACKED_FLAG is set
+///
+/// Payload:
+///   varint count of strings, then strings sorted and front-coded:
+///     varint length of common prefix with previous string, varint length of suffix, suffix
+///   varint count of nodes
+///   nodes in preorder, every node is varint tag with value after it:
+///     tag = kind << 2 | hasLeft << 1 | hasRight, kind is NodeKind or KIND_STATEMENT + statement
+///
+/// Block:
+///   varint size of raw data (zero is end of stream)
+///   varint size of packed data (zero if block is stored raw), data
+///   Packed data is sequence of LZ77 commands:
+///     varint length of literals, literals, varint length of match - MIN_MATCH, varint offset
+
+const unsigned char MAGIC[]     = {0x89, 'D', 'B', 'T'};
+const unsigned char VERSION     = 1;
+const unsigned char PACKED_FLAG = 0x01;
+
+const size_t BLOCK_SIZE = 1 << 16;
+const size_t MIN_MATCH  = 4;
+const size_t HASH_BITS  = 12;
+
+const int GROWTH_FACTOR = 2;
+
+const double MAX_EXACT_INTEGER = 9007199254740992.0;
+
+const size_t STATEMENTS_COUNT = db::STATEMENT_DIFF + 1;
+
+enum NodeKind {
+  KIND_INTEGER   = 0,
+  KIND_REAL      = 1,
+  KIND_NAME      = 2,
+  KIND_STRING    = 3,
+  KIND_STATEMENT = 4,
+};
+
+struct ByteBuffer {
+  unsigned char *data;
+  size_t size;
+  size_t capacity;
+};
+
+struct StringTable {
+  const char **strings;
+  size_t size;
+  size_t capacity;
+};
+
+struct ByteReader {
+  FILE *source;
+  bool isPacked;
+
+  unsigned char *block;
+  size_t size;
+  size_t position;
+
+  size_t bytes; ///< Count of bytes read from source
+};
+
+typedef int ReadFunction(ByteReader *reader);
+
+static bool writeByte  (ByteBuffer *buffer, unsigned char byte);
+static bool writeBytes (ByteBuffer *buffer, const void *data, size_t size);
+static bool writeVarint(ByteBuffer *buffer, unsigned long long value);
+
+/// Nodes are visited along chains of right children by loop and only left children by recursion,
+/// so long lists of statements don`t overflow stack
+static bool collectStrings(const db::TreeNode *node, StringTable *table);
+static size_t countChainNodes(const db::TreeNode *node);
+static size_t searchStringIndex(const StringTable *table, const char *string);
+static int compareStringPointers(const void *first, const void *second);
+
+static bool writeStrings(const StringTable *table, ByteBuffer *buffer);
+static bool writeNode (const db::TreeNode *node, const StringTable *table, ByteBuffer *buffer);
+static bool writeValue(const db::TreeNode *node, const StringTable *table, ByteBuffer *buffer);
+
+static bool packBlock(const unsigned char *source, size_t size, ByteBuffer *target);
+
+static ReadFunction readRawByte;
+static ReadFunction readByte;
+
+static bool readVarint(ByteReader *reader, ReadFunction *read, unsigned long long *value);
+static bool readMemoryVarint(const unsigned char *data, size_t size, size_t *position, unsigned long long *value);
+
+static bool loadBlock(ByteReader *reader);
+static bool unpackBlock(const unsigned char *source, size_t size, unsigned char *target, size_t targetSize);
+
+static char **readStrings(ByteReader *reader, db::StringPool *pool, size_t *count);
+/// @param [in, out] remaining Count of nodes from header, which aren`t read yet
+static db::TreeNode *readNode(
+                              ByteReader *reader,
+                              char *const *strings,
+                              size_t count,
+                              size_t *remaining,
+                              int *error
+                             );
+/// @param [out] tag Tag of node with flags of children
+/// @return Node without children or nullptr
+static db::TreeNode *readValue(
+                               ByteReader *reader,
+                               char *const *strings,
+                               size_t count,
+                               unsigned long long *tag
+                              );
+
+bool db::isBinaryTree(FILE *source)
+{
+  if (!source) return false;
+
+  int ch = getc(source);
+  if (ch == EOF) return false;
+
+  ungetc(ch, source);
+
+  return ch == MAGIC[0];
+}
+
+size_t db::saveBinaryTree(const db::TreeNode *root, FILE *target, bool isPacked, int *error)
+{
+  if (!root || !target) ERROR(0);
+
+  StringTable table{};
+  ByteBuffer payload{};
+
+  if (!collectStrings(root, &table)) { free(table.strings); ERROR(0); }
+
+  if (table.size)
+    qsort(table.strings, table.size, sizeof(const char *), compareStringPointers);
+
+  size_t unique = 0;
+  for (size_t i = 0; i < table.size; ++i)
+    if (!unique || strcmp(table.strings[unique - 1], table.strings[i]))
+      table.strings[unique++] = table.strings[i];
+  table.size = unique;
+
+  bool isOk =
+    writeStrings(&table, &payload)                     &&
+    writeVarint(&payload, countChainNodes(root))       &&
+    writeNode(root, &table, &payload);
+
+  free(table.strings);
+
+  if (!isOk) { free(payload.data); ERROR(0); }
+
+  size_t bytes = 0;
+
+  bytes += fwrite(MAGIC, sizeof(unsigned char), sizeof(MAGIC), target);
+  bytes += fwrite(&VERSION, sizeof(unsigned char), 1, target);
+
+  unsigned char flags = (isPacked ? PACKED_FLAG : 0);
+  bytes += fwrite(&flags, sizeof(unsigned char), 1, target);
+
+  if (!isPacked)
+    {
+      bytes += fwrite(payload.data, sizeof(unsigned char), payload.size, target);
+      free(payload.data);
+
+      return bytes;
+    }
+
+  ByteBuffer block{};
+  ByteBuffer header{};
+
+  for (size_t offset = 0; offset < payload.size && isOk; offset += BLOCK_SIZE)
+    {
+      size_t size = payload.size - offset;
+      if (size > BLOCK_SIZE) size = BLOCK_SIZE;
+
+      block.size = header.size = 0;
+
+      isOk = packBlock(payload.data + offset, size, &block) &&
+             writeVarint(&header, size);
+
+      bool isStored = (block.size >= size);
+
+      isOk = isOk && writeVarint(&header, isStored ? 0 : block.size);
+
+      bytes += fwrite(header.data, sizeof(unsigned char), header.size, target);
+
+      if (isStored)
+        bytes += fwrite(payload.data + offset, sizeof(unsigned char), size, target);
+      else
+        bytes += fwrite(block.data, sizeof(unsigned char), block.size, target);
+    }
+
+  unsigned char end = 0;
+  bytes += fwrite(&end, sizeof(unsigned char), 1, target);
+
+  free(block.data);
+  free(header.data);
+  free(payload.data);
+
+  if (!isOk) ERROR(0);
+
+  return bytes;
+}
+
+db::TreeNode *db::loadBinaryTree(FILE *source, db::StringPool *pool, size_t *bytes, int *error)
+{
+  if (!source || !pool) ERROR(nullptr);
+
+  ByteReader reader{};
+  reader.source = source;
+
+  for (size_t i = 0; i < sizeof(MAGIC); ++i)
+    if (readRawByte(&reader) != MAGIC[i])
+      {
+        handleError("Invalid binary tree: wrong magic");
+        ERROR(nullptr);
+      }
+
+  if (readRawByte(&reader) != VERSION)
+    {
+      handleError("Invalid binary tree: unsupported version");
+      ERROR(nullptr);
+    }
+
+  int flags = readRawByte(&reader);
+  if (flags == EOF) ERROR(nullptr);
+
+  reader.isPacked = (flags & PACKED_FLAG);
+
+  size_t count = 0;
+  char **strings = readStrings(&reader, pool, &count);
+
+  unsigned long long nodes = 0;
+  db::TreeNode *root = nullptr;
+
+  int errorCode = 0;
+  if (strings && readVarint(&reader, readByte, &nodes))
+    {
+      size_t remaining = (size_t)nodes;
+      root = readNode(&reader, strings, count, &remaining, &errorCode);
+
+      if (root && remaining)
+        {
+          handleError("Invalid binary tree: %zu nodes are missing", remaining);
+          errorCode = -1;
+        }
+    }
+
+  free(strings);
+
+  if (root && reader.isPacked)
+    {
+      if (reader.position != reader.size || loadBlock(&reader))
+        {
+          handleError("Invalid binary tree: data after tree");
+          errorCode = -1;
+        }
+    }
+
+  free(reader.block);
+
+  if (!root || errorCode)
+    {
+      if (root) db::removeNode(root);
+
+      handleError("Invalid binary tree");
+      ERROR(nullptr);
+    }
+
+  if (bytes) *bytes = reader.bytes;
+
+  return root;
+}
+
+static bool writeByte(ByteBuffer *buffer, unsigned char byte)
+{
+  return writeBytes(buffer, &byte, 1);
+}
+
+static bool writeBytes(ByteBuffer *buffer, const void *data, size_t size)
+{
+  assert(buffer);
+  assert(data || !size);
+
+  if (buffer->size + size > buffer->capacity)
+    {
+      size_t capacity = buffer->capacity ? buffer->capacity : BLOCK_SIZE;
+      while (capacity < buffer->size + size) capacity *= GROWTH_FACTOR;
+
+      unsigned char *temp =
+        (unsigned char *)recalloc(buffer->data, capacity, sizeof(unsigned char));
+      if (!temp) return false;
+
+      buffer->data     = temp;
+      buffer->capacity = capacity;
+    }
+
+  if (size)
+    memcpy(buffer->data + buffer->size, data, size);
+  buffer->size += size;
+
+  return true;
+}
+
+static bool writeVarint(ByteBuffer *buffer, unsigned long long value)
+{
+  do
+    {
+      unsigned char byte = (unsigned char)(value & 0x7f);
+      value >>= 7;
+
+      if (value) byte |= 0x80;
+
+      if (!writeByte(buffer, byte)) return false;
+    } while (value);
+
+  return true;
+}
+
+static bool collectStrings(const db::TreeNode *node, StringTable *table)
+{
+  assert(table);
+
+  for (; node; node = node->right)
+    {
+      if ((node->type == db::type_t::NAME || node->type == db::type_t::STRING) &&
+          node->value.name)
+        {
+          if (table->size == table->capacity)
+            {
+              table->capacity = GROWTH_FACTOR*table->capacity + 1;
+              const char **temp =
+                (const char **)recalloc(table->strings, table->capacity, sizeof(const char *));
+              if (!temp) return false;
+
+              table->strings = temp;
+            }
+
+          table->strings[table->size++] = node->value.name;
+        }
+
+      if (!collectStrings(node->left, table)) return false;
+    }
+
+  return true;
+}
+
+static size_t countChainNodes(const db::TreeNode *node)
+{
+  size_t count = 0;
+
+  for (; node; node = node->right)
+    count += 1 + countChainNodes(node->left);
+
+  return count;
+}
+
+static int compareStringPointers(const void *first, const void *second)
+{
+  return strcmp(*(const char * const *)first, *(const char * const *)second);
+}
+
+static size_t searchStringIndex(const StringTable *table, const char *string)
+{
+  assert(table);
+  assert(string);
+
+  const char **found =
+    (const char **)bsearch(&string, table->strings, table->size, sizeof(const char *), compareStringPointers);
+
+  return found ? (size_t)(found - table->strings) : table->size;
+}
+
+static bool writeStrings(const StringTable *table, ByteBuffer *buffer)
+{
+  assert(table);
+  assert(buffer);
+
+  if (!writeVarint(buffer, table->size)) return false;
+
+  const char *previous = "";
+  for (size_t i = 0; i < table->size; ++i)
+    {
+      const char *string = table->strings[i];
+
+      size_t prefix = 0;
+      while (previous[prefix] && previous[prefix] == string[prefix]) ++prefix;
+
+      size_t suffix = strlen(string + prefix);
+
+      if (!writeVarint(buffer, prefix) ||
+          !writeVarint(buffer, suffix) ||
+          !writeBytes (buffer, string + prefix, suffix)) return false;
+
+      previous = string;
+    }
+
+  return true;
+}
+
+static bool writeNode(const db::TreeNode *node, const StringTable *table, ByteBuffer *buffer)
+{
+  assert(node);
+  assert(table);
+  assert(buffer);
+
+  for (; node; node = node->right)
+    {
+      if (!writeValue(node, table, buffer)) return false;
+
+      if (node->left && !writeNode(node->left, table, buffer)) return false;
+    }
+
+  return true;
+}
+
+static bool writeValue(const db::TreeNode *node, const StringTable *table, ByteBuffer *buffer)
+{
+  assert(node);
+  assert(table);
+  assert(buffer);
+
+  unsigned long long kind = 0;
+  unsigned long long integer = 0;
+
+  switch (node->type)
+    {
+    case db::type_t::NUMBER:
+      {
+        double value = node->value.number;
+
+        if (fabs(value) < MAX_EXACT_INTEGER)
+          {
+            long long exact = (long long)value;
+            double back = (double)exact;
+
+            if (!memcmp(&back, &value, sizeof(double)))
+              {
+                kind    = KIND_INTEGER;
+                integer = ((unsigned long long)exact << 1) ^ (unsigned long long)(exact >> 63);
+                break;
+              }
+          }
+
+        kind = KIND_REAL;
+        break;
+      }
+    case db::type_t::NAME:
+    case db::type_t::STRING:
+      {
+        kind    = (node->type == db::type_t::NAME ? KIND_NAME : KIND_STRING);
+        integer = searchStringIndex(table, node->value.name ? node->value.name : "");
+        break;
+      }
+    case db::type_t::STATEMENT:
+      {
+        kind = KIND_STATEMENT + (unsigned long long)node->value.statement;
+        break;
+      }
+    default: return false;
+    }
+
+  unsigned long long tag = kind << 2;
+  if (node->left ) tag |= 0x02;
+  if (node->right) tag |= 0x01;
+
+  if (!writeVarint(buffer, tag)) return false;
+
+  if (kind == KIND_REAL)
+    {
+      if (!writeBytes(buffer, &node->value.number, sizeof(double))) return false;
+    }
+  else if (kind < KIND_STATEMENT)
+    {
+      if (!writeVarint(buffer, integer)) return false;
+    }
+
+  return true;
+}
+
+static bool packBlock(const unsigned char *source, size_t size, ByteBuffer *target)
+{
+  assert(source);
+  assert(target);
+
+  const size_t hashSize = (size_t)1 << HASH_BITS;
+
+  size_t *positions = (size_t *)calloc(hashSize, sizeof(size_t));
+  if (!positions) return false;
+
+  bool isOk = true;
+
+  size_t literal = 0;
+  size_t i = 0;
+  while (i + MIN_MATCH <= size && isOk)
+    {
+      unsigned word = 0;
+      memcpy(&word, source + i, MIN_MATCH);
+
+      size_t hash = (size_t)((word * 2654435761u) >> (32 - HASH_BITS));
+
+      size_t candidate = positions[hash];
+      positions[hash] = i + 1;
+
+      if (!candidate || memcmp(source + candidate - 1, source + i, MIN_MATCH))
+        {
+          ++i;
+          continue;
+        }
+
+      size_t match  = candidate - 1;
+      size_t length = MIN_MATCH;
+      while (i + length < size && source[match + length] == source[i + length]) ++length;
+
+      isOk = writeVarint(target, i - literal)                 &&
+             writeBytes (target, source + literal, i - literal) &&
+             writeVarint(target, length - MIN_MATCH)          &&
+             writeVarint(target, i - match);
+
+      i += length;
+      literal = i;
+    }
+
+  isOk = isOk &&
+    writeVarint(target, size - literal) &&
+    writeBytes (target, source + literal, size - literal);
+
+  free(positions);
+
+  return isOk;
+}
+
+static int readRawByte(ByteReader *reader)
+{
+  assert(reader);
+
+  int ch = getc(reader->source);
+  if (ch != EOF) ++reader->bytes;
+
+  return ch;
+}
+
+static int readByte(ByteReader *reader)
+{
+  assert(reader);
+
+  if (!reader->isPacked)
+    return readRawByte(reader);
+
+  if (reader->position == reader->size && !loadBlock(reader))
+    return EOF;
+
+  return reader->block[reader->position++];
+}
+
+static bool readVarint(ByteReader *reader, ReadFunction *read, unsigned long long *value)
+{
+  assert(reader);
+  assert(read);
+  assert(value);
+
+  *value = 0;
+
+  for (unsigned shift = 0; shift < 64; shift += 7)
+    {
+      int byte = read(reader);
+      if (byte == EOF) return false;
+
+      *value |= (unsigned long long)(byte & 0x7f) << shift;
+
+      if (!(byte & 0x80)) return true;
+    }
+
+  return false;
+}
+
+static bool readMemoryVarint(const unsigned char *data, size_t size, size_t *position, unsigned long long *value)
+{
+  assert(data);
+  assert(position);
+  assert(value);
+
+  *value = 0;
+
+  for (unsigned shift = 0; shift < 64 && *position < size; shift += 7)
+    {
+      unsigned char byte = data[(*position)++];
+
+      *value |= (unsigned long long)(byte & 0x7f) << shift;
+
+      if (!(byte & 0x80)) return true;
+    }
+
+  return false;
+}
+
+static bool loadBlock(ByteReader *reader)
+{
+  assert(reader);
+
+  unsigned long long rawSize    = 0;
+  unsigned long long packedSize = 0;
+
+  if (!readVarint(reader, readRawByte, &rawSize) || !rawSize) return false;
+  if (!readVarint(reader, readRawByte, &packedSize))          return false;
+
+  if (rawSize > BLOCK_SIZE || packedSize > BLOCK_SIZE) return false;
+
+  if (!reader->block)
+    {
+      reader->block = (unsigned char *)calloc(BLOCK_SIZE, sizeof(unsigned char));
+      if (!reader->block) return false;
+    }
+
+  reader->size     = (size_t)rawSize;
+  reader->position = 0;
+
+  if (!packedSize)
+    {
+      size_t count = fread(reader->block, sizeof(unsigned char), reader->size, reader->source);
+      reader->bytes += count;
+
+      return count == reader->size;
+    }
+
+  unsigned char *packed = (unsigned char *)calloc((size_t)packedSize, sizeof(unsigned char));
+  if (!packed) return false;
+
+  size_t count = fread(packed, sizeof(unsigned char), (size_t)packedSize, reader->source);
+  reader->bytes += count;
+
+  bool isOk = (count == packedSize) &&
+    unpackBlock(packed, (size_t)packedSize, reader->block, reader->size);
+
+  free(packed);
+
+  return isOk;
+}
+
+static bool unpackBlock(const unsigned char *source, size_t size, unsigned char *target, size_t targetSize)
+{
+  assert(source);
+  assert(target);
+
+  size_t position = 0;
+  size_t out = 0;
+
+  while (out < targetSize)
+    {
+      unsigned long long literals = 0;
+      if (!readMemoryVarint(source, size, &position, &literals)) return false;
+
+      if (literals > targetSize - out || literals > size - position) return false;
+
+      memcpy(target + out, source + position, (size_t)literals);
+      out      += (size_t)literals;
+      position += (size_t)literals;
+
+      if (out == targetSize) break;
+
+      unsigned long long length = 0;
+      unsigned long long offset = 0;
+      if (!readMemoryVarint(source, size, &position, &length) ||
+          !readMemoryVarint(source, size, &position, &offset)) return false;
+
+      length += MIN_MATCH;
+
+      if (!offset || offset > out || length > targetSize - out) return false;
+
+      for (size_t i = 0; i < length; ++i, ++out)
+        target[out] = target[out - offset];
+    }
+
+  return true;
+}
+
+static char **readStrings(ByteReader *reader, db::StringPool *pool, size_t *count)
+{
+  assert(reader);
+  assert(pool);
+  assert(count);
+
+  unsigned long long size = 0;
+  if (!readVarint(reader, readByte, &size)) return nullptr;
+
+  // Count from stream isn`t trusted, array grows only with strings which are really read
+  size_t stringsCapacity = 1;
+  char **strings = (char **)calloc(stringsCapacity, sizeof(char *));
+  if (!strings) return nullptr;
+
+  size_t capacity = 1;
+  char *buffer = (char *)calloc(capacity, sizeof(char));
+  if (!buffer) { free(strings); return nullptr; }
+
+  for (size_t i = 0; i < size; ++i)
+    {
+      if (i == stringsCapacity)
+        {
+          stringsCapacity = GROWTH_FACTOR*stringsCapacity + 1;
+          char **temp = (char **)recalloc(strings, stringsCapacity, sizeof(char *));
+          if (!temp) { free(buffer); free(strings); return nullptr; }
+
+          strings = temp;
+        }
+
+      unsigned long long prefix = 0;
+      unsigned long long suffix = 0;
+
+      if (!readVarint(reader, readByte, &prefix) ||
+          !readVarint(reader, readByte, &suffix) ||
+          prefix > strlen(buffer))
+        {
+          free(buffer);
+          free(strings);
+          return nullptr;
+        }
+
+      size_t length = (size_t)(prefix + suffix);
+      if (length + 1 > capacity)
+        {
+          capacity = length + 1;
+          char *temp = (char *)recalloc(buffer, capacity, sizeof(char));
+          if (!temp) { free(buffer); free(strings); return nullptr; }
+
+          buffer = temp;
+        }
+
+      bool isOk = true;
+      for (size_t j = (size_t)prefix; j < length && isOk; ++j)
+        {
+          int ch = readByte(reader);
+
+          isOk = (ch != EOF);
+          buffer[j] = (char)ch;
+        }
+      buffer[length] = '\0';
+
+      strings[i] = (isOk ? db::addString(pool, buffer) : nullptr);
+
+      if (!strings[i]) { free(buffer); free(strings); return nullptr; }
+    }
+
+  free(buffer);
+
+  *count = (size_t)size;
+
+  return strings;
+}
+
+static db::TreeNode *readNode(
+                              ByteReader *reader,
+                              char *const *strings,
+                              size_t count,
+                              size_t *remaining,
+                              int *error
+                             )
+{
+  assert(reader);
+  assert(strings);
+  assert(remaining);
+
+  db::TreeNode *root = nullptr;
+  db::TreeNode *last = nullptr;
+
+  bool hasRight = true;
+  while (hasRight)
+    {
+      unsigned long long tag = 0;
+
+      db::TreeNode *node = (*remaining ? readValue(reader, strings, count, &tag) : nullptr);
+      if (!node)
+        {
+          if (root) db::removeNode(root);
+          ERROR(nullptr);
+        }
+
+      --*remaining;
+
+      if (last) db::setParent(node, last, 0);
+      else      root = node;
+
+      last = node;
+
+      if (tag & 0x02)
+        {
+          db::TreeNode *left = readNode(reader, strings, count, remaining, error);
+          if (!left)
+            {
+              db::removeNode(root);
+              ERROR(nullptr);
+            }
+
+          db::setParent(left, node, 1);
+        }
+
+      hasRight = (tag & 0x01);
+    }
+
+  return root;
+}
+
+static db::TreeNode *readValue(
+                               ByteReader *reader,
+                               char *const *strings,
+                               size_t count,
+                               unsigned long long *tag
+                              )
+{
+  assert(reader);
+  assert(strings);
+  assert(tag);
+
+  if (!readVarint(reader, readByte, tag)) return nullptr;
+
+  unsigned long long kind = *tag >> 2;
+
+  db::treeValue_t value{};
+  db::type_t type = db::type_t::STATEMENT;
+
+  switch (kind)
+    {
+    case KIND_INTEGER:
+      {
+        unsigned long long integer = 0;
+        if (!readVarint(reader, readByte, &integer)) return nullptr;
+
+        long long exact = (long long)(integer >> 1) ^ -(long long)(integer & 1);
+
+        type = db::type_t::NUMBER;
+        value.number = (double)exact;
+        break;
+      }
+    case KIND_REAL:
+      {
+        unsigned char bytes[sizeof(double)] = {};
+        for (size_t i = 0; i < sizeof(double); ++i)
+          {
+            int byte = readByte(reader);
+            if (byte == EOF) return nullptr;
+
+            bytes[i] = (unsigned char)byte;
+          }
+
+        type = db::type_t::NUMBER;
+        memcpy(&value.number, bytes, sizeof(double));
+        break;
+      }
+    case KIND_NAME:
+    case KIND_STRING:
+      {
+        unsigned long long index = 0;
+        if (!readVarint(reader, readByte, &index) || index >= count) return nullptr;
+
+        type = (kind == KIND_NAME ? db::type_t::NAME : db::type_t::STRING);
+        value.name = strings[index];
+        break;
+      }
+    default:
+      {
+        if (kind - KIND_STATEMENT >= STATEMENTS_COUNT) return nullptr;
+
+        value.statement = (db::statement_t)(kind - KIND_STATEMENT);
+        break;
+      }
+    }
+
+  return db::createNode(value, type, nullptr, nullptr);
+}
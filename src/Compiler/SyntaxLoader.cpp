@@ -1,4 +1,5 @@
 #include "Translator.h"
+#include "SyntaxBinary.h"
 
 #include "ErrorHandler.h"
 #include "StringsUtils.h"
@@ -7,6 +8,7 @@
 #include "DSL.h"
 #include <ctype.h>
 #include <string.h>
+#include <time.h>
 
 #include "Logging.h"
 
@@ -17,7 +19,7 @@
     {                                                          \
       if (!fscanf(source, " %c", &ch) || ch != CHAR)           \
         {                                                      \
-          printf("%s\n", buffer);                              \
+          fprintf(stderr, "%s\n", buffer);                     \
           handleError("Expected " #CHAR " %d", __LINE__);      \
           ERROR(nullptr);                                      \
         }                                                      \
@@ -96,7 +98,7 @@ const Statement STATEMENTS[] =
     {"DIFF"  , db::STATEMENT_DIFF      , 4},
   };
 
-const int STATEMENTS_SIZE = 33;
+const int STATEMENTS_SIZE = (int)(sizeof(STATEMENTS)/sizeof(STATEMENTS[0]));
 
 static db::Token createNumber(db::number_t value)
 {
@@ -137,10 +139,40 @@ void db::loadTranslator(
   bool hasntTokens = false;
   int codeError = 0;
 
-  translator->grammar.root
-    = loadToken(source, &translator->stringPool, &hasntTokens, &codeError);
+  clock_t start = clock();
+  long begin = ftell(source);
+
+  bool isBinary = db::isBinaryTree(source);
+  size_t bytes = 0;
+
+  if (isBinary)
+    translator->grammar.root
+      = db::loadBinaryTree(source, &translator->stringPool, &bytes, &codeError);
+  else
+    {
+      translator->grammar.root
+        = loadToken(source, &translator->stringPool, &hasntTokens, &codeError);
+
+      long end = ftell(source);
+      if (begin >= 0 && end > begin) bytes = (size_t)(end - begin);
+    }
   if (codeError) ERROR();
 
+  double seconds = (double)(clock() - start)/CLOCKS_PER_SEC;
+
+  FILE *log = getLogFile();
+  if (log)
+    {
+      size_t nodes = db::countNodes(translator->grammar.root);
+
+      fprintf(log, "<pre>Loaded %s tree: %zu nodes", isBinary ? "binary" : "text", nodes);
+      if (bytes)
+        fprintf(log, ", %zu bytes, %.2f bytes/node", bytes, (double)bytes/(double)nodes);
+      if (seconds > 0)
+        fprintf(log, ", %.0f nodes/s", (double)nodes/seconds);
+      fprintf(log, "</pre>\n");
+    }
+
   db:: dumpTree(&translator->grammar, 0, getLogFile());
   if (!translator->grammar.root)          HANDLE_ERROR("File hasn`t tree");
   if (!IS_COMP(translator->grammar.root)) HANDLE_ERROR("Root of tree isn`t statement");
@@ -287,10 +319,10 @@ static void findGlobalVariables(db::Translator *translator, int *error)
 {
   db::Token temp = translator->grammar.root;
   for ( ; temp; temp = temp->right)
-    if (IS_VAR(temp->left))
+    if (IS_VAR(temp->left) || IS_VAL(temp->left))
         if (!db::addVariable(
                              NAME(temp->left->left),
-                             false,
+                             IS_VAL(temp->left),
                              translator,
                              0
                             ))
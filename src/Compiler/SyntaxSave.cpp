@@ -1,4 +1,5 @@
 #include "Translator.h"
+#include "SyntaxBinary.h"
 
 #include "ErrorHandler.h"
 #include "StringsUtils.h"
@@ -6,6 +7,8 @@
 #include "Assert.h"
 #include "DSL.h"
 
+#include "Logging.h"
+
 #pragma GCC diagnostic ignored "-Wswitch-enum"
 
 #define CASE(STATEMENT, NAME)                                         \
@@ -34,8 +37,26 @@ void db::saveTranslator(
   if (!translator || !translator->grammar.root || !target) ERROR();
 
   int errorCode = 0;
-  saveToken(translator->grammar.root, target, &errorCode);
+
+  if (translator->status.format == db::TreeFormat::Text)
+    {
+      saveToken(translator->grammar.root, target, &errorCode);
+      if (errorCode) ERROR();
+
+      return;
+    }
+
+  bool isPacked = (translator->status.format == db::TreeFormat::Packed);
+
+  size_t nodes = db::countNodes(translator->grammar.root);
+  size_t bytes =
+    db::saveBinaryTree(translator->grammar.root, target, isPacked, &errorCode);
   if (errorCode) ERROR();
+
+  FILE *log = getLogFile();
+  if (log)
+    fprintf(log, "<pre>Saved %s tree: %zu nodes, %zu bytes, %.2f bytes/node</pre>\n",
+            isPacked ? "packed" : "binary", nodes, bytes, (double)bytes/(double)nodes);
 }
 
 static void saveToken(const db::Token token, FILE *target, int *error)
@@ -62,6 +83,7 @@ static void saveToken(const db::Token token, FILE *target, int *error)
             CASE(SUB, SUB);
             CASE(MUL, MUL);
             CASE(DIV, DIV);
+            CASE(POW, POW);
             CASE(SIN , SIN );
             CASE(COS , COS );
             CASE(TAN , TAN );
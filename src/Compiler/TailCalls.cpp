@@ -0,0 +1,473 @@
+#include "Translator.h"
+
+#include <stdio.h>
+#include "DSL.h"
+#include "Assert.h"
+#include "Logging.h"
+#include "Error.h"
+
+struct TailCallState {
+  db::Translator *translator;
+  db::Token       function; ///< Function which is rewritten now
+
+  size_t calls;
+  size_t functions;
+  size_t countOfNames;
+};
+
+/// Body of function becomes loop, self calls in tail position become assignments of parameters
+static bool rewriteFunction(TailCallState *state, db::Token function);
+
+/// Check tail calls in block which is the last code of function
+static bool hasTailCall(const TailCallState *state, const db::Token block);
+
+/// Rewrite tail calls of block which is the last code of function
+/// @note Every path of block ends by return or assignments of parameters after it
+static bool rewriteBlock(TailCallState *state, db::Token block);
+
+/// Replace tail call of command by assignments of arguments to parameters
+static bool replaceTailCall(TailCallState *state, db::Token command);
+
+static bool isSelfCall(const TailCallState *state, const db::Token token);
+
+/// Self call is command, after which function returns without value
+static bool isVoidTailCall(const TailCallState *state, const db::Token command);
+
+static bool alwaysReturns(const db::Token block);
+
+/// Local shadows parameter, so parameter can not be assigned in block
+static bool isShadowed(const TailCallState *state, const db::Token token);
+
+/// Argument reads parameter which is assigned before it
+static bool readsAssigned(const TailCallState *state, const db::Token value, const db::Token parameter);
+
+/// Some argument calls function, assigns or reads input, so order of arguments is kept
+static bool hasImpureArgument(const db::Token call);
+
+static bool isReading(const db::Token token, const char *name);
+
+static bool appendReturn(db::Token command);
+
+/// Append command with statement to chain, statement is removed if command is not created
+static bool appendCommand(db::Token *first, db::Token *last, db::Token statement);
+
+/// Put command with statement before chain, like appendCommand
+static bool prependCommand(db::Token *first, db::Token *last, db::Token statement);
+
+static char *createName(TailCallState *state);
+
+void db::eliminateTailCalls(db::Translator *translator, int *error)
+{
+  if (!translator || !translator->grammar.root) ERROR();
+
+  TailCallState state{};
+  state.translator = translator;
+
+  bool isOk = true;
+
+  for (db::Token token = translator->grammar.root; token && isOk; token = token->right)
+    if (IS_FUN(token->left))
+      isOk = rewriteFunction(&state, token->left);
+
+  if (!isOk) ERROR();
+
+  FILE *log = getLogFile();
+  if (!log) return;
+
+  fprintf(log, "<pre>Tail calls: %zu calls in %zu functions replaced by loops</pre>\n",
+          state.calls, state.functions);
+}
+
+static bool rewriteFunction(TailCallState *state, db::Token function)
+{
+  assert(state);
+  assert(function);
+
+  state->function = function;
+
+  if (isShadowed(state, function->right) || !hasTailCall(state, function->right)) return true;
+
+  if (!rewriteBlock(state, function->right)) return false;
+
+  db::Token one  = db::createNode({.number = 1}, db::type_t::NUMBER);
+  db::Token loop = (one  ? CREATE_STATEMENT(WHILE, one, function->right) : nullptr);
+  db::Token body = (loop ? CREATE_STATEMENT(COMPOUND, loop, nullptr)    : nullptr);
+
+  if (!body)
+    {
+      if (loop) loop->right = nullptr;
+      if (loop) db::removeNode(loop);
+      else if (one) db::removeNode(one);
+
+      return false;
+    }
+
+  db::setChildren(function, function->left, body);
+  ++state->functions;
+
+  return true;
+}
+
+static bool hasTailCall(const TailCallState *state, const db::Token block)
+{
+  assert(state);
+
+  for (db::Token command = block; command; command = command->right)
+    {
+      db::Token statement = command->left;
+
+      if (IS_RETURN(statement)) return isSelfCall(state, statement->left);
+
+      if (isVoidTailCall(state, command)) return true;
+
+      if (!IS_IF(statement)) continue;
+
+      bool hasElse = IS_ELSE(statement->right);
+
+      db::Token thenBlock = (hasElse ? statement->right->left  : statement->right);
+      db::Token elseBlock = (hasElse ? statement->right->right : nullptr);
+
+      bool isTail =
+        !command->right ||
+        (alwaysReturns(thenBlock) && (!hasElse || alwaysReturns(elseBlock)));
+
+      if (isTail && (hasTailCall(state, thenBlock) || hasTailCall(state, elseBlock)))
+        return true;
+    }
+
+  return false;
+}
+
+static bool rewriteBlock(TailCallState *state, db::Token block)
+{
+  assert(state);
+
+  for (db::Token command = block; command; command = command->right)
+    {
+      db::Token statement = command->left;
+
+      if (IS_RETURN(statement) || isVoidTailCall(state, command))
+        {
+          // Commands after return are not reachable
+          if (command->right) db::removeNode(command->right);
+          command->right = nullptr;
+
+          if (IS_RETURN(statement) && !isSelfCall(state, statement->left)) return true;
+
+          return replaceTailCall(state, command);
+        }
+
+      bool isLast = !command->right;
+
+      if (!IS_IF(statement))
+        {
+          if (!isLast) continue;
+
+          return appendReturn(command);
+        }
+
+      bool hasElse = IS_ELSE(statement->right);
+
+      db::Token thenBlock = (hasElse ? statement->right->left  : statement->right);
+      db::Token elseBlock = (hasElse ? statement->right->right : nullptr);
+
+      bool isTail =
+        (isLast || (alwaysReturns(thenBlock) && (!hasElse || alwaysReturns(elseBlock)))) &&
+        (hasTailCall(state, thenBlock) || hasTailCall(state, elseBlock));
+
+      if (!isTail)
+        {
+          if (!isLast) continue;
+
+          return appendReturn(command);
+        }
+
+      if (hasElse && command->right)
+        {
+          // Both branches return
+          db::removeNode(command->right);
+          command->right = nullptr;
+        }
+      else if (!hasElse)
+        {
+          // Commands after if, which returns, are its else branch
+          db::Token rest = command->right;
+          command->right = nullptr;
+
+          if (!rest)
+            {
+              db::Token exit = CREATE_STATEMENT(RETURN, nullptr, nullptr);
+              rest = (exit ? CREATE_STATEMENT(COMPOUND, exit, nullptr) : nullptr);
+              if (!rest)
+                {
+                  if (exit) db::removeNode(exit);
+                  return false;
+                }
+            }
+
+          db::Token elseNode = CREATE_STATEMENT(ELSE, thenBlock, rest);
+          if (!elseNode)
+            {
+              db::setChildren(command, statement, rest);
+              return false;
+            }
+
+          db::setChildren(statement, statement->left, elseNode);
+          elseBlock = rest;
+        }
+
+      return rewriteBlock(state, thenBlock) && rewriteBlock(state, elseBlock);
+    }
+
+  return true;
+}
+
+static bool replaceTailCall(TailCallState *state, db::Token command)
+{
+  assert(state);
+  assert(command);
+
+  db::Token statement = command->left;
+  db::Token call      = (IS_RETURN(statement) ? statement->left : statement);
+
+  db::Token temporaries     = nullptr;
+  db::Token temporariesLast = nullptr;
+  db::Token assignments     = nullptr;
+  db::Token assignmentsLast = nullptr;
+
+  bool isOk = true;
+
+  // Call calculates arguments from the last one, so temporaries are put in reverse order
+  bool isOrdered = hasImpureArgument(call);
+
+  db::Token parameter = state->function->left->left;
+  db::Token argument  = call->left->left;
+
+  for ( ; parameter && argument && isOk; parameter = parameter->right, argument = argument->right)
+    {
+      char     *name  = NAME(parameter->left->left);
+      db::Token value = argument->left;
+
+      if (IS_NAME(value) && db::compareStrings(NAME(value), name)) continue;
+
+      argument->left = nullptr;
+
+      // Value is calculated before the first assignment
+      if ((isOrdered && !IS_NUM(value)) || readsAssigned(state, value, parameter))
+        {
+          char     *temporary   = createName(state);
+          db::Token variable    =
+            (temporary ? db::createNode({.name = temporary}, db::type_t::NAME) : nullptr);
+          db::Token declaration = (variable ? CREATE_STATEMENT(VAR, variable, value) : nullptr);
+
+          if (!declaration)
+            {
+              if (variable) db::removeNode(variable);
+              db::removeNode(value);
+
+              isOk = false;
+              break;
+            }
+
+          isOk = prependCommand(&temporaries, &temporariesLast, declaration);
+          if (!isOk) break;
+
+          value = db::createNode({.name = temporary}, db::type_t::NAME);
+          isOk  = value;
+          if (!isOk) break;
+        }
+
+      db::Token target     = db::createNode({.name = name}, db::type_t::NAME);
+      db::Token assignment = (target ? CREATE_STATEMENT(ASSIGNMENT, target, value) : nullptr);
+
+      if (!assignment)
+        {
+          if (target) db::removeNode(target);
+          db::removeNode(value);
+
+          isOk = false;
+          break;
+        }
+
+      isOk = appendCommand(&assignments, &assignmentsLast, assignment);
+    }
+
+  if (!isOk)
+    {
+      if (temporaries) db::removeNode(temporaries);
+      if (assignments) db::removeNode(assignments);
+
+      return false;
+    }
+
+  // Call with the same arguments is left as it is
+  if (!assignments) return true;
+
+  db::Token code = assignments;
+  if (temporaries)
+    {
+      db::setChildren(temporariesLast, temporariesLast->left, assignments);
+      code = temporaries;
+    }
+
+  db::setChildren(assignmentsLast, assignmentsLast->left, command->right);
+  db::setChildren(command, code->left, code->right);
+
+  code->left = code->right = nullptr;
+  db::removeNode(code);
+  db::removeNode(statement);
+
+  ++state->calls;
+
+  return true;
+}
+
+static bool isSelfCall(const TailCallState *state, const db::Token token)
+{
+  assert(state);
+
+  return IS_CALL(token) && token->left &&
+         db::compareStrings(NAME(token->left), NAME(state->function->left));
+}
+
+static bool isVoidTailCall(const TailCallState *state, const db::Token command)
+{
+  assert(state);
+  assert(command);
+
+  if (!isSelfCall(state, command->left)) return false;
+
+  db::Token next = command->right;
+
+  return !next || (IS_RETURN(next->left) && !next->left->left && !next->right);
+}
+
+static bool alwaysReturns(const db::Token block)
+{
+  db::Token last = block;
+  for ( ; last && last->right; last = last->right) continue;
+
+  if (!last) return false;
+
+  db::Token statement = last->left;
+
+  if (IS_RETURN(statement)) return true;
+
+  return IS_IF(statement) && IS_ELSE(statement->right) &&
+         alwaysReturns(statement->right->left) &&
+         alwaysReturns(statement->right->right);
+}
+
+static bool isShadowed(const TailCallState *state, const db::Token token)
+{
+  assert(state);
+
+  if (!token) return false;
+
+  if (IS_VAR(token) || IS_VAL(token))
+    for (db::Token parameter = state->function->left->left; parameter; parameter = parameter->right)
+      if (db::compareStrings(NAME(token->left), NAME(parameter->left->left))) return true;
+
+  return isShadowed(state, token->left) || isShadowed(state, token->right);
+}
+
+static bool readsAssigned(const TailCallState *state, const db::Token value, const db::Token parameter)
+{
+  assert(state);
+  assert(parameter);
+
+  for (db::Token previous = state->function->left->left; previous != parameter; previous = previous->right)
+    if (isReading(value, NAME(previous->left->left))) return true;
+
+  return false;
+}
+
+static bool hasImpureArgument(const db::Token call)
+{
+  assert(call);
+
+  for (db::Token argument = call->left->left; argument; argument = argument->right)
+    if (!db::isPureNode(argument->left)) return true;
+
+  return false;
+}
+
+static bool isReading(const db::Token token, const char *name)
+{
+  assert(name);
+
+  if (!token) return false;
+
+  if (IS_NAME(token)) return db::compareStrings(NAME(token), name);
+
+  return isReading(token->left, name) || isReading(token->right, name);
+}
+
+static bool appendReturn(db::Token command)
+{
+  assert(command);
+
+  db::Token exit = CREATE_STATEMENT(RETURN, nullptr, nullptr);
+  db::Token next = (exit ? CREATE_STATEMENT(COMPOUND, exit, nullptr) : nullptr);
+
+  if (!next)
+    {
+      if (exit) db::removeNode(exit);
+      return false;
+    }
+
+  db::setChildren(command, command->left, next);
+
+  return true;
+}
+
+static bool appendCommand(db::Token *first, db::Token *last, db::Token statement)
+{
+  assert(first);
+  assert(last);
+  assert(statement);
+
+  db::Token command = CREATE_STATEMENT(COMPOUND, statement, nullptr);
+  if (!command)
+    {
+      db::removeNode(statement);
+      return false;
+    }
+
+  if (*last) db::setChildren(*last, (*last)->left, command);
+  else       *first = command;
+
+  *last = command;
+
+  return true;
+}
+
+static bool prependCommand(db::Token *first, db::Token *last, db::Token statement)
+{
+  assert(first);
+  assert(last);
+  assert(statement);
+
+  db::Token command = CREATE_STATEMENT(COMPOUND, statement, *first);
+  if (!command)
+    {
+      db::removeNode(statement);
+      return false;
+    }
+
+  if (!*last) *last = command;
+
+  *first = command;
+
+  return true;
+}
+
+static char *createName(TailCallState *state)
+{
+  assert(state);
+
+  char name[db::MAX_NAME_SIZE] = "";
+  sprintf(name, "$tail_%zu", state->countOfNames++);
+
+  return db::addString(&state->translator->stringPool, name);
+}
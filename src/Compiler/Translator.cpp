@@ -1,8 +1,13 @@
 #include "Translator.h"
+#include "StackIr.h"
+#include "ControlFlow.h"
 
 #include <string.h>
 #include <ctype.h>
+#include <limits.h>
 #include <malloc.h>
+#include <pthread.h>
+#include <unistd.h>
 #include "DSL.h"
 #include "SystemLike.h"
 #include "Fiofunctions.h"
@@ -10,6 +15,7 @@
 #include "ErrorHandler.h"
 #include "Error.h"
 #include "Assert.h"
+#include "Logging.h"
 
 #pragma GCC diagnostic ignored "-Wswitch-enum"
 
@@ -44,7 +50,7 @@
       else                                                              \
         HANDLE_ERROR("Expected that " #STATEMENT                        \
                      " has at least one argument");                     \
-      fprintf(target, #STATEMENT "\n");                                 \
+      EMIT(STATEMENT);                                                  \
     } while (0)
 
 #define TRANSLATE_BINARY(STATEMENT)                                     \
@@ -66,7 +72,7 @@
       else                                                              \
         HANDLE_ERROR("Expected that " #STATEMENT                        \
                      " has second argument");                           \
-      fprintf(target, #STATEMENT "\n");                                 \
+      EMIT(STATEMENT);                                                  \
     } while (0)                                                         \
 
 #define TRANSLATE_LINARY(STATEMENT)                                     \
@@ -83,23 +89,51 @@
         {                                                               \
           if (!translateToken(token->left , translator, target, error)) \
             ERROR(false);                                               \
-          fprintf(target, "PUSH 0\n");                                  \
-          fprintf(target, "PUSH 0\n");                                  \
+          EMIT(PUSH, IMM(0));                                           \
+          EMIT(PUSH, IMM(0));                                           \
         }                                                               \
-      fprintf(target, #STATEMENT "\n");                                 \
+      EMIT(STATEMENT);                                                  \
     } while (0)
 
+/// !x is x == 0 like in translateCondition
+#define TRANSLATE_NOT()                                                 \
+  do                                                                    \
+    {                                                                   \
+      if (!token->left)                                                 \
+        HANDLE_ERROR("Expected that NOT has at least one argument");    \
+      if (!translateToken(token->left, translator, target, error))      \
+        ERROR(false);                                                   \
+      EMIT(PUSH, IMM(0));                                               \
+      EMIT(PUSH, IMM(0));                                               \
+      EMIT(EQL);                                                        \
+    } while (0)
+
+
+#define EMIT(OPCODE, ...)                                               \
+  db::emitIr(target, db::Opcode::OPCODE __VA_OPT__(,) __VA_ARGS__)
+
+#define COMMENT(TEXT)                                                   \
+  db::emitIr(target, db::Opcode::COMMENT, {}, TEXT)
+
+/// Comment with operand after text
+#define NOTE(TEXT, OPERAND)                                             \
+  db::emitIr(target, db::Opcode::COMMENT, OPERAND, TEXT)
+
+#define IMM(VALUE)          db::immediateOperand(VALUE)
+#define REG(REGISTER)       db::registerOperand(REGISTER)
+#define MEM(ADDRESS, ...)   db::memoryOperand(ADDRESS __VA_OPT__(,) __VA_ARGS__)
+#define LABEL(PREFIX, ...)  db::labelOperand(PREFIX __VA_OPT__(,) __VA_ARGS__)
 
 #define START_TRANSLATE(MESSAGE)                \
   do                                            \
     {                                           \
-      fprintf(target, ";"#MESSAGE"\n");         \
+      COMMENT(#MESSAGE);                        \
     } while (0)
 
 #define END_TRANSLATE()                         \
   do                                            \
     {                                           \
-      fprintf(target, ";End\n\n");              \
+      COMMENT("End");                           \
     } while (0)
 
 const int BUFFER_SIZE  = 16;
@@ -108,34 +142,143 @@ const int  VIDEO_MEMORY_START =   0;
 const int GLOBAL_MEMORY_START = 128;
 const int  STACK_MEMORY_START = 256;
 
-const char *const     RETURN_INT_ADDRESS = "rax";
-const char *const   RETURN_FRACT_ADDRESS = "rbx";
-const char *const  STACK_POINTER_ADDRESS = "rcx";
-const char *const   STACK_BOTTOM_ADDRESS = "rdx";
-//const char *const STACK_FUNCTION_ADDRESS = "rfx";
+/// SHOW shows string from video memory up to zero
+const int VIDEO_MEMORY_SIZE = GLOBAL_MEMORY_START - VIDEO_MEMORY_START;
+
+/// Comment of every character of string, unprintable ones are ~
+struct CharComments {
+  char texts[UCHAR_MAX + 1][2];
+};
+
+static constexpr CharComments createCharComments()
+{
+  CharComments comments{};
+  for (int i = 0; i <= UCHAR_MAX; ++i)
+    comments.texts[i][0] = (' ' <= i && i <= '~' ? (char)i : '~');
+
+  return comments;
+}
+
+static constexpr CharComments CHAR_COMMENTS = createCharComments();
+
+const db::Register     RETURN_INT_ADDRESS = db::Register::RAX;
+const db::Register   RETURN_FRACT_ADDRESS = db::Register::RBX;
+const db::Register  STACK_POINTER_ADDRESS = db::Register::RCX;
+const db::Register   STACK_BOTTOM_ADDRESS = db::Register::RDX;
+/// Mode of arithmetic of VM, 1 is real numbers
+const db::Register        REAL_CALC_ADDRESS = db::Register::REX;
 
-static int allocateVariable(db::Token block, db::Translator *translator, int startIndex, FILE *target);
-static int allocateParameters(db::Token block, db::Translator *translator, FILE *target);
-static int allocateBlock(db::Token block, db::Translator *translator, int startIndex, FILE *target);
-static int allocateInstruction(db::Token token, db::Translator *translator, int startIndex, int blockNumber, FILE *target);
+/// Increase after every change of generated code, it invalidates AsmCache
+const int CACHE_VERSION = 9;
 
-static bool translateArgument(db::Token block, db::Translator *translator, FILE *target);
+/// Size of frame of locals, locals of sibling scopes share their words like in translateVariable
+/// @return Count of words
+static int allocateVariable(db::Token block, db::Translator *translator, int startIndex, db::IrCode *target);
+static int allocateParameters(db::Token block, db::Translator *translator, db::IrCode *target);
+static int allocateBlock(db::Token block, db::Translator *translator, int startIndex, db::IrCode *target);
+static int allocateInstruction(db::Token token, db::Translator *translator, int startIndex, int blockNumber, db::IrCode *target);
+
+/// Block of if or while, its locals are removed at its end
+static void allocateScope(db::Token block, db::Translator *translator, int startIndex, db::IrCode *target);
+
+/// Words of locals of the innermost scope, integral local has one word
+static int getScopeSize(const db::Translator *translator);
+
+static bool translateArgument(db::Token block, db::Translator *translator, db::IrCode *target);
+
+/// Jump to label if truth of condition is equal to isJumpIfTrue, otherwise fall through
+/// @note Comparisons are fused with jump, & and | are short-circuit if skipped operand is pure
+static bool translateCondition(
+                               db::Translator *translator,
+                               db::Token token,
+                               bool isJumpIfTrue,
+                               db::IrOperand label,
+                               db::IrCode *target,
+                               int *error = nullptr
+                              );
+
+/// Operands of fused comparison and its jump
+static bool translateCompare(
+                             db::Translator *translator,
+                             db::Token token,
+                             db::Opcode jump,
+                             db::IrOperand label,
+                             db::IrCode *target,
+                             int *error = nullptr
+                            );
+
+/// Without calls, input and assignments, so it may be skipped
+/// Characters of text to video memory from offset, terminating zero isn`t written
+/// @return Offset after text
+static int writeVideoMemory(const char *text, int offset, db::IrCode *target);
+
+/// Literal or endl, out shows them from video memory
+static bool isText(const db::Token token);
+
+/// Single word of integral expression, real-calc is turned off
+static bool translateInteger(
+                             db::Translator *translator,
+                             db::Token token,
+                             db::IrCode *target,
+                             int *error = nullptr
+                            );
+
+/// Value of integral expression to int word of local, fract word isn`t used
+static bool translateIntegerStore(
+                                  db::Translator *translator,
+                                  db::Token token,
+                                  int number,
+                                  db::IrCode *target,
+                                  int *error = nullptr
+                                 );
 
 static bool translateToken(
                            const db::Token token,
                            db::Translator *translator,
-                           FILE *target,
+                           db::IrCode *target,
                            int *error = nullptr
                           );
 
-static void translatrGlobaleVariable(db::Translator *translator, FILE *target, int *error = nullptr);
+/// Initialization of VM and globals and call of main
+static void translateStart(db::Translator *translator, db::IrCode *target, int *error = nullptr);
+
+static void translatrGlobaleVariable(db::Translator *translator, db::IrCode *target, int *error = nullptr);
 
 static void translateFunctions(db::Translator *translator, FILE *target, int *error = nullptr);
 
+/// Translated code of global initialization after peephole
+static void buildStart(db::Translator *translator, db::IrCode *target, int *error = nullptr);
+
+/// Translated and optimized code of function
+static void buildFunction(db::Translator *translator, db::Function *function, db::IrCode *target, int *error = nullptr);
+
+/// Functions, which are built concurrently, one by one in order of their indexes
+struct CodegenJob {
+  db::Translator *translator;
+  db::IrCode *codes;     ///< Code of every function
+  const bool *isSkipped; ///< Functions, which aren`t built, or nullptr
+  db::VarTable *globals; ///< Stack of translator isn`t used by workers, it is checked on reads
+  size_t next;           ///< Index of next function, it is shared by workers
+  bool isFailed;
+};
+
+/// Build code of every function, which isn`t skipped, by pool of threads
+/// @note Codes of not skipped functions are initialized, even if it is failed
+static void buildFunctions(db::Translator *translator, db::IrCode *codes, const bool *isSkipped, int *error = nullptr);
+
+/// Worker of CodegenJob
+static void *generateFunctions(void *job);
+
+static void translateFunction(db::Translator *translator, db::Function *function, db::IrCode *target, int *error = nullptr);
+
+/// Hash of everything outside of function which changes its code
+/// @note Level of optimizations, global variables numbers and return types of functions
+static db::hash_t hashEnvironment(const db::Translator *translator);
+
 typedef bool FunType(
                      db::Translator *translator,
                      db::Token token,
-                     FILE *target,
+                     db::IrCode *target,
                      int *error
                     );
 
@@ -156,15 +299,14 @@ static FunType translateString    ;
 static bool translateNumber(
                             db::Translator *translator,
                             db::Token token,
-                            FILE *target,
+                            db::IrCode *target,
                             int *error
                            )
 {
   CHECK_ARGUMENTS();
 
-  fprintf(target, "PUSH %d\nPUSH %d\n",
-          FRACT(NUMBER(token)),
-          INT(NUMBER(token)));
+  EMIT(PUSH, IMM(FRACT(NUMBER(token))));
+  EMIT(PUSH, IMM(  INT(NUMBER(token))));
 
   return true;
 }
@@ -172,7 +314,7 @@ static bool translateNumber(
 static bool translateName(
                           db::Translator *translator,
                           db::Token token,
-                          FILE *target,
+                          db::IrCode *target,
                           int *error
                          )
 {
@@ -183,15 +325,20 @@ static bool translateName(
   if (!var) HANDLE_ERROR("Unknown variable: %s", NAME(token));
 
   if (var->isGlobal)
-    fprintf(target, "PUSH [%d]\nPUSH [%d]\n",
-            GLOBAL_MEMORY_START+(var->number*2+1),
-            GLOBAL_MEMORY_START+(var->number*2  ));
+    {
+      EMIT(PUSH, MEM(GLOBAL_MEMORY_START+(var->number*2+1)));
+      EMIT(PUSH, MEM(GLOBAL_MEMORY_START+(var->number*2  )));
+    }
+  else if (var->isIntegral)
+    {
+      EMIT(PUSH, IMM(0));
+      EMIT(PUSH, MEM(STACK_MEMORY_START+(var->number  ), STACK_BOTTOM_ADDRESS));
+    }
   else
-    fprintf(target, "PUSH [%d+%s]\nPUSH [%d+%s]\n",
-            STACK_MEMORY_START+(var->number+1),
-            STACK_BOTTOM_ADDRESS,
-            STACK_MEMORY_START+(var->number  ),
-            STACK_BOTTOM_ADDRESS);
+    {
+      EMIT(PUSH, MEM(STACK_MEMORY_START+(var->number+1), STACK_BOTTOM_ADDRESS));
+      EMIT(PUSH, MEM(STACK_MEMORY_START+(var->number  ), STACK_BOTTOM_ADDRESS));
+    }
 
   return true;
 }
@@ -200,27 +347,44 @@ static bool translateName(
 static bool translateString(
                             db::Translator *translator,
                             db::Token token,
-                            FILE *target,
+                            db::IrCode *target,
                             int *error
                            )
 {
   CHECK_ARGUMENTS();
 
-  const char *temp = STRING(token);
-  int i = 0;
-  for ( ; *temp; ++temp, ++i)
-    fprintf(target, "PUSH %d; %c\nPOP [%d]\n",
-            *temp, isprint(*temp) ? *temp : '~', i);
-  fprintf(target, "PUSH %d; %c\nPOP [%d]\n",
-          *temp, isprint(*temp) ? *temp : '~', i);
+  int size = writeVideoMemory(STRING(token), 0, target);
+
+  EMIT(PUSH, IMM('\0'), CHAR_COMMENTS.texts['\0']);
+  EMIT(POP, MEM(VIDEO_MEMORY_START+size));
 
   return true;
 }
 
+static int writeVideoMemory(const char *text, int offset, db::IrCode *target)
+{
+  assert(text);
+  assert(target);
+
+  int i = 0;
+  for ( ; text[i]; ++i)
+    {
+      EMIT(PUSH, IMM(text[i]), CHAR_COMMENTS.texts[(unsigned char)text[i]]);
+      EMIT(POP, MEM(VIDEO_MEMORY_START+offset+i));
+    }
+
+  return offset + i;
+}
+
+static bool isText(const db::Token token)
+{
+  return token && (IS_STRING(token) || IS_ENDL(token));
+}
+
 static bool translateStatement(
                                db::Translator *translator,
                                db::Token token,
-                               FILE *target,
+                               db::IrCode *target,
                                int *error
                               )
 {
@@ -245,7 +409,7 @@ static bool translateStatement(
 static bool translateCall(
                           db::Translator *translator,
                           db::Token token,
-                          FILE *target,
+                          db::IrCode *target,
                           int *error
                          )
 {
@@ -255,28 +419,25 @@ static bool translateCall(
 
   START_TRANSLATE(Call);
 
-  fprintf(target, ";Save stack pointer\n"
-          "PUSH %s\n",
-          STACK_BOTTOM_ADDRESS);
+  COMMENT("Save stack pointer");
+  EMIT(PUSH, REG(STACK_BOTTOM_ADDRESS));
 
   if (token->left->left)
     if (!translateArgument(token->left->left, translator, target))
       ERROR(false);
 
-  fprintf(target, "CALL FUN_%s\n", NAME(token->left));
+  EMIT(CALL, LABEL("FUN", NAME(token->left)));
 
-  fprintf(target, ";Pop stack pointer\n");
-  fprintf(target,
-          "POP %s\n",
-          STACK_BOTTOM_ADDRESS);
+  COMMENT("Pop stack pointer");
+  EMIT(POP, REG(STACK_BOTTOM_ADDRESS));
 
   db::Token function =
     db::searchFunction(NAME(token->left), translator);
 
   if (IS_TYPE(function->left->right))
     {
-      fprintf(target, "PUSH %s\n", RETURN_FRACT_ADDRESS);
-      fprintf(target, "PUSH %s\n",   RETURN_INT_ADDRESS);
+      EMIT(PUSH, REG(RETURN_FRACT_ADDRESS));
+      EMIT(PUSH, REG(  RETURN_INT_ADDRESS));
     }
 
   END_TRANSLATE();
@@ -287,7 +448,7 @@ static bool translateCall(
 static bool translateReturn(
                             db::Translator *translator,
                             db::Token token,
-                            FILE *target,
+                            db::IrCode *target,
                             int *error
                            )
 {
@@ -300,20 +461,18 @@ static bool translateReturn(
       if (!translateToken(token->left, translator, target, error))
         ERROR(false);
 
-      fprintf(target, "POP %s\n",   RETURN_INT_ADDRESS);
-      fprintf(target, "POP %s\n", RETURN_FRACT_ADDRESS);
+      EMIT(POP, REG(  RETURN_INT_ADDRESS));
+      EMIT(POP, REG(RETURN_FRACT_ADDRESS));
     }
 
-  fprintf(target, ";Update stack pointer\n");
-  fprintf(target, "PUSH %s\n", STACK_BOTTOM_ADDRESS);
-  fprintf(target, "POP %s\n", STACK_POINTER_ADDRESS);
+  COMMENT("Update stack pointer");
+  EMIT(PUSH, REG(STACK_BOTTOM_ADDRESS));
+  EMIT(POP , REG(STACK_POINTER_ADDRESS));
 
-  fprintf(target, ";Pop return address\n");
-  fprintf(target, "PUSH [%d+%s]\n",
-          STACK_MEMORY_START,
-          STACK_POINTER_ADDRESS);
+  COMMENT("Pop return address");
+  EMIT(PUSH, MEM(STACK_MEMORY_START, STACK_POINTER_ADDRESS));
 
-  fprintf(target, "RET\n");
+  EMIT(RET);
 
   END_TRANSLATE();
 
@@ -323,7 +482,7 @@ static bool translateReturn(
 static bool translateIf(
                         db::Translator *translator,
                         db::Token token,
-                        FILE *target,
+                        db::IrCode *target,
                         int *error
                        )
 {
@@ -339,16 +498,13 @@ static bool translateIf(
 
   START_TRANSLATE(If);
 
-  static int ifCount = 0;
-  int currentIfNumber = ifCount++;
+  const char *name = translator->status.functionName;
+  int currentIfNumber = translator->status.ifCount++;
 
-  if (!translateToken(token->left, translator,target, error))
+  if (!translateCondition(translator, token->left, false, LABEL("ELSE", name, currentIfNumber),
+                          target, error))
     ERROR(false);
 
-  fprintf(target, "PUSH 0\n");
-  fprintf(target, "PUSH 0\n");
-  fprintf(target, "JE :ELSE_%6.6d\n\n", currentIfNumber);
-
   db::addVarTable(translator);
 
   if (IS_ELSE(token->right))
@@ -362,13 +518,12 @@ static bool translateIf(
         CLEAR_RESOURCES();
     }
 
-  size_t deltaOffset = 2*stack_top(&translator->varTables)->size;
-  translator->status.stackOffset -= (int)deltaOffset;
+  translator->status.stackOffset -= getScopeSize(translator);
 
   db::removeVarTable(translator);
 
-  fprintf(target, "JMP END_IF_%6.6d\n", currentIfNumber);
-  fprintf(target, "ELSE_%6.6d:\n", currentIfNumber);
+  EMIT(JMP, LABEL("END_IF", name, currentIfNumber));
+  EMIT(LABEL, LABEL("ELSE", name, currentIfNumber));
 
   if (IS_ELSE(token->right))
     {
@@ -377,13 +532,12 @@ static bool translateIf(
       if (!translateToken(token->right->right, translator,target, error))
         CLEAR_RESOURCES();
 
-      deltaOffset = 2*stack_top(&translator->varTables)->size;
-      translator->status.stackOffset -= (int)deltaOffset;
+      translator->status.stackOffset -= getScopeSize(translator);
 
       db::removeVarTable(translator);
     }
 
-  fprintf(target, "END_IF_%6.6d:\n", currentIfNumber);
+  EMIT(LABEL, LABEL("END_IF", name, currentIfNumber));
 
   END_TRANSLATE();
 
@@ -394,7 +548,7 @@ static bool translateIf(
 static bool translateOut(
                          db::Translator *translator,
                          db::Token token,
-                         FILE *target,
+                         db::IrCode *target,
                          int *error
                         )
 {
@@ -407,22 +561,45 @@ static bool translateOut(
   db::Token temp = token->left;
   for ( ; temp; temp = temp->right)
     {
+      // Adjacent literals and endl are written after each other and shown at once
+      if (translator->status.optimizationLevel >= 1 && isText(temp->left) &&
+          temp->right && isText(temp->right->left))
+        {
+          int size = 0;
+          for ( ; temp && isText(temp->left); temp = temp->right)
+            {
+              const char *text = (IS_STRING(temp->left) ? STRING(temp->left) : "\n");
+              if (size + (int)strlen(text) >= VIDEO_MEMORY_SIZE) break;
+
+              size = writeVideoMemory(text, size, target);
+            }
+
+          if (size)
+            {
+              EMIT(PUSH, IMM('\0'), CHAR_COMMENTS.texts['\0']);
+              EMIT(POP , MEM(VIDEO_MEMORY_START+size));
+              EMIT(SHOW);
+            }
+
+          if (!temp) break;
+        }
+
       if (!translateToken(temp->left, translator, target, error))
         ERROR(false);
 
       if (IS_STRING(temp->left))
-        fprintf(target, "SHOW\n");
+        EMIT(SHOW);
 
       else if(IS_ENDL(temp->left))
         {
-          fprintf(target, "PUSH %d; \\n\n", '\n');
-          fprintf(target, "POP [0]\n");
-          fprintf(target, "PUSH %d; \\0\n", '\0');
-          fprintf(target, "POP [1]\n");
-          fprintf(target, "SHOW\n");
+          EMIT(PUSH, IMM('\n'), "\\n");
+          EMIT(POP , MEM(VIDEO_MEMORY_START  ));
+          EMIT(PUSH, IMM('\0'), "\\0");
+          EMIT(POP , MEM(VIDEO_MEMORY_START+1));
+          EMIT(SHOW);
         }
       else
-        fprintf(target, "OUT\n");
+        EMIT(OUT);
     }
 
   END_TRANSLATE();
@@ -433,7 +610,7 @@ static bool translateOut(
 static bool translateIn(
                         db::Translator *translator,
                         db::Token token,
-                        FILE *target,
+                        db::IrCode *target,
                         int *error
                        )
 {
@@ -450,21 +627,17 @@ static bool translateIn(
 
       if (!var) HANDLE_ERROR("Unknown variable: %s", NAME(temp->left));
 
-      fprintf(target, "IN\n");
+      EMIT(IN);
 
       if (var->isGlobal)
         {
-          fprintf(target, "POP [%d]\n", GLOBAL_MEMORY_START+(var->number*2  ));
-          fprintf(target, "POP [%d]\n", GLOBAL_MEMORY_START+(var->number*2+1));
+          EMIT(POP, MEM(GLOBAL_MEMORY_START+(var->number*2  )));
+          EMIT(POP, MEM(GLOBAL_MEMORY_START+(var->number*2+1)));
         }
       else
         {
-          fprintf(target, "POP [%d+%s]\n",
-                  STACK_MEMORY_START+(var->number  ),
-                  STACK_BOTTOM_ADDRESS);
-          fprintf(target, "POP [%d+%s]\n",
-                  STACK_MEMORY_START+(var->number+1),
-                  STACK_BOTTOM_ADDRESS);
+          EMIT(POP, MEM(STACK_MEMORY_START+(var->number  ), STACK_BOTTOM_ADDRESS));
+          EMIT(POP, MEM(STACK_MEMORY_START+(var->number+1), STACK_BOTTOM_ADDRESS));
         }
     }
   END_TRANSLATE();
@@ -475,7 +648,7 @@ static bool translateIn(
 static bool translateInt(
                          db::Translator *translator,
                          db::Token token,
-                         FILE *target,
+                         db::IrCode *target,
                          int *error
                         )
 {
@@ -488,18 +661,16 @@ static bool translateInt(
   if (!translateToken(token->left, translator, target, error))
     ERROR(false);
 
-  fprintf(target,
-          ";Turn off real-calc\n"
-          "PUSH 0\n"
-          "POP rex\n");
-  fprintf(target, "SWAP\n");
-  fprintf(target, "POP [0]\n");
-  fprintf(target, "PUSH 0\n");
-  fprintf(target, "SWAP\n");
-  fprintf(target,
-          ";Turn on real-calc\n"
-          "PUSH 1\n"
-          "POP rex\n");
+  COMMENT("Turn off real-calc");
+  EMIT(PUSH, IMM(0));
+  EMIT(POP , REG(REAL_CALC_ADDRESS));
+  EMIT(SWAP);
+  EMIT(POP , MEM(VIDEO_MEMORY_START));
+  EMIT(PUSH, IMM(0));
+  EMIT(SWAP);
+  COMMENT("Turn on real-calc");
+  EMIT(PUSH, IMM(1));
+  EMIT(POP , REG(REAL_CALC_ADDRESS));
 
   END_TRANSLATE();
 
@@ -509,7 +680,7 @@ static bool translateInt(
 static bool translateWhile(
                            db::Translator *translator,
                            db::Token token,
-                           FILE *target,
+                           db::IrCode *target,
                            int *error
                           )
 {
@@ -520,39 +691,246 @@ static bool translateWhile(
 
   START_TRANSLATE(While);
 
-  static int whileCount = 0;
+  const char *name = translator->status.functionName;
+  int whileCount = translator->status.whileCount++;
 
-  fprintf(target, "WHILE_%6.6d:\n\n", whileCount);
+  EMIT(LABEL, LABEL("WHILE", name, whileCount));
 
-  if (!translateToken(token->left, translator, target, error))
+  if (!translateCondition(translator, token->left, false, LABEL("END_WHILE", name, whileCount),
+                          target, error))
     ERROR(false);
 
-  fprintf(target, "PUSH 0\n");
-  fprintf(target, "PUSH 0\n");
-  fprintf(target, "JE :END_WHILE_%6.6d\n\n", whileCount);
-
   db::addVarTable(translator);
 
   if (!translateToken(token->right, translator, target, error))
     CLEAR_RESOURCES();
 
-  size_t deltaOffset = 2*stack_top(&translator->varTables)->size;
-  translator->status.stackOffset -= (int)deltaOffset;
+  translator->status.stackOffset -= getScopeSize(translator);
 
   db::removeVarTable(translator);
 
-  fprintf(target, "JMP WHILE_%6.6d\n", whileCount);
-  fprintf(target, "END_WHILE_%6.6d:\n", whileCount++);
+  EMIT(JMP, LABEL("WHILE", name, whileCount));
+  EMIT(LABEL, LABEL("END_WHILE", name, whileCount));
 
   END_TRANSLATE();
 
   return true;
 }
 
+static bool translateCondition(
+                               db::Translator *translator,
+                               db::Token token,
+                               bool isJumpIfTrue,
+                               db::IrOperand label,
+                               db::IrCode *target,
+                               int *error
+                              )
+{
+  CHECK_ARGUMENTS();
+
+  using enum db::Opcode;
+
+  if (translator->status.optimizationLevel >= 1 && IS_STATEMENT(token))
+    {
+      switch (STATEMENT(token))
+        {
+        case db::STATEMENT_EQUAL:
+          return translateCompare(translator, token, isJumpIfTrue ? JE  : JNE, label, target, error);
+        case db::STATEMENT_NOT_EQUAL:
+          return translateCompare(translator, token, isJumpIfTrue ? JNE : JE , label, target, error);
+        case db::STATEMENT_LESS:
+          return translateCompare(translator, token, isJumpIfTrue ? JB  : JAE, label, target, error);
+        case db::STATEMENT_GREATER:
+          return translateCompare(translator, token, isJumpIfTrue ? JA  : JBE, label, target, error);
+        case db::STATEMENT_NOT:
+          if (!token->left) HANDLE_ERROR("Expected that NOT has at least one argument");
+
+          return translateCondition(translator, token->left, !isJumpIfTrue, label, target, error);
+        case db::STATEMENT_AND:
+        case db::STATEMENT_OR:
+          {
+            if (!token->left || !token->right)
+              HANDLE_ERROR("Expected that logic operator has two arguments");
+
+            // Second operand may be skipped, so it must be pure, otherwise order is kept
+            db::Token first  = token->left ;
+            db::Token second = token->right;
+            if (!db::isPureNode(second))
+              {
+                first  = token->right;
+                second = token->left ;
+              }
+
+            if (!db::isPureNode(second)) break;
+
+            // Result of & is known if first is false, result of | is known if first is true
+            bool isKnownIfTrue = IS_OR(token);
+            if (isKnownIfTrue == isJumpIfTrue)
+              {
+                if (!translateCondition(translator, first , isJumpIfTrue, label, target, error))
+                  ERROR(false);
+
+                return translateCondition(translator, second, isJumpIfTrue, label, target, error);
+              }
+
+            db::IrOperand skip =
+              LABEL("SKIP", translator->status.functionName, translator->status.skipCount++);
+
+            if (!translateCondition(translator, first , isKnownIfTrue, skip , target, error))
+              ERROR(false);
+            if (!translateCondition(translator, second, isJumpIfTrue , label, target, error))
+              ERROR(false);
+
+            EMIT(LABEL, skip);
+
+            return true;
+          }
+        default: break;
+        }
+    }
+
+  if (!translateToken(token, translator, target, error))
+    ERROR(false);
+
+  EMIT(PUSH, IMM(0));
+  EMIT(PUSH, IMM(0));
+  db::emitIr(target, isJumpIfTrue ? JNE : JE, label);
+
+  return true;
+}
+
+static bool translateCompare(
+                             db::Translator *translator,
+                             db::Token token,
+                             db::Opcode jump,
+                             db::IrOperand label,
+                             db::IrCode *target,
+                             int *error
+                            )
+{
+  CHECK_ARGUMENTS();
+
+  if (!token->right) HANDLE_ERROR("Expected that comparison has first argument");
+  if (!token->left ) HANDLE_ERROR("Expected that comparison has second argument");
+
+  if (!translateToken(token->right, translator, target, error))
+    ERROR(false);
+  if (!translateToken(token->left , translator, target, error))
+    ERROR(false);
+
+  db::emitIr(target, jump, label);
+
+  return true;
+}
+
+static bool translateInteger(
+                             db::Translator *translator,
+                             db::Token token,
+                             db::IrCode *target,
+                             int *error
+                            )
+{
+  CHECK_ARGUMENTS();
+
+  if (IS_NUM(token))
+    {
+      EMIT(PUSH, IMM(INT(NUMBER(token))));
+
+      return true;
+    }
+
+  if (IS_NAME(token))
+    {
+      db::Variable *var = db::searchVariable(NAME(token), translator, false);
+      if (!var || !var->isIntegral) HANDLE_ERROR("Expected integral variable: %s", NAME(token));
+
+      EMIT(PUSH, MEM(STACK_MEMORY_START+(var->number), STACK_BOTTOM_ADDRESS));
+
+      return true;
+    }
+
+  if (!IS_STATEMENT(token)) HANDLE_ERROR("Expected integral expression");
+
+  switch (STATEMENT(token))
+    {
+    case db::STATEMENT_ADD:
+    case db::STATEMENT_SUB:
+    case db::STATEMENT_MUL:
+      {
+        if (token->right && !translateInteger(translator, token->right, target, error))
+          ERROR(false);
+        if (!translateInteger(translator, token->left, target, error))
+          ERROR(false);
+        if (!token->right)
+          EMIT(PUSH, IMM(0));
+
+        db::emitIr(target, IS_MUL(token) ? db::Opcode::MUL :
+                           IS_ADD(token) ? db::Opcode::ADD : db::Opcode::SUB);
+
+        return true;
+      }
+    case db::STATEMENT_INT:
+      {
+        if (!token->left) HANDLE_ERROR("Int hasn`t value");
+
+        // Only int word of real value is kept like in translateInt
+        COMMENT("Turn on real-calc");
+        EMIT(PUSH, IMM(1));
+        EMIT(POP , REG(REAL_CALC_ADDRESS));
+        if (!translateToken(token->left, translator, target, error))
+          ERROR(false);
+        COMMENT("Turn off real-calc");
+        EMIT(PUSH, IMM(0));
+        EMIT(POP , REG(REAL_CALC_ADDRESS));
+        EMIT(SWAP);
+        EMIT(POP , MEM(VIDEO_MEMORY_START));
+
+        return true;
+      }
+    default:
+      HANDLE_ERROR("Expected integral expression");
+    }
+}
+
+static bool translateIntegerStore(
+                                  db::Translator *translator,
+                                  db::Token token,
+                                  int number,
+                                  db::IrCode *target,
+                                  int *error
+                                 )
+{
+  CHECK_ARGUMENTS();
+
+  // Moves of words don`t depend on mode
+  bool isOperator = !IS_NUM(token) && !IS_NAME(token);
+
+  if (isOperator)
+    {
+      COMMENT("Turn off real-calc");
+      EMIT(PUSH, IMM(0));
+      EMIT(POP , REG(REAL_CALC_ADDRESS));
+    }
+
+  if (!translateInteger(translator, token, target, error))
+    ERROR(false);
+
+  EMIT(POP, MEM(STACK_MEMORY_START+(number), STACK_BOTTOM_ADDRESS));
+
+  if (isOperator)
+    {
+      COMMENT("Turn on real-calc");
+      EMIT(PUSH, IMM(1));
+      EMIT(POP , REG(REAL_CALC_ADDRESS));
+    }
+
+  return true;
+}
+
 static bool translateVariable(
                               db::Translator *translator,
                               db::Token token,
-                              FILE *target,
+                              db::IrCode *target,
                               int *error
                              )
 {
@@ -565,20 +943,30 @@ static bool translateVariable(
 
   int number = translator->status.stackOffset;
 
-  translator->status.stackOffset += 2;
+  bool isIntegral = db::isIntegerDeclaration(&translator->status.integers, token);
+
+  translator->status.stackOffset += (isIntegral ? 1 : 2);
 
   if (!db::addVariable(NAME(token->left), false, translator, number, error))
     HANDLE_ERROR("Redeclareted of variable: %s", NAME(token->left));
 
+  if (isIntegral)
+    {
+      db::searchVariable(NAME(token->left), translator, true)->isIntegral = true;
+
+      if (!translateIntegerStore(translator, token->right, number, target, error))
+        ERROR(false);
+
+      END_TRANSLATE();
+
+      return true;
+    }
+
   if (!translateToken(token->right, translator, target, error))
     ERROR(false);
 
-  fprintf(target, "POP [%d+%s]\n",
-          STACK_MEMORY_START+(number  ),
-          STACK_BOTTOM_ADDRESS);
-  fprintf(target, "POP [%d+%s]\n",
-          STACK_MEMORY_START+(number+1),
-          STACK_BOTTOM_ADDRESS);
+  EMIT(POP, MEM(STACK_MEMORY_START+(number  ), STACK_BOTTOM_ADDRESS));
+  EMIT(POP, MEM(STACK_MEMORY_START+(number+1), STACK_BOTTOM_ADDRESS));
 
   END_TRANSLATE();
 
@@ -588,7 +976,7 @@ static bool translateVariable(
 static bool translateAssignment(
                                 db::Translator *translator,
                                 db::Token token,
-                                FILE *target,
+                                db::IrCode *target,
                                 int *error
                                )
 {
@@ -600,22 +988,27 @@ static bool translateAssignment(
 
   if (!var) HANDLE_ERROR("Unknown variable: %s", NAME(token->left));
 
+  if (var->isIntegral)
+    {
+      if (!translateIntegerStore(translator, token->right, var->number, target, error))
+        ERROR(false);
+
+      END_TRANSLATE();
+
+      return true;
+    }
+
   translateToken(token->right, translator,target, error);
-  //fprintf(target, "COPY\n");
 
   if (var->isGlobal)
     {
-      fprintf(target, "POP [%d]\n", GLOBAL_MEMORY_START+(var->number*2  ));
-      fprintf(target, "POP [%d]\n", GLOBAL_MEMORY_START+(var->number*2+1));
+      EMIT(POP, MEM(GLOBAL_MEMORY_START+(var->number*2  )));
+      EMIT(POP, MEM(GLOBAL_MEMORY_START+(var->number*2+1)));
     }
   else
     {
-      fprintf(target, "POP [%d+%s]\n",
-              STACK_MEMORY_START+(var->number  ),
-              STACK_BOTTOM_ADDRESS);
-      fprintf(target, "POP [%d+%s]\n",
-              STACK_MEMORY_START+(var->number+1),
-              STACK_BOTTOM_ADDRESS);
+      EMIT(POP, MEM(STACK_MEMORY_START+(var->number  ), STACK_BOTTOM_ADDRESS));
+      EMIT(POP, MEM(STACK_MEMORY_START+(var->number+1), STACK_BOTTOM_ADDRESS));
     }
   END_TRANSLATE();
 
@@ -624,47 +1017,130 @@ static bool translateAssignment(
 
 bool db::translate(db::Translator *translator, FILE *target, int *error)
 {
-  if (!translator) ERROR(false);
-
-  fprintf(target,
-          ";Turn on real-calc\n"
-          "PUSH 1\n"
-          "POP rex\n"
-          ";End\n\n");
-  fprintf(target,
-          ";Init stack pointer\n"
-          "PUSH 0\n"
-          "POP %s\n"
-          "PUSH 0\n"
-          "POP %s\n"
-          ";End\n\n",
-          STACK_POINTER_ADDRESS,
-          STACK_BOTTOM_ADDRESS);
+  if (!translator || !target) ERROR(false);
+
+  db::IrCode code{};
+  db::initIr(&code);
 
   int errorCode = 0;
 
-  translatrGlobaleVariable(translator, target, &errorCode);
-  if (errorCode) ERROR(false);
+  buildStart(translator, &code, &errorCode);
 
-  fprintf(target,
-          ";Call main\n"
-          "CALL FUN_main\n"
-          ";End\n\n");
+  if (!errorCode && !code.isFailed) db::printIr(&code, target, &errorCode);
 
-  fprintf(target,
-          "HLT\n"
-          ";End\n\n");
+  db::destroyIr(&code);
+  if (errorCode || code.isFailed) ERROR(false);
 
   translateFunctions(translator, target, &errorCode);
   if (errorCode) ERROR(false);
 
+  FILE *log = getLogFile();
+  if (log && translator->status.optimizationLevel >= 1) db::dumpPeepholeStatistics(log);
+
   return true;
 }
 
+bool db::translateObject(db::Translator *translator, FILE *target, FILE *listing, int *error)
+{
+  if (!translator || !target) ERROR(false);
+
+  db::IrCode code{};
+  db::initIr(&code);
+
+  int errorCode = 0;
+
+  buildStart(translator, &code, &errorCode);
+
+  size_t size = translator->functions.size;
+
+  db::IrCode *codes = (db::IrCode *)calloc(size + 1, sizeof(db::IrCode));
+  if (!codes) errorCode = -1;
+
+  if (!errorCode) buildFunctions(translator, codes, nullptr, &errorCode);
+
+  for (size_t i = 0; i < size && codes; ++i)
+    {
+      if (!errorCode && !code.isFailed) db::appendIr(&code, codes + i, &errorCode);
+
+      db::destroyIr(codes + i);
+    }
+
+  free(codes);
+
+  if (!errorCode && !code.isFailed) db::assembleIr(&code, target, listing, &errorCode);
+
+  db::destroyIr(&code);
+  if (errorCode || code.isFailed) ERROR(false);
+
+  FILE *log = getLogFile();
+  if (log && translator->status.optimizationLevel >= 1) db::dumpPeepholeStatistics(log);
+
+  return true;
+}
+
+static void buildStart(db::Translator *translator, db::IrCode *target, int *error)
+{
+  if (!translator || !target) ERROR();
+
+  int errorCode = 0;
+
+  translator->status.functionName = "$global";
+
+  translateStart(translator, target, &errorCode);
+  if (!errorCode && !target->isFailed && translator->status.optimizationLevel >= 1)
+    db::optimizePeephole(target, &errorCode);
+
+  if (errorCode) ERROR();
+}
+
+static void buildFunction(db::Translator *translator, db::Function *function, db::IrCode *target, int *error)
+{
+  if (!translator || !function || !target) ERROR();
+
+  int errorCode = 0;
+
+  translateFunction(translator, function, target, &errorCode);
+  if (!errorCode && !target->isFailed && translator->status.optimizationLevel >= 2)
+    db::allocateRegisters(target, &errorCode);
+  if (!errorCode && !target->isFailed && translator->status.optimizationLevel >= 1)
+    db::optimizePeephole(target, &errorCode);
+
+  if (errorCode) ERROR();
+}
+
+static void translateStart(db::Translator *translator, db::IrCode *target, int *error)
+{
+  if (!translator || !target) ERROR();
+
+  COMMENT("Turn on real-calc");
+  EMIT(PUSH, IMM(1));
+  EMIT(POP , REG(REAL_CALC_ADDRESS));
+  COMMENT("End");
+
+  COMMENT("Init stack pointer");
+  EMIT(PUSH, IMM(0));
+  EMIT(POP , REG(STACK_POINTER_ADDRESS));
+  EMIT(PUSH, IMM(0));
+  EMIT(POP , REG(STACK_BOTTOM_ADDRESS));
+  COMMENT("End");
+
+  int errorCode = 0;
+
+  translatrGlobaleVariable(translator, target, &errorCode);
+  if (errorCode) ERROR();
+
+  COMMENT("Call main");
+  EMIT(CALL, LABEL("FUN", "main"));
+  COMMENT("End");
+
+  EMIT(HLT);
+  COMMENT("End");
+}
+
 static bool translateToken(
                            const db::Token token,
                            db::Translator *translator,
-                           FILE *target,
+                           db::IrCode *target,
                            int *error
                           )
 {
@@ -703,6 +1179,7 @@ static bool translateToken(
           case db::STATEMENT_EQUAL:     TRANSLATE_BINARY(EQL    ); break;
           case db::STATEMENT_LESS:      TRANSLATE_BINARY(LESS   ); break;
           case db::STATEMENT_GREATER:   TRANSLATE_BINARY(GREATER); break;
+          case db::STATEMENT_NOT:       TRANSLATE_NOT();           break;
 
           case db::STATEMENT_COMPOUND:
             if (!translateStatement(translator, token, target, error))
@@ -760,7 +1237,7 @@ static bool translateToken(
 }
 
 static void
-translatrGlobaleVariable(db::Translator *translator, FILE *target, int *error)
+translatrGlobaleVariable(db::Translator *translator, db::IrCode *target, int *error)
 {
   if (!translator || !target) ERROR();
 
@@ -768,7 +1245,7 @@ translatrGlobaleVariable(db::Translator *translator, FILE *target, int *error)
   db::VarTable *table = stack_get(&translator->varTables, (unsigned)0, &errorCode);
   if (errorCode) ERROR();
 
-  fprintf(target, ";Start Global Var/Val initilization\n");
+  COMMENT("Start Global Var/Val initilization");
 
   db::Token token = translator->grammar.root;
   for (int i = 0; token; token = token->right)
@@ -777,78 +1254,285 @@ translatrGlobaleVariable(db::Translator *translator, FILE *target, int *error)
 
       int num = table->table[i++].number;
 
-      fprintf(target, ";%s\n", NAME(token->left->left));
+      COMMENT(NAME(token->left->left));
       translateToken(token->left->right, translator, target, error);
-      fprintf(
-              target,
-              "POP [%d]\n"
-              "POP [%d]\n",
-              GLOBAL_MEMORY_START+(num*2  ),
-              GLOBAL_MEMORY_START+(num*2+1)
-             );
+      EMIT(POP, MEM(GLOBAL_MEMORY_START+(num*2  )));
+      EMIT(POP, MEM(GLOBAL_MEMORY_START+(num*2+1)));
     }
 
-  fprintf(target, ";End Global Var/Val initilization\n\n");
+  COMMENT("End Global Var/Val initilization");
 }
 
 static void translateFunctions(db::Translator *translator, FILE *target, int *error)
 {
   if (!translator || !target) ERROR();
 
-  for (size_t i = 0; i < translator->functions.size; ++i)
+  db::AsmCache *cache = translator->status.cache;
+  db::hash_t environment = (cache ? hashEnvironment(translator) : 0);
+
+  size_t size = translator->functions.size;
+
+  db::IrCode *codes  = (db::IrCode *)calloc(size + 1, sizeof(db::IrCode));
+  db::hash_t *hashes = (db::hash_t *)calloc(size + 1, sizeof(db::hash_t));
+  bool *isCached     = (bool       *)calloc(size + 1, sizeof(bool));
+  // Copies of found chunks, texts are owned by cache and aren`t moved by new chunks
+  db::AsmChunk *chunks = (db::AsmChunk *)calloc(size + 1, sizeof(db::AsmChunk));
+
+  int errorCode = (codes && hashes && isCached && chunks ? 0 : -1);
+
+  for (size_t i = 0; i < size && cache && !errorCode; ++i)
     {
-      db::Function *function = translator->functions.table+i;
+      hashes[i] = db::hashNode(translator->functions.table[i].token, environment);
 
-      int offset = 1;
-      fprintf(target,
-              ";Function\nFUN_%s:\n"
-              ";Save return address\nPOP [%d+%s]\n",
-              function->name,
-              STACK_MEMORY_START,
-              STACK_POINTER_ADDRESS);
+      const db::AsmChunk *chunk =
+        db::searchAsmChunk(cache, hashes[i], translator->functions.table[i].name);
 
-      db::addVarTable(translator);
+      isCached[i] = chunk != nullptr;
+      if (chunk) chunks[i] = *chunk;
+    }
+
+  if (!errorCode) buildFunctions(translator, codes, isCached, &errorCode);
 
-      offset +=
-        allocateParameters(function->token->left->left, translator, target);
-      translator->status.stackOffset = offset;
-      offset +=
-        allocateVariable  (function->token->right     , translator, offset, target);
-      fprintf(target,
-              ";Save stack pointer\n"
-              "PUSH %s\n" "POP %s\n"
+  // Code is written in order of declarations whatever the order of generation is
+  for (size_t i = 0; i < size && !errorCode; ++i)
+    {
+      if (isCached[i])
+        {
+          fwrite(chunks[i].text, sizeof(char), chunks[i].size, target);
 
-              ";Turn off real-calc\n"
-              "PUSH 0\n" "POP rex\n"
+          continue;
+        }
+
+      if (!cache)
+        {
+          db::printIr(codes + i, target);
 
-              ";Update stack pointer\n"
-              "PUSH %d\n" "PUSH %s\n" "ADD\n" "POP %s\n"
+          continue;
+        }
+
+      char  *text = nullptr;
+      size_t textSize = 0;
+
+      FILE *buffer = open_memstream(&text, &textSize);
+      if (!buffer) { errorCode = -1; break; }
+
+      db::printIr(codes + i, buffer);
+      fclose(buffer);
+
+      fwrite(text, sizeof(char), textSize, target);
+
+      if (!db::addAsmChunk(cache, hashes[i], translator->functions.table[i].name, text, textSize))
+        errorCode = -1;
+    }
+
+  for (size_t i = 0; i < size && codes; ++i)
+    if (!isCached || !isCached[i]) db::destroyIr(codes + i);
+
+  free(codes);
+  free(hashes);
+  free(isCached);
+  free(chunks);
+
+  if (errorCode) ERROR();
+}
+
+static void buildFunctions(db::Translator *translator, db::IrCode *codes, const bool *isSkipped, int *error)
+{
+  if (!translator || !codes) ERROR();
+
+  size_t size = translator->functions.size;
+
+  for (size_t i = 0; i < size; ++i)
+    if (!isSkipped || !isSkipped[i]) db::initIr(codes + i);
+
+  size_t threadCount = (size_t)translator->status.threadCount;
+  if (!threadCount)
+    {
+      long processors = sysconf(_SC_NPROCESSORS_ONLN);
+      threadCount = (processors > 0 ? (size_t)processors : 1);
+    }
 
-              ";Turn on real-calc\n"
-              "PUSH 1\n" "POP rex\n",
-              STACK_POINTER_ADDRESS, STACK_BOTTOM_ADDRESS,
-              offset, STACK_POINTER_ADDRESS, STACK_POINTER_ADDRESS);
+  if (threadCount > size) threadCount = size;
+
+  unsigned stackError = 0;
+  db::VarTable *globals = stack_get(&translator->varTables, 0, &stackError);
+  if (stackError) ERROR();
+
+  CodegenJob job = {
+    .translator = translator,
+    .codes      = codes,
+    .isSkipped  = isSkipped,
+    .globals    = globals
+  };
+
+  pthread_t *threads = (pthread_t *)calloc(threadCount + 1, sizeof(pthread_t));
+  if (!threads) ERROR();
+
+  // Current thread is a worker too
+  size_t started = 0;
+  while (started + 1 < threadCount &&
+         !pthread_create(threads + started, nullptr, generateFunctions, &job))
+    ++started;
+
+  generateFunctions(&job);
+
+  for (size_t i = 0; i < started; ++i)
+    pthread_join(threads[i], nullptr);
+
+  free(threads);
+
+  if (job.isFailed) ERROR();
+
+  FILE *log = getLogFile();
+  if (log && translator->status.optimizationLevel >= 2)
+    for (size_t i = 0; i < size; ++i)
+      {
+        if (isSkipped && isSkipped[i]) continue;
+
+        db::ControlFlow flow{};
+        db::buildControlFlow(&flow, codes + i);
+
+        fprintf(log, "<pre>Function %s</pre>\n", translator->functions.table[i].name);
+        db::dumpControlFlow(&flow, log);
+
+        db::destroyControlFlow(&flow);
+      }
+}
+
+static void *generateFunctions(void *argument)
+{
+  CodegenJob *job = (CodegenJob *)argument;
+  assert(job);
+
+  // Worker shares tables of translator, but has own status and scopes of locals
+  db::Translator worker = *job->translator;
+  worker.varTables = {};
+
+  unsigned stackError = 0;
+  stack_init(&worker.varTables, 10, &stackError);
+  if (!stackError)
+    stack_push(&worker.varTables, job->globals, &stackError);
+
+  if (stackError)
+    {
+      __atomic_store_n(&job->isFailed, true, __ATOMIC_RELAXED);
+      return nullptr;
+    }
+
+  for (;;)
+    {
+      size_t i = __atomic_fetch_add(&job->next, 1, __ATOMIC_RELAXED);
+      if (i >= worker.functions.size) break;
+
+      if (job->isSkipped && job->isSkipped[i]) continue;
 
       int errorCode = 0;
-      translateToken(function->token->right, translator, target, &errorCode);
-      db::removeVarTable(translator);
+      buildFunction(&worker, worker.functions.table+i, job->codes + i, &errorCode);
+
+      if (errorCode || job->codes[i].isFailed)
+        __atomic_store_n(&job->isFailed, true, __ATOMIC_RELAXED);
+    }
+
+  stack_destroy(&worker.varTables);
+
+  return nullptr;
+}
+
+static void translateFunction(db::Translator *translator, db::Function *function, db::IrCode *target, int *error)
+{
+  if (!translator || !function || !target) ERROR();
+
+  translator->status.functionName = function->name;
+  translator->status.ifCount      = 0;
+  translator->status.whileCount   = 0;
+  translator->status.skipCount    = 0;
+
+  if (translator->status.optimizationLevel >= 2)
+    db::inferIntegers(function, &translator->status.integers);
+
+  int offset = 1;
+  COMMENT("Function");
+  EMIT(LABEL, LABEL("FUN", function->name));
+  COMMENT("Save return address");
+  EMIT(POP, MEM(STACK_MEMORY_START, STACK_POINTER_ADDRESS));
+
+  db::addVarTable(translator);
 
-      if (errorCode) ERROR();
+  offset +=
+    allocateParameters(function->token->left->left, translator, target);
+  translator->status.stackOffset = offset;
+  offset +=
+    allocateVariable  (function->token->right     , translator, offset, target);
 
-      size_t deltaOffset = 2*stack_top(&translator->varTables)->size;
-      translator->status.stackOffset -= (int)deltaOffset + 1;
+  COMMENT("Save stack pointer");
+  EMIT(PUSH, REG(STACK_POINTER_ADDRESS));
+  EMIT(POP , REG(STACK_BOTTOM_ADDRESS));
 
-      fprintf(target,
-              ";Update stack pointer\n"
-              "PUSH %s\nPOP %s\n"
-              ";Pop return address\n"
-              "PUSH [%d+%s]\n" "RET\n;End\n\n",
-              STACK_BOTTOM_ADDRESS, STACK_POINTER_ADDRESS,
-              STACK_MEMORY_START, STACK_POINTER_ADDRESS);
+  COMMENT("Turn off real-calc");
+  EMIT(PUSH, IMM(0));
+  EMIT(POP , REG(REAL_CALC_ADDRESS));
+
+  COMMENT("Update stack pointer");
+  EMIT(PUSH, IMM(offset));
+  EMIT(PUSH, REG(STACK_POINTER_ADDRESS));
+  EMIT(ADD);
+  EMIT(POP , REG(STACK_POINTER_ADDRESS));
+
+  COMMENT("Turn on real-calc");
+  EMIT(PUSH, IMM(1));
+  EMIT(POP , REG(REAL_CALC_ADDRESS));
+
+  int errorCode = 0;
+  translateToken(function->token->right, translator, target, &errorCode);
+  db::removeVarTable(translator);
+  db::destroyIntegerTypes(&translator->status.integers);
+
+  if (errorCode) ERROR();
+
+  size_t deltaOffset = 2*stack_top(&translator->varTables)->size;
+  translator->status.stackOffset -= (int)deltaOffset + 1;
+
+  COMMENT("Update stack pointer");
+  EMIT(PUSH, REG(STACK_BOTTOM_ADDRESS));
+  EMIT(POP , REG(STACK_POINTER_ADDRESS));
+  COMMENT("Pop return address");
+  EMIT(PUSH, MEM(STACK_MEMORY_START, STACK_POINTER_ADDRESS));
+  EMIT(RET);
+  COMMENT("End");
+}
+
+static db::hash_t hashEnvironment(const db::Translator *translator)
+{
+  assert(translator);
+
+  db::hash_t hash = db::combineHash(0, &CACHE_VERSION, sizeof(CACHE_VERSION));
+  hash = db::combineHash(hash, &translator->status.optimizationLevel,
+                         sizeof(translator->status.optimizationLevel));
+
+  unsigned errorCode = 0;
+  db::VarTable *table = stack_get(&translator->varTables, (unsigned)0, &errorCode);
+  if (errorCode) return hash;
+
+  for (size_t i = 0; i < table->size; ++i)
+    {
+      hash = db::combineHash(hash, table->table[i].name, strlen(table->table[i].name));
+      hash = db::combineHash(hash, &table->table[i].number, sizeof(table->table[i].number));
+    }
+
+  for (size_t i = 0; i < translator->functions.size; ++i)
+    {
+      const db::Function *function = translator->functions.table+i;
+
+      bool isType = IS_TYPE(function->token->left->right);
+
+      hash = db::combineHash(hash, function->name, strlen(function->name));
+      hash = db::combineHash(hash, &isType, sizeof(isType));
     }
+
+  return hash;
 }
 
-static bool translateArgument(db::Token block, db::Translator *translator, FILE *target)
+static bool translateArgument(db::Token block, db::Translator *translator, db::IrCode *target)
 {
   if (!block) return false;
 
@@ -863,7 +1547,7 @@ static bool translateArgument(db::Token block, db::Translator *translator, FILE
   return true;
 }
 
-static int allocateParameters(db::Token block, db::Translator *translator, FILE *target)
+static int allocateParameters(db::Token block, db::Translator *translator, db::IrCode *target)
 {
   int offset = 1;
 
@@ -876,15 +1560,9 @@ static int allocateParameters(db::Token block, db::Translator *translator, FILE
                       offset
                      );
 
-      fprintf(target,
-              ";Get %d parameter\n"
-              "POP [%d+%s]\n"
-              "POP [%d+%s]\n",
-              offset/2-1,
-              STACK_MEMORY_START+offset,
-              STACK_POINTER_ADDRESS,
-              STACK_MEMORY_START+offset+1,
-              STACK_POINTER_ADDRESS);
+      NOTE("Get parameter", IMM(offset/2));
+      EMIT(POP, MEM(STACK_MEMORY_START+offset  , STACK_POINTER_ADDRESS));
+      EMIT(POP, MEM(STACK_MEMORY_START+offset+1, STACK_POINTER_ADDRESS));
 
       offset += 2;
     }
@@ -892,22 +1570,24 @@ static int allocateParameters(db::Token block, db::Translator *translator, FILE
   return offset;
 }
 
-static int allocateVariable(db::Token block, db::Translator *translator, int startIndex, FILE *target)
+static int allocateVariable(db::Token block, db::Translator *translator, int startIndex, db::IrCode *target)
 {
   assert(startIndex >= 0);
 
-  int variableIndex = allocateBlock(block, translator, startIndex, target);
-  allocateBlock(nullptr, nullptr, 0, nullptr);
+  translator->status.blockCount       = 0;
+  translator->status.variableCount    = 0;
+  translator->status.maxVariableCount = 0;
+
+  allocateBlock(block, translator, startIndex, target);
 
-  return variableIndex*2;
+  return translator->status.maxVariableCount;
 }
 
-static int allocateBlock(db::Token block, db::Translator *translator, int startIndex, FILE *target)
+static int allocateBlock(db::Token block, db::Translator *translator, int startIndex, db::IrCode *target)
 {
-  static int numOfBlock = 0;
-  int currentBlockNum = numOfBlock++;
+  if (!block) return translator->status.variableCount;
 
-  if (!block) { numOfBlock = 0; allocateInstruction(nullptr, nullptr, 0, 0, nullptr); return -1; }
+  int currentBlockNum = translator->status.blockCount++;
 
   if (!IS_COMP(block)) return allocateInstruction(block, translator, startIndex, currentBlockNum, target);
 
@@ -919,11 +1599,31 @@ static int allocateBlock(db::Token block, db::Translator *translator, int startI
   return finalVariableCount;
 }
 
-static int allocateInstruction(db::Token token, db::Translator *translator, int startIndex, int blockNumber, FILE *target)
+static int getScopeSize(const db::Translator *translator)
 {
-  static int variableCount = 0;
+  assert(translator);
+
+  const db::VarTable *table = stack_top(&translator->varTables);
 
-  if (!token) { variableCount = 0; return -1; }
+  int size = 0;
+  for (size_t i = 0; i < table->size; ++i)
+    size += (table->table[i].isIntegral ? 1 : 2);
+
+  return size;
+}
+
+static void allocateScope(db::Token block, db::Translator *translator, int startIndex, db::IrCode *target)
+{
+  int variableCount = translator->status.variableCount;
+
+  allocateBlock(block, translator, startIndex, target);
+
+  translator->status.variableCount = variableCount;
+}
+
+static int allocateInstruction(db::Token token, db::Translator *translator, int startIndex, int blockNumber, db::IrCode *target)
+{
+  if (!token) return translator->status.variableCount;
 
   if (IS_STATEMENT(token))
     switch (STATEMENT(token))
@@ -934,34 +1634,33 @@ static int allocateInstruction(db::Token token, db::Translator *translator, int
       case db::STATEMENT_IF:
         if (IS_ELSE(token->right))
           {
-            allocateBlock(token->right->right, translator, startIndex, target);
-            allocateBlock(token->right->left , translator, startIndex, target);
+            allocateScope(token->right->right, translator, startIndex, target);
+            allocateScope(token->right->left , translator, startIndex, target);
           }
         else
-          allocateBlock(token->right, translator, startIndex, target);
+          allocateScope(token->right, translator, startIndex, target);
         break;
       case db::STATEMENT_WHILE:
-        allocateBlock(token->right, translator, startIndex, target);
+        allocateScope(token->right, translator, startIndex, target);
         break;
       case db::STATEMENT_VAL: case db::STATEMENT_VAR:
         {
-          fprintf(target,
-                  ";Allocate local var/val\n"
-                  ";%d_%s [%d+%s]\n"
-                  ";%d_%s [%d+%s]\n",
-                  blockNumber, NAME(token->left),
-                  startIndex+STACK_MEMORY_START+variableCount*2,
-                  STACK_POINTER_ADDRESS,
-                  blockNumber, NAME(token->left),
-                  startIndex+STACK_MEMORY_START+variableCount*2+1,
-                  STACK_POINTER_ADDRESS);
-
-          ++variableCount;
+          NOTE("Allocate local var/val of block", IMM(blockNumber));
+          NOTE(NAME(token->left),
+               MEM(startIndex+STACK_MEMORY_START+translator->status.variableCount,
+                   STACK_POINTER_ADDRESS));
+
+          // Integral local has only int word, see translateVariable
+          translator->status.variableCount +=
+            (db::isIntegerDeclaration(&translator->status.integers, token) ? 1 : 2);
+
+          if (translator->status.variableCount > translator->status.maxVariableCount)
+            translator->status.maxVariableCount = translator->status.variableCount;
 
           break;
         }
       default: break;
       }
 
-  return variableCount;
+  return translator->status.variableCount;
 }
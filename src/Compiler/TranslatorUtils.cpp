@@ -56,8 +56,12 @@ void db::getTranslator(
 
   translator->status.sourceName = sourceName;
 
+  FILE *source = openStream(sourceName, "r");
+  if (!source) ERROR();
+
   char *buffer = nullptr;
-  readFile(&buffer, sourceName);
+  readStream(&buffer, source);
+  closeStream(source);
   if (!buffer) ERROR();
 
   int hasError = 0;
@@ -246,15 +250,15 @@ bool db::addVariable(
 
   bool isGlobal = (stack_size(&translator->varTables) == 1);
 
-  static int countOfGlobal = 0;
-
+  // Table of globals contains only them, so they are numbered by it
   table->table
-    [table->size++] = {
+    [table->size] = {
     .name    = name,
-    .number  = isGlobal ? countOfGlobal++ : number,
+    .number  = isGlobal ? (int)table->size : number,
     .isConst = isConst,
     .isGlobal = isGlobal
   };
+  ++table->size;
 
   return true;
 }
@@ -8,14 +8,14 @@
 #include "SystemLike.h"
 #include "ErrorHandler.h"
 #include "GarbageCollector.h"
-#include "StringsUtils.h"
+#include "Fiofunctions.h"
 #include "Assert.h"
 
 #define HANDLE_IF(name, handler)                    \
   if (!strcmp(argv[i], FLAGS[name]))                \
     do                                              \
       {                                             \
-        if (++i < argc && argv[i][0] != '-')        \
+        if (++i < argc && isArgument(argv[i]))      \
           {                                         \
             int error = handler(argv[i], settings); \
                                                     \
@@ -52,7 +52,8 @@
     {                                                              \
       if (!settings->type)                                         \
         {                                                          \
-          settings->type = addDirectory(name);                     \
+          settings->type = (isStandardStream(name) ?               \
+                            strdup(name) : addDirectory(name));    \
                                                                    \
           /*addElementForFree(settings->type);*/                   \
         }                                                          \
@@ -67,6 +68,14 @@ enum Flags {
   LOAD,
   SAVE,
   HELP,
+  CACHE,
+  BINARY,
+  PACKED,
+  PASSES,
+  OPTIMIZATION,
+  OBJECT,
+  LISTING,
+  THREADS,
 };
 
 /// Type of indefity console flags
@@ -74,10 +83,24 @@ const char *FLAGS[] = {
   "-load",
   "-save",
   "-help",
+  "-cache",
+  "-binary",
+  "-packed",
+  "-passes",
+  "-O",
+  "-object",
+  "-listing",
+  "-threads",
 };
 
 const int DEFAULT_GROWTH_FACTOR = 2;
 
+/// Check that string is argument of flag, not the next flag
+/// @param [in] argument Console argument
+/// @return Is it argument
+/// @note "-" is argument too, it means stdin/stdout
+static bool isArgument(const char *argument);
+
 static bool setDefaultSettings(Settings *settings);
 
 /// Handle flag -in
@@ -90,6 +113,31 @@ static int handleLoad(const char *argument, Settings *settings);
 /// @return Error`s code
 static int handleSave(const char *argument, Settings *settings);
 
+/// Handle flag -cache
+/// @param [in] argument File name of cache, may not exist
+/// @return Error`s code
+static int handleCache(const char *argument, Settings *settings);
+
+/// Handle flag -passes, argument may be joined to flag by =
+/// @param [in] argument Pipeline of MiddleEnd like "fold,[const,pure],dce"
+/// @return Error`s code
+static int handlePasses(const char *argument, Settings *settings);
+
+/// Handle flags -O0, -O1 and -O2
+/// @param [in] flag Flag with level
+/// @return Error`s code
+static int handleOptimization(const char *flag, Settings *settings);
+
+/// Handle flag -listing
+/// @param [in] argument File name of listing of binary
+/// @return Error`s code
+static int handleListing(const char *argument, Settings *settings);
+
+/// Handle flag -threads
+/// @param [in] argument Count of threads, 0 is count of processors
+/// @return Error`s code
+static int handleThreads(const char *argument, Settings *settings);
+
 static int handleHelp(Settings *settings);
 
 /// Handle incorrect arguments for flags
@@ -124,7 +172,28 @@ int parseConsoleArgs(const int argc, const char * const argv[], Settings *settin
         }
       ELSE_HANDLE_IF(LOAD, handleLoad);
       ELSE_HANDLE_IF(SAVE, handleSave);
-      else if (argv[i][0] == '-')
+      ELSE_HANDLE_IF(CACHE, handleCache);
+      ELSE_HANDLE_IF(PASSES, handlePasses);
+      ELSE_HANDLE_IF(LISTING, handleListing);
+      ELSE_HANDLE_IF(THREADS, handleThreads);
+      else if (!strncmp(argv[i], FLAGS[PASSES], strlen(FLAGS[PASSES])) &&
+               argv[i][strlen(FLAGS[PASSES])] == '=')
+        {
+          int error = handlePasses(argv[i] + strlen(FLAGS[PASSES]) + 1, settings);
+          if (error) return error;
+        }
+      else if (!strncmp(argv[i], FLAGS[OPTIMIZATION], strlen(FLAGS[OPTIMIZATION])))
+        {
+          int error = handleOptimization(argv[i], settings);
+          if (error) return error;
+        }
+      else if (!strcmp(argv[i], FLAGS[BINARY]))
+        settings->isBinary = true;
+      else if (!strcmp(argv[i], FLAGS[PACKED]))
+        settings->isBinary = settings->isPacked = true;
+      else if (!strcmp(argv[i], FLAGS[OBJECT]))
+        settings->isObject = true;
+      else if (!isArgument(argv[i]))
           handleUnknownFlag(argv[i]);
       else
         {
@@ -149,12 +218,34 @@ static bool setDefaultSettings(Settings *settings)
   settings->programName  = nullptr;
   settings->source       = nullptr;
   settings->target       = nullptr;
+  settings->cache        = nullptr;
+  settings->passes       = nullptr;
+  settings->listing      = nullptr;
+  settings->optimizationLevel = DEFAULT_OPTIMIZATION_LEVEL;
+  settings->threadCount  = DEFAULT_THREAD_COUNT;
+  settings->isBinary     = false;
+  settings->isPacked     = false;
+  settings->isObject     = false;
 
   return 0;
 }
 
+static bool isArgument(const char *argument)
+{
+  assert(argument);
+
+  return argument[0] != '-' || isStandardStream(argument);
+}
+
 static int handleLoad(const char *argument, Settings *settings)
 {
+  if (isStandardStream(argument))
+    {
+      HANDLE_FILE_NAME(argument, source);
+
+      return 0;
+    }
+
   char *fileName = addDirectory(argument);
 
   if (!isFileExists(fileName))
@@ -180,6 +271,73 @@ static int handleSave(const char *argument, Settings *settings)
   return 0;
 }
 
+static int handleCache(const char *argument, Settings *settings)
+{
+  HANDLE_FILE_NAME(argument, cache);
+
+  return 0;
+}
+
+static int handleListing(const char *argument, Settings *settings)
+{
+  HANDLE_FILE_NAME(argument, listing);
+
+  return 0;
+}
+
+static int handleThreads(const char *argument, Settings *settings)
+{
+  assert(argument);
+
+  int count = 0;
+  int length = 0;
+
+  if (sscanf(argument, "%d%n", &count, &length) != 1 || argument[length] || count < 0)
+    {
+      handleIncorrectArgument(FLAGS[THREADS], argument);
+
+      return CONSOLE_INCORRECT_ARGUMENTS;
+    }
+
+  settings->threadCount = count;
+
+  return 0;
+}
+
+static int handlePasses(const char *argument, Settings *settings)
+{
+  assert(argument);
+
+  if (settings->passes)
+    {
+      handleWarning("Too many pipelines of passes [%s]", argument);
+      return 0;
+    }
+
+  settings->passes = strdup(argument);
+
+  return settings->passes ? 0 : CONSOLE_UNEXPECTED_ERROR;
+}
+
+static int handleOptimization(const char *flag, Settings *settings)
+{
+  assert(flag);
+
+  const char *level = flag + strlen(FLAGS[OPTIMIZATION]);
+
+  if (!isdigit(level[0]) || level[1] || level[0] - '0' > MAX_OPTIMIZATION_LEVEL)
+    {
+      handleError("Unknown level of optimizations [%s], expected -O0..-O%d",
+                  flag, MAX_OPTIMIZATION_LEVEL);
+
+      return CONSOLE_INCORRECT_ARGUMENTS;
+    }
+
+  settings->optimizationLevel = level[0] - '0';
+
+  return 0;
+}
+
 static int handleHelp(Settings *settings)
 {
   db::ResourceBundle bundle{};
@@ -49,13 +49,13 @@ static void handleMessage(const char *message, va_list args, const char *color,
   if (!message)
     message = "MESSAGE CORRUPTED!!";
 
-  printf("%s", color);
+  fprintf(stderr, "%s", color);
 
-  printf("%s: ", settings.programName);
+  fprintf(stderr, "%s: ", settings.programName);
 
-  printf("%s: ", prefix);
+  fprintf(stderr, "%s: ", prefix);
 
-  vprintf(message, args);
+  vfprintf(stderr, message, args);
 
-  printf("\n" RESET);
+  fprintf(stderr, "\n" RESET);
 }
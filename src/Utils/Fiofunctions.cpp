@@ -2,9 +2,12 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "SystemLike.h"
 #include "Assert.h"
 
+const size_t STREAM_BUFFER_SIZE = 4096;
+
 size_t readFile(char **buffer, const char *filename)
 {
   if (!isPointerCorrect(buffer) || !isPointerReadCorrect(filename))
@@ -41,6 +44,70 @@ size_t readFile(char **buffer, const char *filename)
   return size;
 }
 
+size_t readStream(char **buffer, FILE *stream)
+{
+  if (!isPointerCorrect(buffer) || !isPointerCorrect(stream))
+    return (size_t)FIOFUNCTIONS_INCORRECT_ARGUMENTS;
+
+  size_t capacity = STREAM_BUFFER_SIZE;
+  size_t size     = 0;
+
+  *buffer = (char *)calloc(capacity + 1, sizeof(char));
+
+  if (!isPointerCorrect(*buffer))
+    return (size_t)FIOFUNCTIONS_OUT_OF_MEM;
+
+  size_t count = 0;
+  while ((count = fread(*buffer + size, sizeof(char), capacity - size, stream)) > 0)
+    {
+      size += count;
+
+      if (size < capacity) continue;
+
+      capacity *= 2;
+      char *temp = (char *)recalloc(*buffer, capacity + 1, sizeof(char));
+
+      if (!isPointerCorrect(temp))
+        {
+          free(*buffer);
+
+          return (size_t)FIOFUNCTIONS_OUT_OF_MEM;
+        }
+
+      *buffer = temp;
+    }
+
+  (*buffer)[size] = '\0';
+
+  return size;
+}
+
+bool isStandardStream(const char *fileName)
+{
+  return fileName && !strcmp(fileName, STANDARD_STREAM_NAME);
+}
+
+FILE *openStream(const char *fileName, const char *mode)
+{
+  assert(fileName);
+  assert(mode);
+
+  if (isStandardStream(fileName))
+    return (*mode == 'r' ? stdin : stdout);
+
+  return fopen(fileName, mode);
+}
+
+void closeStream(FILE *stream)
+{
+  if (!stream) return;
+
+  if (stream == stdin || stream == stdout)
+    fflush(stream);
+  else
+    fclose(stream);
+}
+
 size_t readBin(void *buffer, size_t elementSize, size_t size, FILE *filePtr)
 {
   assert(buffer);
@@ -23,6 +23,9 @@ static void destroySettings()
 {
   if (GlobalSettings.source) free(GlobalSettings.source);
   if (GlobalSettings.target) free(GlobalSettings.target);
+  if (GlobalSettings.cache ) free(GlobalSettings.cache );
+  if (GlobalSettings.passes) free(GlobalSettings.passes);
+  if (GlobalSettings.listing) free(GlobalSettings.listing);
 }
 
 void setSettings(const Settings *settings)